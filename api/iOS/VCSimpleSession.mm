@@ -32,6 +32,8 @@
 #include <videocore/transforms/Split.h>
 #include <videocore/transforms/AspectTransform.h>
 #include <videocore/transforms/PositionTransform.h>
+#include <videocore/stream/AdaptationLadder.h>
+#include <videocore/stream/BitrateAllocator.h>
 
 #ifdef __APPLE__
 #   include <videocore/mixers/Apple/AudioMixer.h>
@@ -59,6 +61,15 @@
 
 
 static const int kMinVideoBitrate = 32000;
+static const int kMinAudioBitrate = 80000;
+static const int kMaxAudioBitrate = 128000;
+
+// Audio's share of the bandwidth above the minimums, against 1 for video.
+static const double kAudioBitrateWeight = 0.2;
+
+// Bytes of FLV tag header ahead of each encoded frame: 5 for video plus the NAL length, 2 for AAC.
+static const int kVideoTagHeaderBytes = 9;
+static const int kAudioTagHeaderBytes = 2;
 
 namespace videocore { namespace simpleApi {
 
@@ -114,6 +125,11 @@ namespace videocore { namespace simpleApi {
 
     std::shared_ptr<videocore::IOutputSession> m_outputSession;
 
+    std::unique_ptr<videocore::AdaptationLadder> m_adaptationLadder;
+    std::unique_ptr<videocore::BitrateAllocator> m_bitrateAllocator;
+    size_t m_videoAllocation;
+    size_t m_audioAllocation;
+
 
     // properties
 
@@ -149,6 +165,7 @@ namespace videocore { namespace simpleApi {
 @property (nonatomic, readwrite) VCSessionState rtmpSessionState;
 
 - (void) setupGraph;
+- (void) applyAdaptationRung: (const videocore::AdaptationRung&) rung;
 
 @end
 
@@ -594,38 +611,31 @@ namespace videocore { namespace simpleApi {
                                                   }
 
 
-                                                  int videoBr = 0;
-
-                                                  if(vector != 0) {
+                                                  if(vector != 0 && bSelf->m_bitrateAllocator) {
 
-                                                      vector = vector < 0 ? -1 : 1 ;
+                                                      auto& allocator = bSelf->m_bitrateAllocator;
+                                                      auto& ladder = bSelf->m_adaptationLadder;
+                                                      auto rtmp = std::dynamic_pointer_cast<videocore::RTMPSession>( bSelf->m_outputSession );
+                                                      if(rtmp) {
+                                                          allocator->setChunkSize(rtmp->outChunkSize());
+                                                      }
 
-                                                      videoBr = video->bitrate();
+                                                      std::vector<int> current(2);
+                                                      current[bSelf->m_videoAllocation] = video->bitrate();
+                                                      current[bSelf->m_audioAllocation] = audio->bitrate();
+                                                      const int bandwidth = allocator->targetBandwidth(vector, predicted, current);
 
-                                                      if (audio) {
+                                                      auto bitrates = allocator->allocate(bandwidth);
 
-                                                          if ( videoBr > 500000 ) {
-                                                              audio->setBitrate(128000);
-                                                          } else if (videoBr <= 500000 && videoBr > 250000) {
-                                                              audio->setBitrate(96000);
-                                                          } else {
-                                                              audio->setBitrate(80000);
-                                                          }
+                                                      // The video range is the current format's, so the ladder sees the bitrate push
+                                                      // against one end of it before it changes format.
+                                                      if(ladder && ladder->update(vector, bitrates[bSelf->m_videoAllocation])) {
+                                                          [bSelf applyAdaptationRung:ladder->rung()];
+                                                          bitrates = allocator->allocate(bandwidth);
                                                       }
+                                                      video->setBitrate(bitrates[bSelf->m_videoAllocation]);
+                                                      audio->setBitrate(bitrates[bSelf->m_audioAllocation]);
 
-
-                                                      if(videoBr > 1152000) {
-                                                          video->setBitrate(std::min(int((videoBr / 384000 + vector )) * 384000, bSelf->_bpsCeiling) );
-                                                      }
-                                                      else if( videoBr > 512000 ) {
-                                                          video->setBitrate(std::min(int((videoBr / 128000 + vector )) * 128000, bSelf->_bpsCeiling) );
-                                                      }
-                                                      else if( videoBr > 128000 ) {
-                                                          video->setBitrate(std::min(int((videoBr / 64000 + vector )) * 64000, bSelf->_bpsCeiling) );
-                                                      }
-                                                      else {
-                                                          video->setBitrate(std::max(std::min(int((videoBr / 32000 + vector )) * 32000, bSelf->_bpsCeiling), kMinVideoBitrate) );
-                                                      }
                                                       DLog("\n(%f) AudioBR: %d VideoBR: %d (%f)\n", vector, audio->bitrate(), video->bitrate(), predicted);
                                                   } /* if(vector != 0) */
 
@@ -634,6 +644,13 @@ namespace videocore { namespace simpleApi {
 
                                           });
 
+    m_outputSession->setKeyframeRequestCallback([=]() {
+        auto video = std::dynamic_pointer_cast<videocore::IEncoder>( bSelf->m_h264Encoder );
+        if(video) {
+            video->requestKeyframe();
+        }
+    });
+
     videocore::RTMPSessionParameters_t sp ( 0. );
 
     sp.setData(self.videoSize.width,
@@ -655,11 +672,32 @@ namespace videocore { namespace simpleApi {
     m_aacEncoder.reset();
 
     m_outputSession.reset();
+    m_adaptationLadder.reset();
+    m_bitrateAllocator.reset();
 
     _bitrate = _bpsCeiling;
 
     self.rtmpSessionState = VCSessionStateEnded;
 }
+- (void) applyAdaptationRung: (const videocore::AdaptationRung&) rung
+{
+    auto video = std::dynamic_pointer_cast<videocore::IEncoder>( m_h264Encoder );
+    auto mixer = std::dynamic_pointer_cast<videocore::iOS::GLESVideoMixer>( m_videoMixer );
+
+    DLog("Adaptation: %dx%d @ %d fps\n", rung.width, rung.height, rung.fps);
+
+    // The encoder starts the new format with a keyframe, which the packetizer sends with a new sequence header
+    // and onMetaData; the RTMP session carries on.
+    if(video) {
+        video->setVideoFormat(rung.width, rung.height, rung.fps);
+    }
+    if(mixer) {
+        mixer->setFrameDuration(1. / static_cast<double>(rung.fps));
+    }
+    if(m_bitrateAllocator) {
+        m_bitrateAllocator->setStreamRange(m_videoAllocation, std::max(rung.minBitrate, kMinVideoBitrate), rung.maxBitrate);
+    }
+}
 - (void) getCameraPreviewLayer:(AVCaptureVideoPreviewLayer **)previewLayer {
     if(m_cameraSource) {
         m_cameraSource->getPreviewLayer((void**)previewLayer);
@@ -813,11 +851,31 @@ namespace videocore { namespace simpleApi {
 
         m_aacEncoder = std::make_shared<videocore::iOS::AACEncode>(self.audioSampleRate, self.audioChannelCount, 96000);
         if(SYSTEM_VERSION_GREATER_THAN_OR_EQUAL_TO(@"8.0")) {
+            int width = self.videoSize.width;
+            int height = self.videoSize.height;
+            int fps = self.fps;
+            int bitrate = self.bitrate;
+
+            if(self.useAdaptiveBitrate) {
+                // VideoToolbox scales the mixer's frames to the session size, so the format can follow the bandwidth.
+                m_adaptationLadder.reset(new videocore::AdaptationLadder(videocore::AdaptationLadder::defaultRungs(width, height, fps, _bpsCeiling),
+                                                                         bitrate));
+                const auto& rung = m_adaptationLadder->rung();
+                width = rung.width;
+                height = rung.height;
+                fps = rung.fps;
+                bitrate = std::max(m_adaptationLadder->clampBitrate(bitrate), kMinVideoBitrate);
+
+                auto mixer = std::dynamic_pointer_cast<videocore::iOS::GLESVideoMixer>(m_videoMixer);
+                if(mixer) {
+                    mixer->setFrameDuration(1. / fps);
+                }
+            }
             // If >= iOS 8.0 use the VideoToolbox encoder that does not write to disk.
-            m_h264Encoder = std::make_shared<videocore::Apple::H264Encode>(self.videoSize.width,
-                                                                           self.videoSize.height,
-                                                                           self.fps,
-                                                                           self.bitrate,
+            m_h264Encoder = std::make_shared<videocore::Apple::H264Encode>(width,
+                                                                           height,
+                                                                           fps,
+                                                                           bitrate,
                                                                            false,
                                                                            ctsOffset);
         } else {
@@ -830,6 +888,20 @@ namespace videocore { namespace simpleApi {
         m_videoSplit->setOutput(m_h264Encoder);
 
     }
+    {
+        // Splits the bandwidth estimate between the encoders when adapting the bitrate.
+        videocore::BitrateStream video = { kMinVideoBitrate, _bpsCeiling, 1., double(self.fps), kVideoTagHeaderBytes };
+        videocore::BitrateStream audio = { kMinAudioBitrate, kMaxAudioBitrate, kAudioBitrateWeight, self.audioSampleRate / 1024., kAudioTagHeaderBytes };
+
+        m_bitrateAllocator.reset(new videocore::BitrateAllocator(kRTMPDefaultChunkSize));
+        m_videoAllocation = m_bitrateAllocator->addStream(video);
+        m_audioAllocation = m_bitrateAllocator->addStream(audio);
+
+        if(m_adaptationLadder) {
+            const auto& rung = m_adaptationLadder->rung();
+            m_bitrateAllocator->setStreamRange(m_videoAllocation, std::max(rung.minBitrate, kMinVideoBitrate), rung.maxBitrate);
+        }
+    }
     {
         m_aacSplit = std::make_shared<videocore::Split>();
         m_h264Split = std::make_shared<videocore::Split>();
@@ -838,12 +910,33 @@ namespace videocore { namespace simpleApi {
 
     }
     {
-        m_h264Packetizer = std::make_shared<videocore::rtmp::H264Packetizer>(ctsOffset);
+        auto h264Packetizer = std::make_shared<videocore::rtmp::H264Packetizer>(ctsOffset);
+        m_h264Packetizer = h264Packetizer;
         m_aacPacketizer = std::make_shared<videocore::rtmp::AACPacketizer>(self.audioSampleRate, self.audioChannelCount, ctsOffset);
 
         m_h264Split->setOutput(m_h264Packetizer);
         m_aacSplit->setOutput(m_aacPacketizer);
 
+        // Keep onMetaData in step with what the encoder actually produces.
+        VCSimpleSession* bSelf = self;
+        h264Packetizer->setVideoFormatCallback([=](const videocore::h264::SequenceParameterSet& sps) {
+            auto video = std::dynamic_pointer_cast<videocore::IEncoder>( bSelf->m_h264Encoder );
+            const auto& ladder = bSelf->m_adaptationLadder;
+            const double frameRate = sps.frameRate() > 0. ? sps.frameRate() : (ladder ? ladder->rung().fps : bSelf.fps);
+
+            videocore::RTMPSessionParameters_t sp ( 0. );
+            sp.setData(sps.width,
+                       sps.height,
+                       1. / frameRate,
+                       video ? video->bitrate() : bSelf.bitrate,
+                       bSelf.audioSampleRate,
+                       (bSelf.audioChannelCount == 2));
+
+            if(bSelf->m_outputSession) {
+                bSelf->m_outputSession->setSessionParameters(sp);
+            }
+        });
+
     }
     {
         /*m_muxer = std::make_shared<videocore::Apple::MP4Multiplexer>();
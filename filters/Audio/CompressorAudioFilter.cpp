@@ -0,0 +1,79 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/filters/Audio/CompressorAudioFilter.h>
+#include <videocore/system/Simd.hpp>
+#include <videocore/system/audio/GainKernels.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace videocore { namespace filters {
+
+    CompressorAudioFilter::CompressorAudioFilter(float thresholdInDb, float ratio, float attack, float release, float makeupInDb)
+    : IAudioFilter(),
+    m_threshold(thresholdInDb),
+    m_attack(attack),
+    m_release(release),
+    m_makeup(makeupInDb),
+    m_sampleRate(0),
+    m_envelope(0.f),
+    m_gain(1.f)
+    {
+        setRatio(ratio);
+    }
+
+    void
+    CompressorAudioFilter::process(float* VC_RESTRICT samples, size_t frameCount, int channelCount, int sampleRate)
+    {
+        if(sampleRate != m_sampleRate) {
+            // One-pole coefficients evaluated at the control rate.
+            const float controlRate = float(sampleRate) / float(kControlFrames);
+            m_attackCoeff  = expf(-1.f / std::max(1e-4f, m_attack * controlRate));
+            m_releaseCoeff = expf(-1.f / std::max(1e-4f, m_release * controlRate));
+            m_sampleRate = sampleRate;
+        }
+
+        for ( size_t frame = 0 ; frame < frameCount ; frame += kControlFrames ) {
+            const size_t count = std::min(kControlFrames, frameCount - frame);
+            float* VC_RESTRICT block = samples + frame * channelCount;
+            const size_t sampleCount = count * channelCount;
+
+            const float peak = audio::peak(block, sampleCount);
+
+            const float coeff = peak > m_envelope ? m_attackCoeff : m_releaseCoeff;
+            m_envelope = peak + coeff * (m_envelope - peak);
+
+            const float levelInDb = 20.f * log10f(std::max(m_envelope, 1e-6f));
+            const float reductionInDb = std::max(0.f, levelInDb - m_threshold) * m_slope;
+            const float target = powf(10.f, (m_makeup - reductionInDb) / 20.f);
+
+            // Interpolate from the previous control point to avoid steps in the gain.
+            audio::applyGainRamp(block, count, channelCount, m_gain, (target - m_gain) / float(count));
+            m_gain = target;
+        }
+    }
+}
+}
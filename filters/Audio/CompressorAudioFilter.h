@@ -0,0 +1,86 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_CompressorAudioFilter_h
+#define videocore_CompressorAudioFilter_h
+
+#include <videocore/filters/IAudioFilter.hpp>
+#include <algorithm>
+
+namespace videocore {
+    namespace filters {
+        /*!
+         *  Feed-forward peak compressor with channel-linked detection.  The gain computer runs once per
+         *  kControlFrames frames and the gain is interpolated linearly in between, which keeps the per-sample
+         *  work to a multiply.
+         */
+        class CompressorAudioFilter : public IAudioFilter {
+
+        public:
+            /*!
+             *  \param thresholdInDb  The level, in dBFS, above which gain reduction starts.
+             *  \param ratio          The compression ratio (e.g. 4 for 4:1).
+             *  \param attack         Attack time in seconds.
+             *  \param release        Release time in seconds.
+             *  \param makeupInDb     Gain applied after compression.
+             */
+            CompressorAudioFilter(float thresholdInDb = -18.f,
+                                  float ratio = 4.f,
+                                  float attack = 0.005f,
+                                  float release = 0.1f,
+                                  float makeupInDb = 0.f);
+            ~CompressorAudioFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.audio.compressor"; };
+
+            void process(float* samples, size_t frameCount, int channelCount, int sampleRate);
+
+        public:
+            void setThreshold(float thresholdInDb) { m_threshold = thresholdInDb; };
+            void setRatio(float ratio) { m_slope = 1.f - 1.f / std::max(1.f, ratio); };
+            void setMakeupGain(float makeupInDb) { m_makeup = makeupInDb; };
+
+        private:
+            static const size_t kControlFrames = 32;
+
+        private:
+            float m_threshold;
+            float m_slope;
+            float m_attack;
+            float m_release;
+            float m_makeup;
+
+            float m_attackCoeff;
+            float m_releaseCoeff;
+            int   m_sampleRate;
+
+            float m_envelope;
+            float m_gain;
+        };
+    }
+}
+
+#endif /* defined(videocore_CompressorAudioFilter_h) */
@@ -0,0 +1,65 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/filters/Audio/GainRampAudioFilter.h>
+#include <videocore/system/Simd.hpp>
+#include <videocore/system/audio/GainKernels.h>
+
+#include <algorithm>
+
+namespace videocore { namespace filters {
+
+    GainRampAudioFilter::GainRampAudioFilter(float gain, float rampDuration)
+    : IAudioFilter(), m_targetGain(gain), m_rampTarget(gain), m_currentGain(gain), m_step(0.f), m_rampFramesLeft(0), m_rampDuration(rampDuration)
+    {
+    }
+
+    void
+    GainRampAudioFilter::process(float* VC_RESTRICT samples, size_t frameCount, int channelCount, int sampleRate)
+    {
+        const float target = m_targetGain.load(std::memory_order_relaxed);
+        size_t frame = 0;
+
+        if(target != m_rampTarget) {
+            // (Re)start the ramp from wherever the gain currently is.
+            m_rampTarget = target;
+            m_rampFramesLeft = std::max<size_t>(1, size_t(m_rampDuration * sampleRate));
+            m_step = (target - m_currentGain) / float(m_rampFramesLeft);
+        }
+        if(m_rampFramesLeft) {
+            const size_t count = std::min(frameCount, m_rampFramesLeft);
+            audio::applyGainRamp(samples, count, channelCount, m_currentGain, m_step);
+            frame = count;
+            m_rampFramesLeft -= count;
+            m_currentGain = m_rampFramesLeft ? m_currentGain + float(count) * m_step : m_rampTarget;
+        }
+
+        const float g = m_currentGain;
+        if(g != 1.f) {
+            audio::applyGain(samples + frame * channelCount, (frameCount - frame) * channelCount, g);
+        }
+    }
+}
+}
@@ -0,0 +1,69 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_GainRampAudioFilter_h
+#define videocore_GainRampAudioFilter_h
+
+#include <videocore/filters/IAudioFilter.hpp>
+#include <atomic>
+
+namespace videocore {
+    namespace filters {
+        /*!
+         *  Applies a gain that moves linearly to its target over a fixed ramp time instead of jumping, so gain
+         *  changes do not produce zipper noise.
+         */
+        class GainRampAudioFilter : public IAudioFilter {
+
+        public:
+            /*!
+             *  \param gain          The initial linear gain.
+             *  \param rampDuration  The time, in seconds, taken to reach a new target gain.
+             */
+            GainRampAudioFilter(float gain = 1.f, float rampDuration = 0.02f);
+            ~GainRampAudioFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.audio.gainramp"; };
+
+            void process(float* samples, size_t frameCount, int channelCount, int sampleRate);
+
+        public:
+            /*! Set the target linear gain.  Safe to call from any thread. */
+            void setGain(float gain) { m_targetGain = gain; };
+            float gain() const { return m_targetGain; };
+
+        private:
+            std::atomic<float> m_targetGain;
+            float  m_rampTarget;
+            float  m_currentGain;
+            float  m_step;
+            size_t m_rampFramesLeft;
+            float  m_rampDuration;
+        };
+    }
+}
+
+#endif /* defined(videocore_GainRampAudioFilter_h) */
@@ -0,0 +1,223 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/filters/Audio/HighPassAudioFilter.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videocore { namespace filters {
+
+    HighPassAudioFilter::HighPassAudioFilter(float cutoffInHz)
+    : IAudioFilter(), m_b0(1.f), m_b1(0.f), m_b2(0.f), m_a1(0.f), m_a2(0.f), m_cutoff(cutoffInHz), m_sampleRate(0)
+    {
+        memset(m_z1, 0, sizeof(m_z1));
+        memset(m_z2, 0, sizeof(m_z2));
+    }
+
+    void
+    HighPassAudioFilter::computeCoefficients(int sampleRate)
+    {
+        // http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt, Q = 1/sqrt(2)
+        const float w0 = 2.f * float(M_PI) * std::min(m_cutoff, sampleRate * 0.45f) / float(sampleRate);
+        const float cw = cosf(w0);
+        const float alpha = sinf(w0) * 0.70710678118f;
+        const float a0 = 1.f / (1.f + alpha);
+
+        m_b0 = (1.f + cw) * 0.5f * a0;
+        m_b1 = -(1.f + cw) * a0;
+        m_b2 = m_b0;
+        m_a1 = -2.f * cw * a0;
+        m_a2 = (1.f - alpha) * a0;
+        m_sampleRate = sampleRate;
+
+        // The block responses, by running the recursion on unit inputs and unit states.
+        for ( int k = 0 ; k < 6 ; ++k ) {
+            float x[4] = { 0.f, 0.f, 0.f, 0.f };
+            float z1 = (k == 4) ? 1.f : 0.f;
+            float z2 = (k == 5) ? 1.f : 0.f;
+            float* y = k < 4 ? m_blockX[k] : m_blockZ[k - 4];
+            if(k < 4) {
+                x[k] = 1.f;
+            }
+            for ( int n = 0 ; n < 4 ; ++n ) {
+                y[n] = m_b0 * x[n] + z1;
+                z1 = m_b1 * x[n] - m_a1 * y[n] + z2;
+                z2 = m_b2 * x[n] - m_a2 * y[n];
+            }
+        }
+    }
+
+#if VC_SIMD_SSE2
+    namespace {
+        struct BlockSSE2 {
+            __m128 x[4], z1, z2, b1, b2, a1, a2;
+        };
+
+        // Four frames of one channel.  z1 and z2 hold the state in every lane.
+        inline __m128
+        processBlock(__m128 x, __m128& z1, __m128& z2, const BlockSSE2& k)
+        {
+            const __m128 fromX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(x, x, 0x00), k.x[0]),
+                                                       _mm_mul_ps(_mm_shuffle_ps(x, x, 0x55), k.x[1])),
+                                            _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(x, x, 0xAA), k.x[2]),
+                                                       _mm_mul_ps(_mm_shuffle_ps(x, x, 0xFF), k.x[3])));
+            const __m128 y = _mm_add_ps(fromX, _mm_add_ps(_mm_mul_ps(z1, k.z1), _mm_mul_ps(z2, k.z2)));
+
+            // The state after the last frame: z1 = b1 x3 - a1 y3 + (b2 x2 - a2 y2), z2 = b2 x3 - a2 y3.
+            const __m128 t = _mm_sub_ps(_mm_mul_ps(k.b1, x), _mm_mul_ps(k.a1, y));
+            const __m128 u = _mm_sub_ps(_mm_mul_ps(k.b2, x), _mm_mul_ps(k.a2, y));
+            z1 = _mm_add_ps(_mm_shuffle_ps(t, t, 0xFF), _mm_shuffle_ps(u, u, 0xAA));
+            z2 = _mm_shuffle_ps(u, u, 0xFF);
+            return y;
+        }
+    }
+#elif VC_SIMD_NEON
+    namespace {
+        struct BlockNEON {
+            float32x4_t x[4], z1, z2, b1, b2, a1, a2;
+        };
+
+        // Four frames of one channel.  z1 and z2 hold the state in every lane.
+        inline float32x4_t
+        processBlock(float32x4_t x, float32x4_t& z1, float32x4_t& z2, const BlockNEON& k)
+        {
+            const float32x2_t lo = vget_low_f32(x), hi = vget_high_f32(x);
+            const float32x4_t fromX = vaddq_f32(vmlaq_lane_f32(vmulq_lane_f32(k.x[0], lo, 0), k.x[1], lo, 1),
+                                                vmlaq_lane_f32(vmulq_lane_f32(k.x[2], hi, 0), k.x[3], hi, 1));
+            const float32x4_t y = vaddq_f32(fromX, vmlaq_f32(vmulq_f32(z1, k.z1), z2, k.z2));
+
+            // The state after the last frame: z1 = b1 x3 - a1 y3 + (b2 x2 - a2 y2), z2 = b2 x3 - a2 y3.
+            const float32x4_t t = vmlsq_f32(vmulq_f32(k.b1, x), k.a1, y);
+            const float32x4_t u = vmlsq_f32(vmulq_f32(k.b2, x), k.a2, y);
+            z1 = vaddq_f32(vdupq_lane_f32(vget_high_f32(t), 1), vdupq_lane_f32(vget_high_f32(u), 0));
+            z2 = vdupq_lane_f32(vget_high_f32(u), 1);
+            return y;
+        }
+    }
+#endif
+
+    void
+    HighPassAudioFilter::process(float* VC_RESTRICT samples, size_t frameCount, int channelCount, int sampleRate)
+    {
+        if(sampleRate != m_sampleRate) {
+            computeCoefficients(sampleRate);
+        }
+        const float b0 = m_b0, b1 = m_b1, b2 = m_b2, a1 = m_a1, a2 = m_a2;
+
+        // State is kept in locals so the channel loop can stay in registers.
+        float z1[audio::kMaxAudioChannels];
+        float z2[audio::kMaxAudioChannels];
+        memcpy(z1, m_z1, sizeof(z1));
+        memcpy(z2, m_z2, sizeof(z2));
+
+        size_t i = 0;
+
+#if VC_SIMD_SSE2
+        if(channelCount <= 2) {
+            BlockSSE2 k;
+            for ( int n = 0 ; n < 4 ; ++n ) {
+                k.x[n] = _mm_loadu_ps(m_blockX[n]);
+            }
+            k.z1 = _mm_loadu_ps(m_blockZ[0]);
+            k.z2 = _mm_loadu_ps(m_blockZ[1]);
+            k.b1 = _mm_set1_ps(b1);
+            k.b2 = _mm_set1_ps(b2);
+            k.a1 = _mm_set1_ps(a1);
+            k.a2 = _mm_set1_ps(a2);
+
+            __m128 lz1 = _mm_set1_ps(z1[0]), lz2 = _mm_set1_ps(z2[0]);
+            if(channelCount == 1) {
+                for ( ; i + 4 <= frameCount ; i += 4 ) {
+                    _mm_storeu_ps(samples + i, processBlock(_mm_loadu_ps(samples + i), lz1, lz2, k));
+                }
+            } else {
+                // The two channels' blocks are independent, so their latencies overlap.
+                __m128 rz1 = _mm_set1_ps(z1[1]), rz2 = _mm_set1_ps(z2[1]);
+                for ( ; i + 4 <= frameCount ; i += 4 ) {
+                    const __m128 a = _mm_loadu_ps(samples + i * 2);
+                    const __m128 b = _mm_loadu_ps(samples + i * 2 + 4);
+                    const __m128 l = processBlock(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), lz1, lz2, k);
+                    const __m128 r = processBlock(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), rz1, rz2, k);
+                    _mm_storeu_ps(samples + i * 2,     _mm_unpacklo_ps(l, r));
+                    _mm_storeu_ps(samples + i * 2 + 4, _mm_unpackhi_ps(l, r));
+                }
+                z1[1] = _mm_cvtss_f32(rz1);
+                z2[1] = _mm_cvtss_f32(rz2);
+            }
+            z1[0] = _mm_cvtss_f32(lz1);
+            z2[0] = _mm_cvtss_f32(lz2);
+        }
+#elif VC_SIMD_NEON
+        if(channelCount <= 2) {
+            BlockNEON k;
+            for ( int n = 0 ; n < 4 ; ++n ) {
+                k.x[n] = vld1q_f32(m_blockX[n]);
+            }
+            k.z1 = vld1q_f32(m_blockZ[0]);
+            k.z2 = vld1q_f32(m_blockZ[1]);
+            k.b1 = vdupq_n_f32(b1);
+            k.b2 = vdupq_n_f32(b2);
+            k.a1 = vdupq_n_f32(a1);
+            k.a2 = vdupq_n_f32(a2);
+
+            float32x4_t lz1 = vdupq_n_f32(z1[0]), lz2 = vdupq_n_f32(z2[0]);
+            if(channelCount == 1) {
+                for ( ; i + 4 <= frameCount ; i += 4 ) {
+                    vst1q_f32(samples + i, processBlock(vld1q_f32(samples + i), lz1, lz2, k));
+                }
+            } else {
+                // The two channels' blocks are independent, so their latencies overlap.
+                float32x4_t rz1 = vdupq_n_f32(z1[1]), rz2 = vdupq_n_f32(z2[1]);
+                for ( ; i + 4 <= frameCount ; i += 4 ) {
+                    float32x4x2_t lr = vld2q_f32(samples + i * 2);
+                    lr.val[0] = processBlock(lr.val[0], lz1, lz2, k);
+                    lr.val[1] = processBlock(lr.val[1], rz1, rz2, k);
+                    vst2q_f32(samples + i * 2, lr);
+                }
+                z1[1] = vgetq_lane_f32(rz1, 0);
+                z2[1] = vgetq_lane_f32(rz2, 0);
+            }
+            z1[0] = vgetq_lane_f32(lz1, 0);
+            z2[0] = vgetq_lane_f32(lz2, 0);
+        }
+#endif
+        for ( ; i < frameCount ; ++i ) {
+            float* f = samples + i * channelCount;
+            for ( int c = 0 ; c < channelCount ; ++c ) {
+                const float x = f[c];
+                const float y = b0 * x + z1[c];
+                z1[c] = b1 * x - a1 * y + z2[c];
+                z2[c] = b2 * x - a2 * y;
+                f[c] = y;
+            }
+        }
+        memcpy(m_z1, z1, sizeof(z1));
+        memcpy(m_z2, z2, sizeof(z2));
+    }
+}
+}
@@ -0,0 +1,74 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_HighPassAudioFilter_h
+#define videocore_HighPassAudioFilter_h
+
+#include <videocore/filters/IAudioFilter.hpp>
+#include <videocore/system/audio/ChannelLayout.h>
+
+namespace videocore {
+    namespace filters {
+        /*!
+         *  Second order Butterworth high-pass (RBJ biquad, transposed direct form II).  Removes rumble and
+         *  handling noise below the cutoff.
+         *
+         *  Mono and stereo run four frames of a channel at a time: the recursion is unrolled into a block
+         *  that maps the four inputs and the entering state to the four outputs in a few vector operations.
+         */
+        class HighPassAudioFilter : public IAudioFilter {
+
+        public:
+            /*!
+             *  \param cutoffInHz  The -3dB cutoff frequency.
+             */
+            HighPassAudioFilter(float cutoffInHz = 80.f);
+            ~HighPassAudioFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.audio.highpass"; };
+
+            void process(float* samples, size_t frameCount, int channelCount, int sampleRate);
+
+        public:
+            /*! Change the cutoff.  Takes effect on the next processed block. */
+            void setCutoff(float cutoffInHz) { m_cutoff = cutoffInHz; m_sampleRate = 0; };
+
+        private:
+            void computeCoefficients(int sampleRate);
+
+        private:
+            float m_b0, m_b1, m_b2, m_a1, m_a2;
+            float m_z1[audio::kMaxAudioChannels];
+            float m_z2[audio::kMaxAudioChannels];
+            float m_blockX[4][4];   // m_blockX[k][n]: output n of a block for a unit input at frame k
+            float m_blockZ[2][4];   // m_blockZ[j][n]: output n of a block for a unit z1 (j = 0) or z2 (j = 1)
+            float m_cutoff;
+            int   m_sampleRate;
+        };
+    }
+}
+
+#endif /* defined(videocore_HighPassAudioFilter_h) */
@@ -0,0 +1,118 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/filters/Audio/NoiseGateAudioFilter.h>
+#include <videocore/system/Simd.hpp>
+#include <videocore/system/audio/GainKernels.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace videocore { namespace filters {
+
+    // Frames per pass of the vectorized peak and gain kernels.
+    static const size_t kBlockFrames = 64;
+
+    NoiseGateAudioFilter::NoiseGateAudioFilter(float thresholdInDb, float attack, float hold, float release, float floorInDb)
+    : IAudioFilter(),
+    m_threshold(powf(10.f, thresholdInDb / 20.f)),
+    m_floor(powf(10.f, floorInDb / 20.f)),
+    m_attack(attack),
+    m_hold(hold),
+    m_release(release),
+    m_sampleRate(0),
+    m_gain(0.f),
+    m_holdFramesLeft(0)
+    {
+        m_gain = m_floor;
+    }
+
+    void
+    NoiseGateAudioFilter::setThreshold(float thresholdInDb)
+    {
+        m_threshold = powf(10.f, thresholdInDb / 20.f);
+    }
+
+    void
+    NoiseGateAudioFilter::process(float* VC_RESTRICT samples, size_t frameCount, int channelCount, int sampleRate)
+    {
+        if(sampleRate != m_sampleRate) {
+            m_attackStep  = (1.f - m_floor) / std::max(1.f, m_attack * sampleRate);
+            m_releaseStep = (1.f - m_floor) / std::max(1.f, m_release * sampleRate);
+            m_holdFrames  = size_t(m_hold * sampleRate);
+            m_sampleRate  = sampleRate;
+        }
+        const float threshold   = m_threshold;
+        const float floorGain   = m_floor;
+        const float attackStep  = m_attackStep;
+        const float releaseStep = m_releaseStep;
+        float  gain = m_gain;
+        size_t holdLeft = m_holdFramesLeft;
+
+        // The gate opens whenever the level is above the threshold; hold only delays the release.  Written
+        // without branches: the comparison flips unpredictably on noisy input.
+        auto step = [&](float peak) {
+            const bool above = peak > threshold;
+            const bool open  = above || holdLeft;
+            holdLeft = above ? m_holdFrames : holdLeft - (holdLeft != 0);
+            gain = open ? std::min(1.f, gain + attackStep) : std::max(floorGain, gain - releaseStep);
+            return gain;
+        };
+
+        if(channelCount <= 2) {
+            // Peak detection and the gain multiply are vectorized; only the state machine runs per frame.
+            float peaks[kBlockFrames] VC_ALIGNED(16);
+            float gains[kBlockFrames] VC_ALIGNED(16);
+
+            for ( size_t frame = 0 ; frame < frameCount ; frame += kBlockFrames ) {
+                const size_t count = std::min(kBlockFrames, frameCount - frame);
+                float* VC_RESTRICT block = samples + frame * channelCount;
+
+                audio::framePeaks(block, count, channelCount, peaks);
+                for ( size_t i = 0 ; i < count ; ++i ) {
+                    gains[i] = step(peaks[i]);
+                }
+                audio::applyFrameGains(block, gains, count, channelCount);
+            }
+        } else {
+            // The kernels have no vector path for wider layouts, and two scalar passes are slower than one.
+            for ( size_t i = 0 ; i < frameCount ; ++i ) {
+                float* f = samples + i * channelCount;
+
+                float peak = 0.f;
+                for ( int c = 0 ; c < channelCount ; ++c ) {
+                    peak = std::max(peak, fabsf(f[c]));
+                }
+                const float g = step(peak);
+                for ( int c = 0 ; c < channelCount ; ++c ) {
+                    f[c] *= g;
+                }
+            }
+        }
+        m_gain = gain;
+        m_holdFramesLeft = holdLeft;
+    }
+}
+}
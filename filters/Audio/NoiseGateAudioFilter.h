@@ -0,0 +1,80 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_NoiseGateAudioFilter_h
+#define videocore_NoiseGateAudioFilter_h
+
+#include <videocore/filters/IAudioFilter.hpp>
+
+namespace videocore {
+    namespace filters {
+        /*!
+         *  Attenuates the signal while its level stays below a threshold.  Detection is linked across channels,
+         *  and the gate is held open for a short time after the level drops so word endings are not clipped.
+         */
+        class NoiseGateAudioFilter : public IAudioFilter {
+
+        public:
+            /*!
+             *  \param thresholdInDb  The level, in dBFS, above which the gate opens.
+             *  \param attack         Time, in seconds, to fully open the gate.
+             *  \param hold           Time, in seconds, the gate is held open after the level falls below the threshold.
+             *  \param release        Time, in seconds, to close the gate.
+             *  \param floorInDb      Attenuation applied when the gate is closed.
+             */
+            NoiseGateAudioFilter(float thresholdInDb = -50.f,
+                                 float attack = 0.002f,
+                                 float hold = 0.1f,
+                                 float release = 0.15f,
+                                 float floorInDb = -80.f);
+            ~NoiseGateAudioFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.audio.noisegate"; };
+
+            void process(float* samples, size_t frameCount, int channelCount, int sampleRate);
+
+        public:
+            void setThreshold(float thresholdInDb);
+
+        private:
+            float  m_threshold;
+            float  m_floor;
+            float  m_attack;
+            float  m_hold;
+            float  m_release;
+
+            float  m_attackStep;
+            float  m_releaseStep;
+            size_t m_holdFrames;
+            int    m_sampleRate;
+
+            float  m_gain;
+            size_t m_holdFramesLeft;
+        };
+    }
+}
+
+#endif /* defined(videocore_NoiseGateAudioFilter_h) */
@@ -0,0 +1,56 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/BasicVideoFilterBGRA.h>
+#include <videocore/filters/FilterFactory.h>
+
+#include <string.h>
+
+namespace videocore { namespace filters { namespace CPU {
+
+    bool BasicVideoFilterBGRA::s_registered = BasicVideoFilterBGRA::registerFilter();
+
+    bool
+    BasicVideoFilterBGRA::registerFilter()
+    {
+        FilterFactory::_register("com.videocore.filters.bgra", []() { return new BasicVideoFilterBGRA(); }, kFilterBackendCPU);
+        return true;
+    }
+
+    void
+    BasicVideoFilterBGRA::process(const uint8_t* src, size_t srcStride,
+                                  uint8_t* dst, size_t dstStride,
+                                  int width, int height,
+                                  int rowBegin, int rowEnd,
+                                  bool isRGBA)
+    {
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            memcpy(dst + y * dstStride, src + y * srcStride, width * 4);
+        }
+    }
+}
+}
+}
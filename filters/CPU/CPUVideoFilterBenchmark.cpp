@@ -0,0 +1,104 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Time per 1280x720 BGRA frame of each CPU video filter, run as a single stripe on one thread the way
+ *  GenericVideoMixer runs it when the worker pool has one thread.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with the sources in
+ *  filters/CPU/ and system/image/ and the library's FilterFactory, which the filters register themselves with.
+ */
+
+#include <videocore/filters/CPU/BasicVideoFilterBGRA.h>
+#include <videocore/filters/CPU/FisheyeVideoFilter.h>
+#include <videocore/filters/CPU/GlowVideoFilter.h>
+#include <videocore/filters/CPU/GrayscaleVideoFilter.h>
+#include <videocore/filters/CPU/InvertColorsVideoFilter.h>
+#include <videocore/filters/CPU/SepiaVideoFilter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace videocore;
+using namespace videocore::filters::CPU;
+
+namespace {
+
+    const int kWidth = 1280;
+    const int kHeight = 720;
+    const int kIterations = 50;
+
+    double
+    milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void
+    run(const char* name, ICPUVideoFilter& filter, const std::vector<uint8_t>& src, std::vector<uint8_t>& dst)
+    {
+        const size_t stride = kWidth * 4;
+
+        // The first prepare() builds any per-size tables (fisheye's remap); report it separately.
+        auto start = std::chrono::steady_clock::now();
+        filter.prepare(kWidth, kHeight);
+        const double setup = milliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for ( int i = 0 ; i < kIterations ; ++i ) {
+            filter.prepare(kWidth, kHeight);
+            filter.process(&src[0], stride, &dst[0], stride, kWidth, kHeight, 0, kHeight, false);
+        }
+        printf("%-14s %6.2f ms/frame   first prepare %6.2f ms\n", name, milliseconds(start) / kIterations, setup);
+    }
+}
+
+int
+main()
+{
+    std::vector<uint8_t> src(size_t(kWidth) * kHeight * 4), dst(src.size());
+    for ( size_t i = 0 ; i < src.size() ; ++i ) {
+        src[i] = (i & 3) == 3 ? 255 : uint8_t(i * 7 + (i >> 11));
+    }
+
+    BasicVideoFilterBGRA bgra;
+    GrayscaleVideoFilter grayscale;
+    InvertColorsVideoFilter invert;
+    SepiaVideoFilter sepia;
+    GlowVideoFilter glow;
+    FisheyeVideoFilter fisheye;
+
+    printf("%dx%d BGRA, one thread, %d frames each\n", kWidth, kHeight, kIterations);
+    run("bgra (copy)", bgra, src, dst);
+    run("grayscale", grayscale, src, dst);
+    run("invertColors", invert, src, dst);
+    run("sepia", sepia, src, dst);
+    run("glow", glow, src, dst);
+    run("fisheye", fisheye, src, dst);
+    return 0;
+}
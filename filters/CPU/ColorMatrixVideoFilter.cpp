@@ -1,18 +1,18 @@
 /*
- 
+
  Video Core
  Copyright (c) 2014 James G. Hurley
- 
+
  Permission is hereby granted, free of charge, to any person obtaining a copy
  of this software and associated documentation files (the "Software"), to deal
  in the Software without restriction, including without limitation the rights
  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
  copies of the Software, and to permit persons to whom the Software is
  furnished to do so, subject to the following conditions:
- 
+
  The above copyright notice and this permission notice shall be included in
  all copies or substantial portions of the Software.
- 
+
  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
@@ -20,43 +20,23 @@
  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  THE SOFTWARE.
- 
+
  */
-#ifndef __videocore__Golomb__
-#define __videocore__Golomb__
-
-#include <iostream>
-namespace videocore { namespace h264 {
-    
-    typedef uint32_t WORD;
-    
-    const size_t kBufWidth = sizeof(WORD)*8;
-    
-    static inline WORD swap(WORD input) { return __builtin_bswap32(input); };
-    
-    class GolombDecode
+
+
+#include <videocore/filters/CPU/ColorMatrixVideoFilter.h>
+
+namespace videocore { namespace filters { namespace CPU {
+
+    void
+    ColorMatrixVideoFilter::process(const uint8_t* src, size_t srcStride,
+                                    uint8_t* dst, size_t dstStride,
+                                    int width, int height,
+                                    int rowBegin, int rowEnd,
+                                    bool isRGBA)
     {
-    public:
-        
-        GolombDecode(const WORD* inBitstream);
-        ~GolombDecode();
-        
-        uint32_t getBits(const size_t num_bits);
-        uint32_t unsignedDecode();
-        int32_t  signedDecode();
-        
-        const size_t bitsRead() const { return m_bitsRead; };
-        const size_t lastBitsRead() const { return m_lastBitsRead; };
-    private:
-        
-        
-        WORD*         m_pCurrentPosition;
-        
-        size_t        m_leftBit;
-        size_t        m_bitsRead;
-        size_t        m_lastBitsRead;
-    };
-    
+        image::applyChannelMatrix(src, srcStride, dst, dstStride, width, rowBegin, rowEnd, m_colorMatrix, isRGBA);
+    }
+}
 }
 }
-#endif /* defined(__videocore__Golomb__) */
@@ -0,0 +1,60 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_CPU_ColorMatrixVideoFilter_h
+#define videocore_CPU_ColorMatrixVideoFilter_h
+
+#include <videocore/filters/ICPUVideoFilter.hpp>
+#include <videocore/system/image/ChannelMatrix.h>
+
+namespace videocore {
+    namespace filters { namespace CPU {
+        /*!
+         *  Base class for CPU filters that are a per-pixel affine transform of colour.
+         */
+        class ColorMatrixVideoFilter : public ICPUVideoFilter {
+
+        public:
+            void process(const uint8_t* src, size_t srcStride,
+                         uint8_t* dst, size_t dstStride,
+                         int width, int height,
+                         int rowBegin, int rowEnd,
+                         bool isRGBA);
+
+            bool passthrough() const { return m_colorMatrix.isIdentity(); };
+
+            const image::ChannelMatrix* colorMatrix() const { return &m_colorMatrix; };
+
+        protected:
+            ColorMatrixVideoFilter(const image::ChannelMatrix& matrix) : m_colorMatrix(matrix) {};
+
+            image::ChannelMatrix m_colorMatrix;
+        };
+    }
+    }
+}
+
+#endif /* defined(videocore_CPU_ColorMatrixVideoFilter_h) */
@@ -0,0 +1,246 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/FilterChain.h>
+
+#include <string.h>
+
+// Rows per block.  Trailing colour matrices are applied to each block of output while it is still in cache.
+static const int kBlockRows = 32;
+
+namespace videocore { namespace filters { namespace CPU {
+
+    FilterChain::FilterChain(const std::vector<ICPUVideoFilter*>& filters)
+    : m_dirty(false), m_width(0), m_height(0)
+    {
+        setFilters(filters);
+    }
+
+    void
+    FilterChain::flatten(const std::vector<ICPUVideoFilter*>& filters, std::vector<ICPUVideoFilter*>& out)
+    {
+        for ( auto f : filters ) {
+            auto chain = dynamic_cast<FilterChain*>(f);
+            if(chain) {
+                std::lock_guard<std::mutex> l(chain->m_mutex);
+                flatten(chain->m_pending, out);
+            } else if(f) {
+                out.push_back(f);
+            }
+        }
+    }
+
+    void
+    FilterChain::setFilters(const std::vector<ICPUVideoFilter*>& filters)
+    {
+        std::vector<ICPUVideoFilter*> flat;
+        flatten(filters, flat);
+
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_pending.swap(flat);
+        m_dirty = true;
+    }
+
+    bool
+    FilterChain::passthrough() const
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        return std::all_of(m_pending.begin(), m_pending.end(), [](ICPUVideoFilter* f) { return f->passthrough(); });
+    }
+
+    void
+    FilterChain::append(MatrixList& list, const image::ChannelMatrix& matrix)
+    {
+        if(!list.empty() && list.back().isBounded()) {
+            list.back() = matrix * list.back();
+            if(list.back().isIdentity()) {
+                list.pop_back();
+            }
+        } else if(!matrix.isIdentity()) {
+            list.push_back(matrix);
+        }
+    }
+
+    void
+    FilterChain::apply(const MatrixList& list, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                       int width, int rowBegin, int rowEnd, bool isRGBA)
+    {
+        if(!list.empty()) {
+            image::applyChannelMatrices(src, srcStride, dst, dstStride, width, rowBegin, rowEnd, &list[0], list.size(), isRGBA);
+        }
+    }
+
+    size_t
+    FilterChain::compileFused()
+    {
+        MatrixList pending;
+        size_t matrices = 0;
+        for ( auto f : m_filters ) {
+            if(f->passthrough()) {
+                continue;
+            }
+            const image::ChannelMatrix* m = f->colorMatrix();
+            if(m) {
+                append(pending, *m);
+                continue;
+            }
+            if(f->commutesWithColorMatrix() && (pending.empty() || (pending.size() == 1 && pending[0].isBounded()))) {
+                // The pending matrix is applied after this filter instead.
+                m_stages.push_back({ MatrixList(), f });
+                continue;
+            }
+            if(!pending.empty()) {
+                matrices += pending.size();
+                m_stages.push_back({ pending, nullptr });
+                pending.clear();
+            }
+            m_stages.push_back({ MatrixList(), f });
+        }
+        m_post = pending;
+        return matrices + m_post.size();
+    }
+
+    void
+    FilterChain::compile()
+    {
+        m_stages.clear();
+        m_post.clear();
+
+        const size_t matrixFilters = std::count_if(m_filters.begin(), m_filters.end(), [](ICPUVideoFilter* f) {
+            return !f->passthrough() && f->colorMatrix();
+        });
+        if(compileFused() < matrixFilters) {
+            return;
+        }
+
+        // Nothing was combined.  Applying matrices back to back in registers, or in blocks ahead of a
+        // neighbourhood filter, measured no faster than separate passes, and slower ahead of glow.
+        m_stages.clear();
+        m_post.clear();
+        for ( auto f : m_filters ) {
+            if(f->passthrough()) {
+                continue;
+            }
+            const image::ChannelMatrix* m = f->colorMatrix();
+            if(m) {
+                m_stages.push_back({ MatrixList(1, *m), nullptr });
+            } else {
+                m_stages.push_back({ MatrixList(), f });
+            }
+        }
+    }
+
+    void
+    FilterChain::prepare(int width, int height)
+    {
+        {
+            std::lock_guard<std::mutex> l(m_mutex);
+            if(m_dirty) {
+                m_filters = m_pending;
+                m_dirty = false;
+                compile();
+            }
+        }
+        for ( auto & stage : m_stages ) {
+            if(stage.kernel) {
+                stage.kernel->prepare(width, height);
+            }
+        }
+        m_width = width;
+        m_height = height;
+
+        const size_t intermediates = m_stages.empty() ? 0 : m_stages.size() - 1;
+        m_intermediate.resize(intermediates);
+        for ( auto & image : m_intermediate ) {
+            image.resize(size_t(width) * height * 4);
+        }
+    }
+
+    void
+    FilterChain::process(const uint8_t* src, size_t srcStride,
+                         uint8_t* dst, size_t dstStride,
+                         int width, int height,
+                         int rowBegin, int rowEnd,
+                         bool isRGBA)
+    {
+        // Passes after the first may read rows outside [rowBegin, rowEnd) that a concurrent call has not written
+        // yet, so a multi-pass chain is only correct here for a single call that covers the image.
+        for ( int pass = 0 ; pass < passCount() ; ++pass ) {
+            processPass(pass, src, srcStride, dst, dstStride, width, height, rowBegin, rowEnd, isRGBA);
+        }
+    }
+
+    void
+    FilterChain::processPass(int pass,
+                             const uint8_t* src, size_t srcStride,
+                             uint8_t* dst, size_t dstStride,
+                             int width, int height,
+                             int rowBegin, int rowEnd,
+                             bool isRGBA)
+    {
+        if(m_stages.empty()) {
+            if(m_post.empty()) {
+                for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+                    memcpy(dst + y * dstStride, src + y * srcStride, width * 4);
+                }
+                return;
+            }
+            for ( int y0 = rowBegin ; y0 < rowEnd ; y0 += kBlockRows ) {
+                apply(m_post, src, srcStride, dst, dstStride, width, y0, std::min(rowEnd, y0 + kBlockRows), isRGBA);
+            }
+            return;
+        }
+        if(width != m_width || height != m_height || pass < 0 || pass >= int(m_stages.size())) {
+            return;
+        }
+        const Stage& stage = m_stages[pass];
+        const bool last = (pass == int(m_stages.size()) - 1);
+        const size_t intermediateStride = size_t(width) * 4;
+
+        const uint8_t* in = pass ? &m_intermediate[pass - 1][0] : src;
+        const size_t inStride = pass ? intermediateStride : srcStride;
+        uint8_t* out = last ? dst : &m_intermediate[pass][0];
+        const size_t outStride = last ? dstStride : intermediateStride;
+
+        // Only trailing matrices need the pass split into blocks; otherwise the stage covers the range in one call.
+        const int blockRows = (last && !m_post.empty()) ? kBlockRows : rowEnd - rowBegin;
+
+        for ( int y0 = rowBegin ; y0 < rowEnd ; y0 += blockRows ) {
+            const int y1 = std::min(rowEnd, y0 + blockRows);
+
+            if(stage.kernel) {
+                stage.kernel->process(in, inStride, out, outStride, width, height, y0, y1, isRGBA);
+            } else {
+                apply(stage.pre, in, inStride, out, outStride, width, y0, y1, isRGBA);
+            }
+            if(last) {
+                apply(m_post, out, outStride, out, outStride, width, y0, y1, isRGBA);
+            }
+        }
+    }
+}
+}
+}
@@ -0,0 +1,130 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_CPU_FilterChain_h
+#define videocore_CPU_FilterChain_h
+
+#include <videocore/filters/ICPUVideoFilter.hpp>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace videocore {
+    namespace filters { namespace CPU {
+        /*!
+         *  Applies a sequence of CPU filters as one filter, fusing colour matrix filters where that removes work:
+         *
+         *  - Adjacent colour matrix filters (grayscale, sepia, invert, ...) are multiplied into one matrix, unless the
+         *    first can clamp (image::ChannelMatrix::isBounded()); such runs are applied one after the other in
+         *    registers by image::applyChannelMatrices().
+         *  - Non-clamping colour matrices move across filters that commute with them (geometric remaps such as
+         *    fisheye).
+         *  - Trailing colour matrices are applied in place on each block of output while it is still in cache.
+         *
+         *  Matrices in front of any other filter are a pass of their own, and if no two matrices could be combined
+         *  the chain runs every filter as its own pass, as applying them one after another would.  Passes after the
+         *  first read an intermediate image owned by the chain.  The chain does not own its filters.
+         */
+        class FilterChain : public ICPUVideoFilter {
+
+        public:
+            FilterChain() : m_dirty(false), m_width(0), m_height(0) {};
+            FilterChain(const std::vector<ICPUVideoFilter*>& filters);
+            ~FilterChain() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.chain"; };
+
+            /*!
+             *  Set the filters to apply, in order.  Safe to call while the chain is in use; the change takes effect
+             *  at the next prepare().  Nested chains are flattened.
+             */
+            void setFilters(const std::vector<ICPUVideoFilter*>& filters);
+
+        public:
+            void prepare(int width, int height);
+
+            void process(const uint8_t* src, size_t srcStride,
+                         uint8_t* dst, size_t dstStride,
+                         int width, int height,
+                         int rowBegin, int rowEnd,
+                         bool isRGBA);
+
+            bool passthrough() const;
+
+            int passCount() const { return std::max(1, int(m_stages.size())); };
+
+            void processPass(int pass,
+                             const uint8_t* src, size_t srcStride,
+                             uint8_t* dst, size_t dstStride,
+                             int width, int height,
+                             int rowBegin, int rowEnd,
+                             bool isRGBA);
+
+        private:
+            /*! Colour matrices applied in order, clamping after each. */
+            typedef std::vector<image::ChannelMatrix> MatrixList;
+
+            /*! Either a list of colour matrices or a filter that is not one. */
+            struct Stage {
+                MatrixList           pre;
+                ICPUVideoFilter*     kernel;
+            };
+
+            /*! Rebuild m_stages and m_post from m_filters, fused if that combines any matrices. */
+            void compile();
+
+            /*! Append a matrix to a list, multiplying it into the last one when that never clamps. */
+            static void append(MatrixList& list, const image::ChannelMatrix& matrix);
+
+            /*! Build the fused stages.  Returns the number of matrices left to apply. */
+            size_t compileFused();
+
+            /*! Apply a list to rows [rowBegin, rowEnd) of src, writing dst. */
+            static void apply(const MatrixList& list, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                              int width, int rowBegin, int rowEnd, bool isRGBA);
+
+            /*! Flatten nested chains into out. */
+            static void flatten(const std::vector<ICPUVideoFilter*>& filters, std::vector<ICPUVideoFilter*>& out);
+
+        private:
+            mutable std::mutex             m_mutex;      /* guards m_pending and m_dirty */
+            std::vector<ICPUVideoFilter*>  m_pending;
+            bool                           m_dirty;
+
+            std::vector<ICPUVideoFilter*>  m_filters;
+            std::vector<Stage>             m_stages;
+            MatrixList                     m_post;
+
+            std::vector<std::vector<uint8_t>> m_intermediate;   /* output of every stage but the last */
+            int                            m_width;
+            int                            m_height;
+        };
+    }
+    }
+}
+
+#endif /* defined(videocore_CPU_FilterChain_h) */
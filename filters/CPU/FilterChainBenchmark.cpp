@@ -0,0 +1,163 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  FilterChain against running the same filters one after another, on a 1280x720 BGRA frame on one thread.  The
+ *  sequential run reuses two preallocated frames, so the difference is only the passes the chain saves.  Also
+ *  reports the number of passes the chain compiled to and the largest difference between the two outputs.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with the sources in
+ *  filters/CPU/ and system/image/ and the library's FilterFactory, which the filters register themselves with.
+ */
+
+#include <videocore/filters/CPU/FilterChain.h>
+#include <videocore/filters/CPU/FisheyeVideoFilter.h>
+#include <videocore/filters/CPU/GlowVideoFilter.h>
+#include <videocore/filters/CPU/GrayscaleVideoFilter.h>
+#include <videocore/filters/CPU/InvertColorsVideoFilter.h>
+#include <videocore/filters/CPU/SepiaVideoFilter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace videocore;
+using namespace videocore::filters::CPU;
+
+namespace {
+
+    const int    kWidth = 1280;
+    const int    kHeight = 720;
+    const size_t kStride = kWidth * 4;
+    const int    kIterations = 100;
+
+    /* Best time of kIterations runs, in ms; the machine's noise only ever adds time. */
+    double
+    bestOf(const std::function<void()>& f)
+    {
+        f();
+        double best = 1e9;
+        for ( int i = 0 ; i < kIterations ; ++i ) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    class Sequential {
+    public:
+        Sequential(const std::vector<uint8_t>& src) : m_src(src), m_a(src.size()), m_b(src.size()), m_result(nullptr) {};
+
+        void run(const std::vector<ICPUVideoFilter*>& filters) {
+            const uint8_t* in = &m_src[0];
+            uint8_t* out = &m_a[0];
+            for ( auto f : filters ) {
+                f->prepare(kWidth, kHeight);
+                f->process(in, kStride, out, kStride, kWidth, kHeight, 0, kHeight, false);
+                in = out;
+                out = (out == &m_a[0]) ? &m_b[0] : &m_a[0];
+            }
+            m_result = in;
+        }
+        const uint8_t* result() const { return m_result; };
+
+    private:
+        const std::vector<uint8_t>& m_src;
+        std::vector<uint8_t> m_a;
+        std::vector<uint8_t> m_b;
+        const uint8_t* m_result;
+    };
+
+    void
+    runChain(FilterChain& chain, const std::vector<uint8_t>& src, std::vector<uint8_t>& dst)
+    {
+        chain.prepare(kWidth, kHeight);
+        for ( int pass = 0 ; pass < chain.passCount() ; ++pass ) {
+            chain.processPass(pass, &src[0], kStride, &dst[0], kStride, kWidth, kHeight, 0, kHeight, false);
+        }
+    }
+}
+
+int
+main()
+{
+    std::vector<uint8_t> src(kStride * kHeight), dst(src.size());
+    srand(2);
+    for ( int y = 0 ; y < kHeight ; ++y ) {
+        for ( int x = 0 ; x < kWidth ; ++x ) {
+            uint8_t* p = &src[y * kStride + x * 4];
+            p[0] = uint8_t(x * 255 / kWidth + rand() % 20);
+            p[1] = uint8_t(y * 255 / kHeight);
+            p[2] = uint8_t((x + y) / 8);
+            p[3] = 255;
+        }
+    }
+
+    GrayscaleVideoFilter gray;
+    InvertColorsVideoFilter invert;
+    SepiaVideoFilter sepia;
+    GlowVideoFilter glow;
+    FisheyeVideoFilter fisheye;
+
+    const struct {
+        const char* name;
+        std::vector<ICPUVideoFilter*> filters;
+    } cases[] = {
+        { "invert>invert",            { &invert, &invert } },
+        { "sepia>invert",             { &sepia, &invert } },
+        { "sepia>invert>gray",        { &sepia, &invert, &gray } },
+        { "invert>fisheye>gray",      { &invert, &fisheye, &gray } },
+        { "glow>gray",                { &glow, &gray } },
+        { "gray>invert>glow",         { &gray, &invert, &glow } },
+        { "sepia>invert>glow",        { &sepia, &invert, &glow } },
+        { "sepia>invert>glow>gray",   { &sepia, &invert, &glow, &gray } },
+    };
+
+    printf("%dx%d BGRA, one thread, best of %d\n", kWidth, kHeight, kIterations);
+    Sequential sequential(src);
+    for ( auto& c : cases ) {
+        FilterChain chain(c.filters);
+        runChain(chain, src, dst);
+        sequential.run(c.filters);
+
+        int difference = 0;
+        for ( size_t i = 0 ; i < dst.size() ; ++i ) {
+            difference = std::max(difference, std::abs(int(dst[i]) - int(sequential.result()[i])));
+        }
+        const double sequentialTime = bestOf([&]() { sequential.run(c.filters); });
+        const double chainTime = bestOf([&]() { runChain(chain, src, dst); });
+
+        printf("%-24s sequential %5.2f ms  chain %5.2f ms (%d %s)  max difference %d\n", c.name, sequentialTime, chainTime,
+               chain.passCount(), chain.passCount() == 1 ? "pass" : "passes", difference);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/FisheyeVideoFilter.h>
+#include <videocore/filters/FilterFactory.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// Field of view term of the GL kernel: a = 1 / (z * tan(-5.2))
+static const float kFieldOfView = -5.2f;
+
+namespace videocore { namespace filters { namespace CPU {
+
+    bool FisheyeVideoFilter::s_registered = FisheyeVideoFilter::registerFilter();
+
+    bool
+    FisheyeVideoFilter::registerFilter()
+    {
+        FilterFactory::_register("com.videocore.filters.fisheye", []() { return new FisheyeVideoFilter(); }, kFilterBackendCPU);
+        return true;
+    }
+
+    FisheyeVideoFilter::FisheyeVideoFilter()
+    : m_width(0), m_height(0)
+    {
+    }
+
+    // Bilinear sample of the 2x2 footprint at p.  fx and fy are in [0, 256].
+    static inline uint32_t
+    bilinear(const uint8_t* p, size_t stride, uint32_t fx, uint32_t fy)
+    {
+#if VC_SIMD_SSE2
+        // Both rows as 16-bit channels, [left | right]; the weights drop to 7 bits so the products fit.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p), zero);
+        const __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + stride)), zero);
+        const __m128i v = _mm_add_epi16(top, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bottom, top), _mm_set1_epi16(int16_t(fy >> 1))), 7));
+        const __m128i h = _mm_add_epi16(v, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_srli_si128(v, 8), v), _mm_set1_epi16(int16_t(fx >> 1))), 7));
+        return uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(h, h)));
+#else
+        // Interpolates two pixels, two channels at a time.
+        auto lerp32 = [](uint32_t a, uint32_t b, uint32_t w) {
+            const uint32_t iw = 256 - w;
+            const uint32_t rb = (((a & 0x00FF00FF) * iw + (b & 0x00FF00FF) * w) >> 8) & 0x00FF00FF;
+            const uint32_t ag = ((((a >> 8) & 0x00FF00FF) * iw + ((b >> 8) & 0x00FF00FF) * w)) & 0xFF00FF00;
+            return rb | ag;
+        };
+        const uint32_t* r0 = (const uint32_t*)p;
+        const uint32_t* r1 = (const uint32_t*)(p + stride);
+        return lerp32(lerp32(r0[0], r0[1], fx), lerp32(r1[0], r1[1], fx), fy);
+#endif
+    }
+
+    void
+    FisheyeVideoFilter::prepare(int width, int height)
+    {
+        if(width == m_width && height == m_height) {
+            return;
+        }
+        m_width = width;
+        m_height = height;
+
+        if(width < 2 || height < 2) {
+            m_taps.clear();
+            return;
+        }
+        const int qw = (width + 1) / 2, qh = (height + 1) / 2;
+        m_taps.resize(size_t(qw) * qh);
+
+        const float t = tanf(kFieldOfView);
+
+        // Clamp every footprint inside the image so the gather never needs bounds checks; a clamped footprint
+        // puts the whole weight on its far edge instead.
+        auto tap = [](float s, int size, uint16_t& i, uint16_t& f) {
+            s = std::min(std::max(s, 0.f), float(size - 1));
+            const int i0 = std::min(int(s), size - 2);
+            i = uint16_t(i0);
+            f = uint16_t(lroundf((s - i0) * 256.f));
+        };
+        for ( int y = 0 ; y < qh ; ++y ) {
+            const float v = (y + 0.5f) / height - 0.5f;
+            Tap* row = &m_taps[size_t(y) * qw];
+            for ( int x = 0 ; x < qw ; ++x ) {
+                const float u = (x + 0.5f) / width - 0.5f;
+                const float z = sqrtf(1.f - u * u - v * v);
+                const float a = 1.f / (z * t);
+
+                // Texture coordinates (u * a + 0.5) back to pixel centers.
+                tap((u * a + 0.5f) * width - 0.5f, width, row[x].x, row[x].fx);
+                tap((v * a + 0.5f) * height - 0.5f, height, row[x].y, row[x].fy);
+            }
+        }
+    }
+
+    void
+    FisheyeVideoFilter::process(const uint8_t* src, size_t srcStride,
+                                uint8_t* dst, size_t dstStride,
+                                int width, int height,
+                                int rowBegin, int rowEnd,
+                                bool isRGBA)
+    {
+        if(m_taps.empty() || width != m_width || height != m_height) {
+            for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+                memcpy(dst + y * dstStride, src + y * srcStride, width * 4);
+            }
+            return;
+        }
+        const int qw = (width + 1) / 2, qh = (height + 1) / 2;
+
+        // Mirroring a footprint about an axis moves it to (size - 2 - i) with the weight reversed.
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            const bool mirrorY = y >= qh;
+            const Tap* taps = &m_taps[size_t(mirrorY ? height - 1 - y : y) * qw];
+            uint32_t* out = (uint32_t*)(dst + y * dstStride);
+
+            for ( int x = 0 ; x < qw ; ++x ) {
+                const Tap& tp = taps[x];
+                const int sy = mirrorY ? height - 2 - tp.y : tp.y;
+                out[x] = bilinear(src + sy * srcStride + tp.x * 4, srcStride, tp.fx, mirrorY ? 256 - tp.fy : tp.fy);
+            }
+            for ( int x = qw ; x < width ; ++x ) {
+                const Tap& tp = taps[width - 1 - x];
+                const int sy = mirrorY ? height - 2 - tp.y : tp.y;
+                out[x] = bilinear(src + sy * srcStride + (width - 2 - tp.x) * 4, srcStride, 256 - tp.fx, mirrorY ? 256 - tp.fy : tp.fy);
+            }
+        }
+    }
+}
+}
+}
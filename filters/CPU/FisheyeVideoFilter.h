@@ -0,0 +1,79 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_CPU_FisheyeVideoFilter_h
+#define videocore_CPU_FisheyeVideoFilter_h
+
+#include <videocore/filters/ICPUVideoFilter.hpp>
+#include <vector>
+
+namespace videocore {
+    namespace filters { namespace CPU {
+        /*!
+         *  CPU version of filters::FisheyeVideoFilter.  The lens mapping only depends on the frame size, so it is
+         *  computed once into a remap table and each frame is a bilinear gather through that table.  The mapping
+         *  is symmetric about both image axes, so the table only covers the top-left quadrant.
+         */
+        class FisheyeVideoFilter : public ICPUVideoFilter {
+
+        public:
+            FisheyeVideoFilter();
+            ~FisheyeVideoFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.fisheye"; };
+
+            void prepare(int width, int height);
+
+            void process(const uint8_t* src, size_t srcStride,
+                         uint8_t* dst, size_t dstStride,
+                         int width, int height,
+                         int rowBegin, int rowEnd,
+                         bool isRGBA);
+
+            /*! Bilinear weights sum to one, so colour transforms can move across the remap. */
+            bool commutesWithColorMatrix() const { return true; };
+
+        private:
+            static bool registerFilter();
+            static bool s_registered;
+
+        private:
+            /*! The top-left pixel of a 2x2 footprint and the bilinear weights, in [0, 256], inside it. */
+            struct Tap {
+                uint16_t x, y;
+                uint16_t fx, fy;
+            };
+
+            std::vector<Tap> m_taps;    /* (m_width + 1) / 2 by (m_height + 1) / 2 */
+            int m_width;
+            int m_height;
+        };
+    }
+    }
+}
+
+#endif /* defined(videocore_CPU_FisheyeVideoFilter_h) */
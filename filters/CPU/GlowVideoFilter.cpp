@@ -0,0 +1,207 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/GlowVideoFilter.h>
+#include <videocore/filters/FilterFactory.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// out = sqrt(xx * xx + yy * yy) * 2 * t5 with every term normalized to [0, 1]; one 1/255 cancels against the output scale.
+static const float kGain = 2.f / 255.f;
+
+namespace videocore { namespace filters { namespace CPU {
+
+    bool GlowVideoFilter::s_registered = GlowVideoFilter::registerFilter();
+
+    bool
+    GlowVideoFilter::registerFilter()
+    {
+        FilterFactory::_register("com.videocore.filters.glow", []() { return new GlowVideoFilter(); }, kFilterBackendCPU);
+        return true;
+    }
+
+    // Horizontal pass over one source row: smooth = l + 2c + r, diff = l - r, per channel, with the edges clamped.
+    static void
+    sobelRow(const uint8_t* VC_RESTRICT row, int width, int16_t* VC_RESTRICT smooth, int16_t* VC_RESTRICT diff)
+    {
+        auto pixel = [&](int x) {
+            const int l = std::max(x - 1, 0) * 4, c = x * 4, r = std::min(x + 1, width - 1) * 4;
+            for ( int k = 0 ; k < 4 ; ++k ) {
+                smooth[c + k] = int16_t(row[l + k] + 2 * row[c + k] + row[r + k]);
+                diff[c + k] = int16_t(row[l + k] - row[r + k]);
+            }
+        };
+        pixel(0);
+        int x = 1;
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for ( ; x + 2 < width ; x += 2 ) {
+            const __m128i l = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + (x - 1) * 4)), zero);
+            const __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + x * 4)), zero);
+            const __m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + (x + 1) * 4)), zero);
+            _mm_storeu_si128((__m128i*)(smooth + x * 4), _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(c, c)));
+            _mm_storeu_si128((__m128i*)(diff + x * 4), _mm_sub_epi16(l, r));
+        }
+#elif VC_SIMD_NEON
+        for ( ; x + 2 < width ; x += 2 ) {
+            const int16x8_t l = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + (x - 1) * 4)));
+            const int16x8_t c = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x * 4)));
+            const int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + (x + 1) * 4)));
+            vst1q_s16(smooth + x * 4, vaddq_s16(vaddq_s16(l, r), vshlq_n_s16(c, 1)));
+            vst1q_s16(diff + x * 4, vsubq_s16(l, r));
+        }
+#endif
+        for ( ; x < width ; ++x ) {
+            pixel(x);
+        }
+    }
+
+    void
+    GlowVideoFilter::process(const uint8_t* src, size_t srcStride,
+                             uint8_t* dst, size_t dstStride,
+                             int width, int height,
+                             int rowBegin, int rowEnd,
+                             bool isRGBA)
+    {
+        if(rowBegin >= rowEnd || width < 1) {
+            return;
+        }
+        const size_t n = size_t(width) * 4;
+
+        // Three rows of horizontal results, reused as a ring while walking down the stripe.
+        std::vector<int16_t> scratch(n * 6 + 8);
+        int16_t* smooth[3] = { &scratch[0], &scratch[n], &scratch[n * 2] };
+        int16_t* diff[3] = { &scratch[n * 3], &scratch[n * 4], &scratch[n * 5] };
+
+        auto rowAt = [&](int y) { return src + std::min(std::max(y, 0), height - 1) * srcStride; };
+        sobelRow(rowAt(rowBegin - 1), width, smooth[0], diff[0]);
+        sobelRow(rowAt(rowBegin), width, smooth[1], diff[1]);
+
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            const int above = (y - rowBegin) % 3, center = (y - rowBegin + 1) % 3, below = (y - rowBegin + 2) % 3;
+            sobelRow(rowAt(y + 1), width, smooth[below], diff[below]);
+
+            const int16_t* s0 = smooth[above];
+            const int16_t* s2 = smooth[below];
+            const int16_t* d0 = diff[above];
+            const int16_t* d1 = diff[center];
+            const int16_t* d2 = diff[below];
+            const uint8_t* c = src + y * srcStride;
+            uint8_t* out = dst + y * dstStride;
+
+            size_t i = 0;
+#if VC_SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alpha = _mm_set1_epi32(0xFF000000);
+            const __m128 gain = _mm_set1_ps(kGain);
+            for ( ; i + 16 <= n ; i += 16 ) {
+                const __m128i px = _mm_loadu_si128((const __m128i*)(c + i));
+                __m128i result[2];
+                for ( int h = 0 ; h < 2 ; ++h ) {
+                    const size_t j = i + h * 8;
+                    const __m128i xx = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(s0 + j)),
+                                                     _mm_loadu_si128((const __m128i*)(s2 + j)));
+                    const __m128i d = _mm_loadu_si128((const __m128i*)(d1 + j));
+                    const __m128i yy = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(d0 + j)),
+                                                                   _mm_loadu_si128((const __m128i*)(d2 + j))),
+                                                     _mm_add_epi16(d, d));
+                    const __m128i t5 = h ? _mm_unpackhi_epi8(px, zero) : _mm_unpacklo_epi8(px, zero);
+
+                    // madd of interleaved (xx, yy) with itself is xx * xx + yy * yy per channel.
+                    const __m128i xyl = _mm_unpacklo_epi16(xx, yy), xyh = _mm_unpackhi_epi16(xx, yy);
+                    const __m128 ml = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(xyl, xyl)));
+                    const __m128 mh = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(xyh, xyh)));
+                    const __m128 tl = _mm_cvtepi32_ps(_mm_unpacklo_epi16(t5, zero));
+                    const __m128 th = _mm_cvtepi32_ps(_mm_unpackhi_epi16(t5, zero));
+                    const __m128i ol = _mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(ml, tl), gain));
+                    const __m128i oh = _mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(mh, th), gain));
+
+                    // The GL kernel samples .bgr and writes .rgb, swapping the outer channels.
+                    const __m128i o = _mm_packs_epi32(ol, oh);
+                    result[h] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(o, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+                }
+                _mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(_mm_packus_epi16(result[0], result[1]), alpha));
+            }
+#elif VC_SIMD_NEON
+            // Eight pixels at a time, deinterleaved by vld4 so the channel swap happens for free in vst4.
+            const float32x4_t gain = vdupq_n_f32(kGain);
+            const float32x4_t half = vdupq_n_f32(0.5f);
+            auto magnitude = [](int16x4_t xx, int16x4_t yy) {
+                const float32x4_t m2 = vcvtq_f32_s32(vmlal_s16(vmull_s16(xx, xx), yy, yy));
+#if defined(__aarch64__)
+                return vsqrtq_f32(m2);
+#else
+                // sqrt(m2) = m2 / sqrt(m2), from the estimate plus two Newton steps. The max keeps
+                // the estimate finite at m2 = 0, where the product is then 0 rather than 0 * inf.
+                const float32x4_t x = vmaxq_f32(m2, vdupq_n_f32(1.f));
+                float32x4_t e = vrsqrteq_f32(x);
+                e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x, e), e));
+                e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x, e), e));
+                return vmulq_f32(m2, e);
+#endif
+            };
+            for ( ; i + 32 <= n ; i += 32 ) {
+                const int16x8x4_t s0v = vld4q_s16(s0 + i), s2v = vld4q_s16(s2 + i);
+                const int16x8x4_t d0v = vld4q_s16(d0 + i), d1v = vld4q_s16(d1 + i), d2v = vld4q_s16(d2 + i);
+                const uint8x8x4_t px = vld4_u8(c + i);
+                uint8x8x4_t result;
+                for ( int k = 0 ; k < 3 ; ++k ) {
+                    const int16x8_t xx = vsubq_s16(s0v.val[k], s2v.val[k]);
+                    const int16x8_t yy = vaddq_s16(vaddq_s16(d0v.val[k], d2v.val[k]), vshlq_n_s16(d1v.val[k], 1));
+                    const uint16x8_t t5 = vmovl_u8(px.val[k]);
+                    const float32x4_t ml = magnitude(vget_low_s16(xx), vget_low_s16(yy));
+                    const float32x4_t mh = magnitude(vget_high_s16(xx), vget_high_s16(yy));
+                    const float32x4_t tl = vcvtq_f32_u32(vmovl_u16(vget_low_u16(t5)));
+                    const float32x4_t th = vcvtq_f32_u32(vmovl_u16(vget_high_u16(t5)));
+
+                    // vcvtq truncates, so round by adding a half first; the values are never negative.
+                    const uint32x4_t ol = vcvtq_u32_f32(vmlaq_f32(half, vmulq_f32(ml, tl), gain));
+                    const uint32x4_t oh = vcvtq_u32_f32(vmlaq_f32(half, vmulq_f32(mh, th), gain));
+
+                    // The GL kernel samples .bgr and writes .rgb, swapping the outer channels.
+                    result.val[2 - k] = vqmovn_u16(vcombine_u16(vqmovn_u32(ol), vqmovn_u32(oh)));
+                }
+                result.val[3] = vdup_n_u8(255);
+                vst4_u8(out + i, result);
+            }
+#endif
+            for ( ; i < n ; i += 4 ) {
+                for ( int k = 0 ; k < 3 ; ++k ) {
+                    const int xx = s0[i + k] - s2[i + k];
+                    const int yy = d0[i + k] + 2 * d1[i + k] + d2[i + k];
+                    const float v = sqrtf(float(xx * xx + yy * yy)) * c[i + k] * kGain;
+                    out[i + 2 - k] = uint8_t(std::min(255.f, v + 0.5f));
+                }
+                out[i + 3] = 255;
+            }
+        }
+    }
+}
+}
+}
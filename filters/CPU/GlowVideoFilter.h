@@ -0,0 +1,64 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_CPU_GlowVideoFilter_h
+#define videocore_CPU_GlowVideoFilter_h
+
+#include <videocore/filters/ICPUVideoFilter.hpp>
+
+namespace videocore {
+    namespace filters { namespace CPU {
+        /*!
+         *  CPU version of filters::GlowVideoFilter: each channel is scaled by twice its Sobel gradient magnitude.
+         *
+         *  The 3x3 Sobel operator is evaluated separably.  Every source row is reduced once to a horizontal
+         *  [1 2 1] smoothing and a horizontal [1 0 -1] difference; each output row then combines three of those.
+         *  The GL kernel steps by a 640x360 texel; here the neighbours are always adjacent pixels.
+         */
+        class GlowVideoFilter : public ICPUVideoFilter {
+
+        public:
+            GlowVideoFilter() {};
+            ~GlowVideoFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.glow"; };
+
+            void process(const uint8_t* src, size_t srcStride,
+                         uint8_t* dst, size_t dstStride,
+                         int width, int height,
+                         int rowBegin, int rowEnd,
+                         bool isRGBA);
+
+        private:
+            static bool registerFilter();
+            static bool s_registered;
+        };
+    }
+    }
+}
+
+#endif /* defined(videocore_CPU_GlowVideoFilter_h) */
@@ -0,0 +1,60 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/GrayscaleVideoFilter.h>
+#include <videocore/filters/FilterFactory.h>
+
+namespace videocore { namespace filters { namespace CPU {
+
+    bool GrayscaleVideoFilter::s_registered = GrayscaleVideoFilter::registerFilter();
+
+    bool
+    GrayscaleVideoFilter::registerFilter()
+    {
+        FilterFactory::_register("com.videocore.filters.grayscale", []() { return new GrayscaleVideoFilter(); }, kFilterBackendCPU);
+        return true;
+    }
+
+    GrayscaleVideoFilter::GrayscaleVideoFilter()
+    : ColorMatrixVideoFilter(matrix())
+    {
+    }
+
+    image::ChannelMatrix
+    GrayscaleVideoFilter::matrix()
+    {
+        // gray = dot(rgb, vec3(0.3, 0.59, 0.11))
+        auto m = image::ChannelMatrix::identity();
+        for ( int c = 0 ; c < 3 ; ++c ) {
+            m.m[c][0] = 0.3f;
+            m.m[c][1] = 0.59f;
+            m.m[c][2] = 0.11f;
+        }
+        return m;
+    }
+}
+}
+}
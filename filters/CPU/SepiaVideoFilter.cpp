@@ -0,0 +1,64 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/filters/CPU/SepiaVideoFilter.h>
+#include <videocore/filters/FilterFactory.h>
+
+namespace videocore { namespace filters { namespace CPU {
+
+    bool SepiaVideoFilter::s_registered = SepiaVideoFilter::registerFilter();
+
+    bool
+    SepiaVideoFilter::registerFilter()
+    {
+        FilterFactory::_register("com.videocore.filters.sepia", []() { return new SepiaVideoFilter(); }, kFilterBackendCPU);
+        return true;
+    }
+
+    SepiaVideoFilter::SepiaVideoFilter()
+    : ColorMatrixVideoFilter(matrix())
+    {
+    }
+
+    image::ChannelMatrix
+    SepiaVideoFilter::matrix()
+    {
+        // rgb = mix(rgb, gray * vec3(1.2, 1.0, 0.8), 0.75)
+        static const float kTint[3] = { 1.2f, 1.0f, 0.8f };
+        static const float kGray[3] = { 0.3f, 0.59f, 0.11f };
+        static const float kAmount = 0.75f;
+
+        auto m = image::ChannelMatrix::identity();
+        for ( int c = 0 ; c < 3 ; ++c ) {
+            for ( int k = 0 ; k < 3 ; ++k ) {
+                m.m[c][k] = (c == k ? 1.f - kAmount : 0.f) + kAmount * kTint[c] * kGray[k];
+            }
+        }
+        return m;
+    }
+}
+}
+}
@@ -0,0 +1,57 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_CPU_SepiaVideoFilter_h
+#define videocore_CPU_SepiaVideoFilter_h
+
+#include <videocore/filters/CPU/ColorMatrixVideoFilter.h>
+
+namespace videocore {
+    namespace filters { namespace CPU {
+        /*!
+         *  CPU version of filters::SepiaVideoFilter: a 75% blend towards a warm-tinted gray, alpha preserved.
+         */
+        class SepiaVideoFilter : public ColorMatrixVideoFilter {
+
+        public:
+            SepiaVideoFilter();
+            ~SepiaVideoFilter() {};
+
+        public:
+            virtual std::string const name() { return "com.videocore.filters.sepia"; };
+
+        private:
+            static image::ChannelMatrix matrix();
+
+        private:
+            static bool registerFilter();
+            static bool s_registered;
+        };
+    }
+    }
+}
+
+#endif /* defined(videocore_CPU_SepiaVideoFilter_h) */
@@ -5,11 +5,18 @@
 #include <videocore/filters/Basic/SepiaVideoFilter.h>
 #include <videocore/filters/Basic/FisheyeVideoFilter.h>
 #include <videocore/filters/Basic/GlowVideoFilter.h>
+#include <videocore/filters/CPU/BasicVideoFilterBGRA.h>
+#include <videocore/filters/CPU/GrayscaleVideoFilter.h>
+#include <videocore/filters/CPU/InvertColorsVideoFilter.h>
+#include <videocore/filters/CPU/SepiaVideoFilter.h>
+#include <videocore/filters/CPU/FisheyeVideoFilter.h>
+#include <videocore/filters/CPU/GlowVideoFilter.h>
 
 namespace videocore {
     std::map<std::string, InstantiateFilter>* FilterFactory::s_registration = nullptr ;
+    std::map<std::string, InstantiateFilter>* FilterFactory::s_cpuRegistration = nullptr ;
     
-    FilterFactory::FilterFactory() {
+    FilterFactory::FilterFactory(FilterBackend backend) : m_backend(backend) {
         {
             filters::BasicVideoFilterBGRA b;
             filters::GrayscaleVideoFilter g;
@@ -17,6 +24,12 @@ namespace videocore {
             filters::SepiaVideoFilter s;
             filters::FisheyeVideoFilter f;
             filters::GlowVideoFilter gl;
+            filters::CPU::BasicVideoFilterBGRA cb;
+            filters::CPU::GrayscaleVideoFilter cg;
+            filters::CPU::InvertColorsVideoFilter ci;
+            filters::CPU::SepiaVideoFilter cs;
+            filters::CPU::FisheyeVideoFilter cf;
+            filters::CPU::GlowVideoFilter cgl;
         }
     }
     IFilter*
@@ -26,12 +39,19 @@ namespace videocore {
         auto it = m_filters.find(name) ;
         if( it != m_filters.end() ) {
             filter = it->second.get();
-        } else if (FilterFactory::s_registration != nullptr) {
-            auto iit = FilterFactory::s_registration->find(name);
-            
-            if(iit != FilterFactory::s_registration->end()) {
-                m_filters[name].reset(iit->second());
-                filter = m_filters[name].get();
+        } else {
+            // CPU registrations shadow the shared ones of the same name.
+            for ( auto registration : { m_backend == kFilterBackendCPU ? s_cpuRegistration : nullptr, s_registration } ) {
+                if(registration == nullptr) {
+                    continue;
+                }
+                auto iit = registration->find(name);
+                
+                if(iit != registration->end()) {
+                    m_filters[name].reset(iit->second());
+                    filter = m_filters[name].get();
+                    break;
+                }
             }
         }
         
@@ -39,11 +59,12 @@ namespace videocore {
     }
     
     void
-    FilterFactory::_register(std::string name, InstantiateFilter instantiation)
+    FilterFactory::_register(std::string name, InstantiateFilter instantiation, FilterBackend backend)
     {
-        if(!s_registration) {
-            s_registration = new std::map<std::string, InstantiateFilter>();
+        auto & registration = (backend == kFilterBackendCPU) ? s_cpuRegistration : s_registration;
+        if(!registration) {
+            registration = new std::map<std::string, InstantiateFilter>();
         }
-        s_registration->emplace(std::make_pair(name, instantiation));
+        registration->emplace(std::make_pair(name, instantiation));
     }
 }
\ No newline at end of file
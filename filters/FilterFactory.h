@@ -10,21 +10,33 @@ namespace videocore {
     
     using InstantiateFilter = std::function<IFilter*()> ;
     
+    /*!
+     *  The implementation a FilterFactory hands out.  GL mixers use kFilterBackendGL; GenericVideoMixer uses
+     *  kFilterBackendCPU, which resolves the same names to ICPUVideoFilter implementations.  Filters without a
+     *  backend-specific implementation are shared by both.
+     */
+    enum FilterBackend {
+        kFilterBackendGL,
+        kFilterBackendCPU
+    };
+    
     class FilterFactory {
     public:
-        FilterFactory();
+        FilterFactory(FilterBackend backend = kFilterBackendGL);
         ~FilterFactory() {};
         
         IFilter* filter(std::string name);
         
     public:
-        static void _register(std::string name, InstantiateFilter instantiation );
+        static void _register(std::string name, InstantiateFilter instantiation, FilterBackend backend = kFilterBackendGL );
         
     private:
         std::map<std::string, std::unique_ptr<IFilter>> m_filters;
+        FilterBackend m_backend;
         
     private:
         static std::map<std::string, InstantiateFilter>* s_registration;
+        static std::map<std::string, InstantiateFilter>* s_cpuRegistration;
     };
     
 }
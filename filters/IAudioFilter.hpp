@@ -0,0 +1,71 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_IAudioFilter_hpp
+#define videocore_IAudioFilter_hpp
+
+#include <videocore/filters/IFilter.hpp>
+#include <stddef.h>
+
+namespace videocore {
+
+    /*!
+     *  Interface for audio processors that run inside the audio mixer's per-source pass.
+     *
+     *  Filters are stateful, so an instance must only be attached to a single source.  They are therefore not
+     *  registered with FilterFactory, which hands out one shared instance per name: create one per source, e.g.
+     *  std::make_shared<filters::HighPassAudioFilter>().  process() is called on the mixer's queue and must not
+     *  allocate, lock or block.
+     */
+    class IAudioFilter : public IFilter {
+
+    public:
+
+        virtual ~IAudioFilter() {} ;
+
+        /*!
+         *  Process a block of samples in place.
+         *
+         *  \param samples      Interleaved float samples, nominally in the range [-1, 1].
+         *  \param frameCount   The number of frames in the block.
+         *  \param channelCount The number of interleaved channels (at most audio::kMaxAudioChannels).
+         *  \param sampleRate   The sampling rate of the block in Hz.
+         */
+        virtual void process(float* samples, size_t frameCount, int channelCount, int sampleRate) = 0;
+
+    public:
+
+        /*! Audio filters have no graphics state. */
+        virtual void initialize() {};
+        virtual bool initialized() const { return true; };
+        virtual void bind() {};
+        virtual void unbind() {};
+
+    protected:
+        IAudioFilter() {};
+    };
+}
+
+#endif
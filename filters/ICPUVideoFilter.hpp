@@ -0,0 +1,115 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef videocore_ICPUVideoFilter_hpp
+#define videocore_ICPUVideoFilter_hpp
+
+#include <videocore/filters/IVideoFilter.hpp>
+#include <videocore/system/image/ChannelMatrix.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore {
+
+    /*!
+     *  Interface for video filters that run on the CPU, as used by GenericVideoMixer.  These are registered with
+     *  FilterFactory under the same names as their GL counterparts, for the kFilterBackendCPU backend.
+     *
+     *  Images are 32-bit BGRA or RGBA.  prepare() is called once per frame, then process() is called for disjoint
+     *  row ranges that together cover the image, possibly concurrently from several threads.
+     *
+     *  The describing methods (colorMatrix(), commutesWithColorMatrix()) let filters::CPU::FilterChain
+     *  fuse several filters into fewer passes over the image.
+     */
+    class ICPUVideoFilter : public IVideoFilter {
+
+    public:
+
+        virtual ~ICPUVideoFilter() {} ;
+
+        /*!
+         *  Called on the compositing thread before a frame is processed.
+         *
+         *  \param width  The width of the frame in pixels.
+         *  \param height The height of the frame in pixels.
+         */
+        virtual void prepare(int width, int height) {};
+
+        /*!
+         *  Filter rows [rowBegin, rowEnd) of src into the same rows of dst.  Rows outside the range may be read
+         *  from src but must not be written.
+         *
+         *  \param isRGBA  true if the pixels are RGBA rather than BGRA.
+         */
+        virtual void process(const uint8_t* src, size_t srcStride,
+                             uint8_t* dst, size_t dstStride,
+                             int width, int height,
+                             int rowBegin, int rowEnd,
+                             bool isRGBA) = 0;
+
+        /*! true if process() would copy its input unchanged, so callers can skip it. */
+        virtual bool passthrough() const { return false; };
+
+        /*! The colour transform applied, if the filter is exactly a per-pixel image::ChannelMatrix. */
+        virtual const image::ChannelMatrix* colorMatrix() const { return nullptr; };
+
+        /*! true if applying a ChannelMatrix before the filter gives the same result as applying it after. */
+        virtual bool commutesWithColorMatrix() const { return false; };
+
+    public:
+        /*!
+         *  The number of passes over the image.  Every row of a pass is processed before the next pass begins.
+         */
+        virtual int passCount() const { return 1; };
+
+        /*! Run one pass over rows [rowBegin, rowEnd).  The default runs process() as the only pass. */
+        virtual void processPass(int pass,
+                                 const uint8_t* src, size_t srcStride,
+                                 uint8_t* dst, size_t dstStride,
+                                 int width, int height,
+                                 int rowBegin, int rowEnd,
+                                 bool isRGBA)
+        {
+            process(src, srcStride, dst, dstStride, width, height, rowBegin, rowEnd, isRGBA);
+        };
+
+    public:
+
+        /*! CPU filters have no graphics state. */
+        const char * const vertexKernel() const { return nullptr; };
+        const char * const pixelKernel() const { return nullptr; };
+
+        virtual void initialize() {};
+        virtual bool initialized() const { return true; };
+        virtual void bind() {};
+        virtual void unbind() {};
+
+    protected:
+        ICPUVideoFilter() {};
+    };
+}
+
+#endif
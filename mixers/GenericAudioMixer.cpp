@@ -23,107 +23,51 @@
 
  */
 #include <videocore/mixers/GenericAudioMixer.h>
+#include <videocore/system/audio/ChannelLayout.h>
+#include <videocore/system/audio/AudioLevelMeter.h>
 #include <sstream>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <stdint.h>
 
 
-#ifndef INT16_MAX
-#define INT16_MAX 0x7FFF
-#endif
-#ifndef INT16_MIN
-#define INT16_MIN ~INT16_MAX
-#endif
-
-static inline int16_t b8_to_b16(void* v) {
-    int16_t val = *(int8_t*)v;
-    return val * 0xFF;
-}
-static inline int16_t b16_to_b16(void*  v) {
-    return *(int16_t*)v;
-}
-
-static inline int16_t b32_to_b16(void*  v) {
-    int16_t val = (*(int32_t*)v / 0xFFFF);
-    return val;
-}
-static inline int16_t b24_to_b16(void* v) {
-
-    static const int m = 1U << 23;
-
-    uint8_t* p = (uint8_t*)v;
-
-    union {
-        int32_t x;
-        uint8_t in[4];
-    };
-    in[0] = p[0];
-    in[1] = p[1];
-    in[2] = p[2];
-    in[3] = 0;
-
-    int32_t r =  (x ^ m) - m;
-
-    return b32_to_b16(&r);
-
-}
 extern std::string g_tmpFolder;
 
 static const int kMixWindowCount = 10;
+static const int kMinSpareWindowCount = 4;  // windows beyond the lookahead depth that incoming buffers may span
 //static const int kWindowBufferCount = 0;
 
 static const float kE = 2.7182818284590f;
+static const float kDefaultSilenceThreshold = 8.f / 32768.f;  // about -72dBFS
+static const size_t kMixBlockFrames = 256;  // frames converted to float and filtered at a time in the mix pass
 
 namespace videocore {
 
-    inline int16_t TPMixSamples(int16_t a, int16_t b) {
-        return
-        // If both samples are negative, mixed signal must have an amplitude between the lesser of A and B, and the minimum permissible negative amplitude
-        a < 0 && b < 0 ?
-        ((int)a + (int)b) - (((int)a * (int)b)/INT16_MIN) :
-        
-        // If both samples are positive, mixed signal must have an amplitude between the greater of A and B, and the maximum permissible positive amplitude
-        ( a > 0 && b > 0 ?
-         ((int)a + (int)b) - (((int)a * (int)b)/INT16_MAX)
-         
-         // If samples are on opposite sides of the 0-crossing, mixed signal should reflect that samples cancel each other out somewhat
-         :
-         a + b);
-    }
-    
     GenericAudioMixer::GenericAudioMixer(int outChannelCount,
                                          int outFrequencyInHz,
                                          int outBitsPerChannel,
                                          double frameDuration)
     :
-    m_bufferDuration(frameDuration),
+    m_outgoingWindow(nullptr),
+    m_mixQueue("com.videocore.audiomix", kJobQueuePriorityHigh),
+    m_epoch(std::chrono::steady_clock::now()),
     m_frameDuration(frameDuration),
-    m_outChannelCount(outChannelCount),
+    m_bufferDuration(frameDuration),
+    m_lookaheadDepth(1),
+    m_outChannelCount(std::max(1, std::min(outChannelCount, audio::kMaxAudioChannels))),
     m_outFrequencyInHz(outFrequencyInHz),
     m_outBitsPerChannel(16),
     m_exiting(false),
-    m_mixQueue("com.videocore.audiomix", kJobQueuePriorityHigh),
-    m_outgoingWindow(nullptr),
-    m_catchingUp(false),
-    m_epoch(std::chrono::steady_clock::now())
+    m_lowLatency(false),
+    m_deliveredUntil(0),
+    m_masterMeter(std::make_shared<audio::AudioLevelMeter>()),
+    m_silenceThreshold(kDefaultSilenceThreshold),
+    m_catchingUp(false)
     {
-        m_bytesPerSample = outChannelCount * outBitsPerChannel / 8;
-
-        
-        for ( int i = 0 ; i < kMixWindowCount ; ++i ) {
-            m_windows.emplace_back(std::make_shared<MixWindow>(m_bytesPerSample * frameDuration * outFrequencyInHz));
-        }
-        for ( int i = 0 ; i < kMixWindowCount-1 ; ++i ) {
-            m_windows[i]->next = m_windows[i+1].get();
-            m_windows[i+1]->prev = m_windows[i+1].get();
-        }
-        m_windows[kMixWindowCount-1]->next = m_windows[0].get();
-        m_windows[0]->prev = m_windows[kMixWindowCount-1].get();
-        
-        m_currentWindow = m_windows[0].get();
-        m_currentWindow->start = std::chrono::steady_clock::now();
-
+        m_bytesPerSample = m_outChannelCount * m_outBitsPerChannel / 8;
 
+        allocateWindows();
     }
     GenericAudioMixer::~GenericAudioMixer()
     {
@@ -149,6 +93,46 @@ namespace videocore {
         m_bufferDuration = duration;
     }
     void
+    GenericAudioMixer::setMixWindowParameters(double windowDuration, int lookaheadDepth)
+    {
+        if(m_mixThread.joinable()) {
+            DLog("GenericAudioMixer::setMixWindowParameters must be called before start()\n");
+            return;
+        }
+        m_frameDuration = windowDuration;
+        m_lookaheadDepth = std::max(0, lookaheadDepth);
+        allocateWindows();
+    }
+    void
+    GenericAudioMixer::setLowLatencyMode(bool lowLatency)
+    {
+        m_lowLatency = lowLatency;
+        m_mixThreadCond.notify_all();
+    }
+    void
+    GenericAudioMixer::allocateWindows()
+    {
+        // The ring must hold every window that is waiting to be emitted plus the windows that incoming
+        // buffers may span.
+        const int windowCount = std::max(kMixWindowCount, m_lookaheadDepth + kMinSpareWindowCount);
+        const size_t framesPerWindow = size_t(m_frameDuration * m_outFrequencyInHz + 0.5);
+
+        m_windows.clear();
+        for ( int i = 0 ; i < windowCount ; ++i ) {
+            m_windows.emplace_back(std::make_shared<MixWindow>(m_bytesPerSample * framesPerWindow));
+        }
+        for ( int i = 0 ; i < windowCount-1 ; ++i ) {
+            m_windows[i]->next = m_windows[i+1].get();
+            m_windows[i+1]->prev = m_windows[i].get();
+        }
+        m_windows[windowCount-1]->next = m_windows[0].get();
+        m_windows[0]->prev = m_windows[windowCount-1].get();
+        
+        m_currentWindow = m_windows[0].get();
+        m_currentWindow->start = std::chrono::steady_clock::now();
+        m_outgoingWindow = m_currentWindow;
+    }
+    void
     GenericAudioMixer::registerSource(std::shared_ptr<ISource> source,
                                       size_t inBufferSize)
     {
@@ -157,7 +141,9 @@ namespace videocore {
 
         std::unique_ptr<RingBuffer> buffer(new RingBuffer(bufferSize));
         
-        m_inGain[hash] = 1.f;
+        m_mixQueue.enqueue([=]() {
+            sourceChain(hash);
+        });
     }
     void
     GenericAudioMixer::unregisterSource(std::shared_ptr<ISource> source)
@@ -165,10 +151,15 @@ namespace videocore {
         auto hash = std::hash<std::shared_ptr< ISource> >()(source);
 
         m_mixQueue.enqueue([=]() {
-            auto iit = m_inGain.find(hash);
-            if(iit != m_inGain.end()) {
-                m_inGain.erase(iit);
+            auto iit = m_sourceChains.find(hash);
+            if(iit != m_sourceChains.end()) {
+                m_sourceChains.erase(iit);
             }
+            auto tit = m_lastSampleTime.find(hash);
+            if(tit != m_lastSampleTime.end()) {
+                m_lastSampleTime.erase(tit);
+            }
+            updateDeliveredTime();
         });
 
     }
@@ -182,7 +173,6 @@ namespace videocore {
         if(inMeta.size() >= 5) {
             const auto inSource = inMeta.getData<kAudioMetadataSource>() ;
             const auto cMixTime = std::chrono::steady_clock::now();
-            MixWindow* currentWindow = m_currentWindow;
             auto lSource = inSource.lock();
             if(lSource) {
                 
@@ -210,56 +200,84 @@ namespace videocore {
                         mixTime = it->second;
                     }
                     
-                    size_t startOffset = 0;
-                
-                    MixWindow* window = currentWindow;
-                
-                    auto diff = std::chrono::duration_cast<std::chrono::microseconds>(mixTime - window->start).count();
-
-                    if(diff > 0) {
-                        startOffset = size_t((float(diff) / 1.0e6f) * m_outFrequencyInHz * m_bytesPerSample) & ~(m_bytesPerSample-1);
-                        
-                        while ( startOffset >= window->size ) {
-                            startOffset = (startOffset - window->size);
-                            window = window->next;
-                            
-                        }
-                        
-                    } else {
-                        startOffset = 0;
-                    }
-                    
                     auto sampleDuration = double(ret->size()) / double(m_bytesPerSample * m_outFrequencyInHz);
 
-                    const float mult = m_inGain[hash] * g;
+                    SourceChain& chain = sourceChain(hash);
+                    const int channelCount = m_outChannelCount;
                     
                     uint8_t* p ;
                     ret->read(&p, ret->size());
-                    size_t bytesLeft = ret->size();
+                    const int16_t* src = (const int16_t*)p;
+                    size_t framesLeft = ret->size() / m_bytesPerSample;
 
-                    size_t so = startOffset;
-                    
-                    while(bytesLeft > 0) {
-                        size_t toCopy = std::min(window->size - so, bytesLeft);
+                    chain.levels.reset();
 
-                        short* mix = (short*)p;
-                        short* winMix = (short*)(window->buffer+so);
-                        size_t count = toCopy / sizeof(short);
-                        
-                        for ( size_t i = 0 ; i < count  ; i++ ) {
-                            winMix[i] = TPMixSamples(winMix[i], mix[i]*mult);
+                    // The mix thread emits and clears windows under the same lock, so a window can't go out
+                    // half-written.
+                    std::lock_guard<std::mutex> l(m_mixMutex);
+
+                    // Place the buffer relative to the oldest window not yet emitted.  Anything before it has
+                    // already gone out, and its slot may be reused for a later window, so that part is dropped.
+                    MixWindow* const firstWindow = m_outgoingWindow;
+                    MixWindow* window = firstWindow;
+                    size_t so = 0;
+
+                    const auto diff = std::chrono::duration_cast<std::chrono::microseconds>(mixTime - window->start).count();
+                    const size_t diffFrames = size_t((std::abs(double(diff)) / 1.0e6) * m_outFrequencyInHz);
+
+                    if(diff < 0) {
+                        const size_t late = std::min(diffFrames, framesLeft);
+                        src += late * channelCount;
+                        framesLeft -= late;
+                    } else {
+                        so = diffFrames * m_bytesPerSample;
+                        while ( framesLeft > 0 && so >= window->size ) {
+                            so -= window->size;
+                            window = window->next;
+                            if(window == firstWindow) {
+                                // Beyond the end of the ring.
+                                framesLeft = 0;
+                            }
                         }
-                        
-                        p += toCopy;
-                        bytesLeft -= toCopy;
-                        
-                        if(bytesLeft) {
+                    }
+
+                    // Convert, filter and mix one block at a time so the source is only touched once and
+                    // the working set stays in cache.
+                    float block[kMixBlockFrames * audio::kMaxAudioChannels];
+                    
+                    while(framesLeft > 0) {
+                        const size_t windowFramesLeft = (window->size - so) / m_bytesPerSample;
+                        if(!windowFramesLeft) {
                             window = window->next;
                             so = 0;
+                            if(window == firstWindow) {
+                                // The rest would wrap onto the window that goes out next.
+                                break;
+                            }
+                            continue;
+                        }
+                        const size_t frameCount = std::min(std::min(kMixBlockFrames, framesLeft), windowFramesLeft);
+                        const size_t count = frameCount * channelCount;
+
+                        for ( size_t i = 0 ; i < count ; ++i ) {
+                            block[i] = float(src[i]) * (1.f / 32768.f);
                         }
+                        for ( auto & filter : chain.filters ) {
+                            filter->process(block, frameCount, channelCount, m_outFrequencyInHz);
+                        }
+                        chain.gain.process(block, frameCount, channelCount, m_outFrequencyInHz);
+
+                        audio::mixAndMeasure((int16_t*)(window->buffer + so), block, frameCount, channelCount, g, chain.levels);
+                        
+                        src += count;
+                        framesLeft -= frameCount;
+                        so += frameCount * m_bytesPerSample;
                     }
+                    chain.meter->publish(chain.levels, channelCount);
+
                     m_lastSampleTime[hash] = mixTime + std::chrono::microseconds(int64_t(sampleDuration*1.0e6));
                     
+                    updateDeliveredTime();
                 });
 
             }
@@ -271,99 +289,31 @@ namespace videocore {
                                 AudioBufferMetadata &metadata)
     {
         const auto inFrequncyInHz = metadata.getData<kAudioMetadataFrequencyInHz>();
-        auto inBitsPerChannel = metadata.getData<kAudioMetadataBitsPerChannel>();
+        const auto inBitsPerChannel = metadata.getData<kAudioMetadataBitsPerChannel>();
         const auto inChannelCount = metadata.getData<kAudioMetadataChannelCount>();
         const auto inFlags = metadata.getData<kAudioMetadataFlags>();
         const auto inNumberFrames = metadata.getData<kAudioMetadataNumberFrames>();
 
-        if(m_outFrequencyInHz == inFrequncyInHz && m_outBitsPerChannel == inBitsPerChannel && m_outChannelCount == inChannelCount)
+        if(m_outFrequencyInHz == inFrequncyInHz && m_outBitsPerChannel == inBitsPerChannel && m_outChannelCount == inChannelCount && !(inFlags & audio::kAudioFlagIsFloat))
         {
             // No resampling necessary
             return std::make_shared<Buffer>();
         }
 
-        int16_t (*bitconvert)(void* val) = NULL;
-
-        //
-        
-        uint8_t* intBuffer = nullptr;
-        uint8_t * pOutBuffer = NULL;
-        uint8_t * pInBuffer = const_cast<uint8_t*>(buffer);
-        
-        if(inFlags & 1) {
-            // Floating point lpcm
-            inBitsPerChannel = m_outBitsPerChannel;
-            
-            intBuffer = (uint8_t*) malloc(inNumberFrames * 4);
-
-            deinterleaveDefloat((float*)buffer, (short*)intBuffer,(int) inNumberFrames, inChannelCount);
-            pInBuffer = intBuffer;
-            
-        }
-
-        switch(inBitsPerChannel)
-        {
-            case 8:
-                bitconvert = b8_to_b16;
-                break;
-            case 16:
-                bitconvert = b16_to_b16;
-                break;
-            case 24:
-                bitconvert = b24_to_b16;
-                break;
-            case 32:
-                bitconvert = b32_to_b16;
-                break;
-            default:
-                bitconvert = b16_to_b16;
-                break;
-        }
-
-
-        const size_t bytesPerChannel = inBitsPerChannel / 8;
-        const size_t bytesPerSample = inChannelCount * bytesPerChannel;
+        const audio::ChannelMixMatrix matrix(inChannelCount, m_outChannelCount);
 
         const double ratio = static_cast<double>(inFrequncyInHz) / static_cast<double>(m_outFrequencyInHz);
 
-        const size_t sampleCount = inNumberFrames;
-        const size_t outSampleCount = sampleCount / ratio;
+        const size_t outSampleCount = inNumberFrames / ratio;
         const size_t outBufferSize = outSampleCount * m_bytesPerSample;
 
         const auto outBuffer = std::make_shared<Buffer>(outBufferSize);
 
-    
+        uint8_t* pOutBuffer = nullptr;
         outBuffer->read(&pOutBuffer, outBufferSize);
 
-        int16_t* currSample = (int16_t*)(&pOutBuffer[0]);
-
-        float currentInByteOffset = 0.;
-        const float sampleStride = ratio * static_cast<float>(bytesPerSample);
-
-        const size_t channelStride = (inChannelCount > 1) * bytesPerChannel;
-
-        const uint8_t* pInStart = pInBuffer;
-        
-        for( size_t i = 0 ; i < outSampleCount ; ++i )
-        {
-            size_t iSample = (static_cast<size_t>(std::floor(currentInByteOffset))) & ~(bytesPerSample-1); // get an aligned sample.
-
-
-            currentInByteOffset += sampleStride;
+        audio::convertResampleAndMix(buffer, inNumberFrames, inBitsPerChannel, inFlags, ratio, matrix, (int16_t*)pOutBuffer, outSampleCount);
 
-            pInBuffer = (const_cast<uint8_t*>(pInStart)+iSample);
-
-            int16_t sampleL = bitconvert(pInBuffer);
-            int16_t sampleR = bitconvert(pInBuffer + channelStride);
-
-            *currSample++ = sampleL;
-            *currSample++ = sampleR;
-
-
-        }
-        if(intBuffer) {
-            free(intBuffer);
-        }
         outBuffer->setSize(outBufferSize);
         return outBuffer;
     }
@@ -382,14 +332,72 @@ namespace videocore {
             
             gain = std::max(0.f, std::min(1.f, gain));
             gain = powf(gain, kE);
-            m_inGain[hash] = gain;
+            
+            m_mixQueue.enqueue([=]() {
+                sourceChain(hash).gain.setGain(gain);
+            });
+        }
+    }
+    void
+    GenericAudioMixer::addSourceFilter(std::weak_ptr<ISource> source,
+                                       std::shared_ptr<IAudioFilter> filter)
+    {
+        auto s = source.lock();
+        if(s && filter) {
+            auto hash = std::hash<std::shared_ptr<ISource>>()(s);
 
+            m_mixQueue.enqueue([=]() {
+                sourceChain(hash).filters.push_back(filter);
+            });
         }
     }
     void
+    GenericAudioMixer::removeSourceFilter(std::weak_ptr<ISource> source,
+                                          std::shared_ptr<IAudioFilter> filter)
+    {
+        auto s = source.lock();
+        if(s) {
+            auto hash = std::hash<std::shared_ptr<ISource>>()(s);
+
+            m_mixQueue.enqueue([=]() {
+                auto& filters = sourceChain(hash).filters;
+                filters.erase(std::remove(filters.begin(), filters.end(), filter), filters.end());
+            });
+        }
+    }
+    std::shared_ptr<const audio::AudioLevelMeter>
+    GenericAudioMixer::sourceLevelMeter(std::weak_ptr<ISource> source)
+    {
+        std::shared_ptr<const audio::AudioLevelMeter> meter;
+        auto s = source.lock();
+        if(s) {
+            auto hash = std::hash<std::shared_ptr<ISource>>()(s);
+
+            m_mixQueue.enqueue_sync([&]() {
+                meter = sourceChain(hash).meter;
+            });
+        }
+        return meter;
+    }
+    GenericAudioMixer::SourceChain&
+    GenericAudioMixer::sourceChain(std::size_t hash)
+    {
+        auto& chain = m_sourceChains[hash];
+        if(!chain) {
+            chain.reset(new SourceChain());
+            chain->meter = std::make_shared<audio::AudioLevelMeter>();
+        }
+        return *chain;
+    }
+    void
+    GenericAudioMixer::setSilenceThreshold(float thresholdInDb)
+    {
+        m_silenceThreshold = powf(10.f, thresholdInDb / 20.f);
+    }
+    void
     GenericAudioMixer::setChannelCount(int channelCount)
     {
-        m_outChannelCount = channelCount;
+        m_outChannelCount = std::max(1, std::min(channelCount, audio::kMaxAudioChannels));
     }
     void
     GenericAudioMixer::setFrequencyInHz(float frequencyInHz)
@@ -397,77 +405,120 @@ namespace videocore {
         m_outFrequencyInHz = frequencyInHz;
     }
 
+    void
+    GenericAudioMixer::updateDeliveredTime()
+    {
+        if(!m_lowLatency.load() || m_lastSampleTime.empty()) {
+            return;
+        }
+        const auto us = std::chrono::microseconds(static_cast<long long>(m_frameDuration * 1000000.));
+        
+        // A source that has not delivered anything within the lookahead span is considered inactive and
+        // must not hold back the output.
+        auto newest = m_lastSampleTime.begin()->second;
+        for ( auto & it : m_lastSampleTime ) {
+            newest = std::max(newest, it.second);
+        }
+        const auto activeThreshold = newest - us * (m_lookaheadDepth + 1);
+        auto delivered = newest;
+        for ( auto & it : m_lastSampleTime ) {
+            if(it.second >= activeThreshold) {
+                delivered = std::min(delivered, it.second);
+            }
+        }
+        m_deliveredUntil = std::chrono::duration_cast<std::chrono::microseconds>(delivered - m_epoch).count();
+        m_mixThreadCond.notify_one();
+    }
+    void
+    GenericAudioMixer::emitOutgoingWindow()
+    {
+        MixWindow* window = m_outgoingWindow;
+        const auto windowEnd = window->start + std::chrono::microseconds(static_cast<long long>(m_frameDuration * 1000000.));
+        
+        m_nextMixTime = window->start;
+        
+        // The master levels are measured here rather than in mixAndMeasure: a window is written by every
+        // source in several partial buffers, so its samples are only final once it is emitted.  The pass
+        // reads the window once per frame duration.  The levels double as the silence check: the window is
+        // silent if no channel peaks above the threshold.
+        audio::LevelAccumulator levels;
+        audio::measure((const int16_t*)window->buffer, window->size / m_bytesPerSample, m_outChannelCount, levels);
+        m_masterMeter->publish(levels, m_outChannelCount);
+        
+        const float peak = *std::max_element(levels.peak, levels.peak + m_outChannelCount);
+        const bool silent = peak < m_silenceThreshold.load(std::memory_order_relaxed);
+        
+        AudioBufferMetadata md ( std::chrono::duration_cast<std::chrono::milliseconds>(window->start - m_epoch).count() );
+        std::shared_ptr<videocore::ISource> blank;
+        
+        md.setData(m_outFrequencyInHz, m_outBitsPerChannel, m_outChannelCount, 0, 0, (int)window->size, false, false, blank, silent);
+        auto out = m_output.lock();
+        
+        if(out) {
+            out->pushBuffer(window->buffer, window->size, md);
+        }
+        window->clear();
+        
+        m_outgoingWindow = window->next;
+        m_outgoingWindow->start = windowEnd;
+    }
     void
     GenericAudioMixer::mixThread()
     {
         const auto us = std::chrono::microseconds(static_cast<long long>(m_frameDuration * 1000000.)) ;
+        const auto lookahead = us * m_lookaheadDepth;
 
         const auto start = m_epoch;
         
         m_nextMixTime = start;
         m_currentWindow->start = start;
         m_currentWindow->next->start = start + us;
+        m_outgoingWindow = m_currentWindow;
         
         while(!m_exiting.load()) {
             std::unique_lock<std::mutex> l(m_mixMutex);
 
             auto now = std::chrono::steady_clock::now();
             
-            if( now >= m_currentWindow->next->start ) {
-                
-                auto currentTime = m_nextMixTime;
-                
-                
-                MixWindow* currentWindow = m_currentWindow;
-                MixWindow* nextWindow = currentWindow->next;
-                
-                nextWindow->start = currentWindow->start + us;
-                nextWindow->next->start = nextWindow->start + us;
-                
-                m_nextMixTime = currentWindow->start;
+            // Keep m_currentWindow on the window that covers the current time.  If the thread fell a whole ring
+            // behind, the oldest window goes out now rather than being lapped and overwritten.
+            while( now >= m_currentWindow->next->start ) {
+                MixWindow* next = m_currentWindow->next;
+                if(next->next == m_outgoingWindow && m_outgoingWindow != next) {
+                    emitOutgoingWindow();
+                }
+                m_currentWindow = next;
+                m_currentWindow->next->start = m_currentWindow->start + us;
+            }
+            
+            // Emit every window that is either past its deadline or, in low-latency mode, has been delivered
+            // by every active source.  The window covering the current time may go out early, but never
+            // anything beyond it.
+            while( m_outgoingWindow != m_currentWindow->next ) {
+                MixWindow* window = m_outgoingWindow;
+                const auto windowEnd = window->start + us;
                 
-                AudioBufferMetadata md ( std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_epoch).count() );
-                std::shared_ptr<videocore::ISource> blank;
-                    
-                md.setData(m_outFrequencyInHz, m_outBitsPerChannel, m_outChannelCount, 0, 0, (int)currentWindow->size, false, false, blank);
-                auto out = m_output.lock();
+                const bool deadline = (now >= windowEnd + lookahead);
+                const bool delivered = m_lowLatency.load() &&
+                        m_deliveredUntil.load() >= std::chrono::duration_cast<std::chrono::microseconds>(windowEnd - m_epoch).count();
                 
-                if(out && m_outgoingWindow) {
-                    out->pushBuffer(m_outgoingWindow->buffer, m_outgoingWindow->size, md);
-                    m_outgoingWindow->clear();
+                if(!deadline && !delivered) {
+                    break;
                 }
-                m_outgoingWindow = currentWindow;
-               
-                m_currentWindow = nextWindow;
+                emitOutgoingWindow();
                 
+                if(window == m_currentWindow) {
+                    break;
+                }
             }
             if(!m_exiting.load()) {
-                m_mixThreadCond.wait_until(l, m_currentWindow->next->start);
+                auto wakeTime = m_currentWindow->next->start;
+                if(m_outgoingWindow != m_currentWindow->next) {
+                    wakeTime = std::min(wakeTime, m_outgoingWindow->start + us + lookahead);
+                }
+                m_mixThreadCond.wait_until(l, wakeTime);
             }
         }
         DLog("Exiting audio mixer...\n");
     }
-    void
-    GenericAudioMixer::deinterleaveDefloat(float *inBuff,
-                                           short *outBuff,
-                                           unsigned sampleCount,
-                                           unsigned channelCount)
-    {
-        unsigned offset = sampleCount;
-
-
-        const float mult = float(0x7FFF);
-        
-        if(channelCount == 2) {
-            for ( int i = 0 ; i < sampleCount ; i+=2 ) {
-                outBuff[i] = short(inBuff[i] * mult);
-                outBuff[i+1] = short(inBuff[i+offset] * mult);
-            }
-        } else {
-            for (int i = 0 ; i < sampleCount ; i++ ) {
-                outBuff[i] = short(std::min(1.f,std::max(-1.f,inBuff[i])) * mult);
-            }
-        }
-
-    }
 }
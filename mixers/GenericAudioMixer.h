@@ -30,8 +30,11 @@
 #include <videocore/mixers/IAudioMixer.hpp>
 #include <videocore/system/Buffer.hpp>
 #include <videocore/system/JobQueue.hpp>
+#include <videocore/filters/Audio/GainRampAudioFilter.h>
+#include <videocore/system/audio/AudioLevelMeter.h>
 
 #include <map>
+#include <vector>
 #include <thread>
 #include <mutex>
 
@@ -107,6 +110,33 @@ namespace videocore {
         void setSourceGain(std::weak_ptr<ISource> source,
                            float gain);
 
+        /*! IAudioMixer::addSourceFilter */
+        void addSourceFilter(std::weak_ptr<ISource> source,
+                             std::shared_ptr<IAudioFilter> filter);
+
+        /*! IAudioMixer::removeSourceFilter */
+        void removeSourceFilter(std::weak_ptr<ISource> source,
+                                std::shared_ptr<IAudioFilter> filter);
+
+        /*!
+         *  Returns the level meter of a source.  Levels are measured after the source's filters and its gain
+         *  (setSourceGain), as the source is mixed in, but before the mixer's -3dB headroom.  The meter can be
+         *  polled from any thread.
+         *
+         *  \param source  A smart pointer to the source.
+         */
+        std::shared_ptr<const audio::AudioLevelMeter> sourceLevelMeter(std::weak_ptr<ISource> source);
+
+        /*! Returns the level meter of the mixed output.  The meter can be polled from any thread. */
+        std::shared_ptr<const audio::AudioLevelMeter> masterLevelMeter() const { return m_masterMeter; };
+
+        /*!
+         *  Set the level below which an output window is flagged as silent (kAudioMetadataSilent).
+         *
+         *  \param thresholdInDb  The threshold in dBFS.  Defaults to about -72dBFS.
+         */
+        void setSilenceThreshold(float thresholdInDb);
+
         /*! IAudioMixer::setChannelCount */
         void setChannelCount(int channelCount);
 
@@ -116,6 +146,25 @@ namespace videocore {
         /*! IAudioMixer::setMinimumBufferDuration */
         virtual void setMinimumBufferDuration(const double duration) ;
 
+        /*!
+         *  Configure the mix window scheduling.  Must be called before start().
+         *
+         *  \param windowDuration  The duration of a single mix window, in seconds.  Defaults to the frameDuration
+         *                         passed to the constructor.
+         *  \param lookaheadDepth  The number of windows a window is held back before it is emitted.  Higher values
+         *                         tolerate more source jitter at the cost of latency.  Defaults to 1.
+         */
+        void setMixWindowParameters(double windowDuration, int lookaheadDepth);
+
+        /*!
+         *  Enable or disable low-latency mode.  In low-latency mode a window is emitted as soon as every active
+         *  source has delivered samples past the end of that window, and the lookahead depth only acts as a deadline
+         *  for sources that are late.
+         *
+         *  \param lowLatency  true to enable low-latency mode.
+         */
+        void setLowLatencyMode(bool lowLatency);
+
         /*! ITransform::setEpoch */
         void setEpoch(const std::chrono::steady_clock::time_point epoch) {
             m_epoch = epoch;
@@ -144,13 +193,43 @@ namespace videocore {
          */
         void mixThread();
 
-        
-        void deinterleaveDefloat(float* inBuff, short* outBuff, unsigned sampleCount, unsigned channelCount);
+        /*!
+         *  Push m_outgoingWindow to the output, clear it and move on to the next window.  Called on the mix thread
+         *  with m_mixMutex held.
+         */
+        void emitOutgoingWindow();
+
+        /*!
+         *  (Re)create the ring of mix windows using the current window duration and lookahead depth.
+         */
+        void allocateWindows();
+
+        /*!
+         *  Called on the mix queue after a source buffer has been mixed.  Records how far every active source
+         *  has delivered and wakes the mix thread if running in low-latency mode.
+         */
+        void updateDeliveredTime();
+
+        /*!
+         *  Per-source processing state.  Only accessed on the mix queue.
+         */
+        struct SourceChain {
+            filters::GainRampAudioFilter                gain;
+            std::vector<std::shared_ptr<IAudioFilter>>  filters;
+            std::shared_ptr<audio::AudioLevelMeter>     meter;
+            audio::LevelAccumulator                     levels;
+        };
+
+        /*!
+         *  Returns the processing chain for a source, creating it if needed.  Must be called on the mix queue.
+         */
+        SourceChain& sourceChain(std::size_t hash);
+
     protected:
         
         std::vector<std::shared_ptr<MixWindow>>                m_windows;
         MixWindow*                            m_currentWindow;
-        MixWindow*                            m_outgoingWindow;
+        MixWindow*                            m_outgoingWindow;     /* oldest window not yet emitted; m_mixMutex */
         
         JobQueue                              m_mixQueue;
         
@@ -161,6 +240,8 @@ namespace videocore {
         double m_frameDuration;
         double m_bufferDuration;
 
+        int    m_lookaheadDepth;
+
         
         std::thread m_mixThread;
         std::mutex  m_mixMutex;
@@ -168,7 +249,7 @@ namespace videocore {
 
         std::weak_ptr<IOutput> m_output;
 
-        std::map < std::size_t, float > m_inGain;
+        std::map < std::size_t, std::unique_ptr<SourceChain> > m_sourceChains;
         std::map < std::size_t, std::chrono::steady_clock::time_point > m_lastSampleTime;
         
         int m_outChannelCount;
@@ -177,6 +258,11 @@ namespace videocore {
         int m_bytesPerSample;
 
         std::atomic<bool> m_exiting;
+        std::atomic<bool> m_lowLatency;
+        std::atomic<int64_t> m_deliveredUntil; /* microseconds since m_epoch that all active sources have delivered */
+
+        std::shared_ptr<audio::AudioLevelMeter> m_masterMeter;
+        std::atomic<float>                      m_silenceThreshold;
         
         bool m_catchingUp;
 
@@ -0,0 +1,156 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Latency and jitter of GenericAudioMixer's output, with the default scheduling and in low-latency mode.
+ *
+ *  Two sources push 10ms buffers in real time, each late by a random 0-4ms.  For every window the mixer emits,
+ *  the time it arrives at the output is compared to the end of the audio it holds.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  mixers/GenericAudioMixer.cpp, the sources in system/audio/ and filters/Audio/GainRampAudioFilter.cpp.
+ */
+
+#include <videocore/mixers/GenericAudioMixer.h>
+#include <videocore/sources/ISource.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace videocore;
+
+namespace {
+
+    const int    kSampleRate = 48000;
+    const int    kChannels = 2;
+    const double kWindowDuration = 1024. / kSampleRate;
+    const int    kSourceFrames = 480;              // 10ms buffers
+    const auto   kRunTime = std::chrono::seconds(3);
+
+    class ToneSource : public ISource
+    {
+    public:
+        void setOutput(std::shared_ptr<IOutput> output) { m_output = output; };
+        std::weak_ptr<IOutput> m_output;
+    };
+
+    class LatencySink : public IOutput
+    {
+    public:
+        void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            if(stopped) {
+                return;
+            }
+            const auto end = epoch + std::chrono::milliseconds(int64_t(metadata.timestampDelta))
+                           + std::chrono::microseconds(int64_t(kWindowDuration * 1e6));
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - end).count());
+        }
+        std::mutex mutex;
+        bool stopped = false;
+        std::chrono::steady_clock::time_point epoch;
+        std::vector<double> latencies;
+    };
+
+    void runSource(std::shared_ptr<ToneSource> source, std::shared_ptr<GenericAudioMixer> mixer,
+                   std::chrono::steady_clock::time_point start, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> jitter(0, 4000);
+        std::vector<int16_t> samples(kSourceFrames * kChannels, 1000);
+
+        AudioBufferMetadata md(0.);
+        md.setData(kSampleRate, 16, kChannels, 0, kChannels * 2, kSourceFrames, false, false, source, false);
+
+        for ( int i = 0 ; start + std::chrono::milliseconds(10 * i) < start + kRunTime ; ++i ) {
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(10 * i) + std::chrono::microseconds(jitter(rng)));
+            mixer->pushBuffer((const uint8_t*)&samples[0], samples.size() * sizeof(int16_t), md);
+        }
+    }
+
+    void run(const char* name, bool lowLatency)
+    {
+        auto mixer = std::make_shared<GenericAudioMixer>(kChannels, kSampleRate, 16, kWindowDuration);
+        auto sink = std::make_shared<LatencySink>();
+        auto a = std::make_shared<ToneSource>();
+        auto b = std::make_shared<ToneSource>();
+
+        mixer->setMixWindowParameters(kWindowDuration, 1);
+        mixer->setLowLatencyMode(lowLatency);
+        mixer->registerSource(a);
+        mixer->registerSource(b);
+        mixer->setOutput(sink);
+
+        const auto start = std::chrono::steady_clock::now();
+        sink->epoch = start;
+        mixer->setEpoch(start);
+        mixer->start();
+
+        std::thread ta(runSource, a, mixer, start, 1);
+        std::thread tb(runSource, b, mixer, start, 2);
+        ta.join();
+        tb.join();
+
+        // The mixer is left running until exit: destroying a JobQueue right after mark_exiting() can block on
+        // the non-GCD path.
+        new std::shared_ptr<GenericAudioMixer>(mixer);
+
+        std::vector<double> l;
+        {
+            std::lock_guard<std::mutex> lock(sink->mutex);
+            sink->stopped = true;
+            // Skip the first half second while the sources settle.
+            l.assign(sink->latencies.begin() + std::min<size_t>(sink->latencies.size(), 24), sink->latencies.end());
+        }
+        if(l.empty()) {
+            printf("%-12s no output\n", name);
+            return;
+        }
+        double mean = 0.;
+        for ( double v : l ) mean += v;
+        mean /= l.size();
+        double var = 0.;
+        for ( double v : l ) var += (v - mean) * (v - mean);
+        std::sort(l.begin(), l.end());
+
+        printf("%-12s windows %4zu  latency after window end: mean %6.2fms  p50 %6.2fms  p99 %6.2fms  jitter (sd) %5.2fms\n",
+               name, l.size(), mean, l[l.size() / 2], l[l.size() * 99 / 100], std::sqrt(var / l.size()));
+    }
+}
+
+int main()
+{
+    run("default", false);
+    run("low-latency", true);
+    return 0;
+}
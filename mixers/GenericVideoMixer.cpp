@@ -0,0 +1,647 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/mixers/GenericVideoMixer.h>
+#include <videocore/system/util.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Output buffers that may be in flight downstream before the compositor starts dropping frames.
+static const size_t kMaxOutputBuffers = 4;
+
+// Stripes are never thinner than this, so that per-stripe overhead stays small on tiny frames.
+static const int kMinStripeRows = 16;
+
+// Stripes per thread; more than one evens out layers that only cover part of the frame.
+static const int kStripesPerThread = 2;
+
+// Mixes a layer has to stay unchanged before it is flattened into a cache, so that a source which skips the odd
+// frame does not cause the caches to be rebuilt.
+static const int kMinStaticFrames = 3;
+
+// Unchanged frames pushed at the full frame rate before it drops to one per static frame interval.
+static const int kStaticFramesBeforeThrottle = 8;
+
+static const double kDefaultStaticFrameInterval = 0.5;
+
+// Matches the clear colour of GLESVideoMixer (0.05, 0.05, 0.07, 1.0), stored as BGRA.
+static const uint32_t kBackgroundPixel = 0xFF0D0D12;
+
+namespace videocore {
+
+    GenericVideoMixer::GenericVideoMixer(int frame_w,
+                                         int frame_h,
+                                         double frameDuration)
+    : m_filterFactory(kFilterBackendCPU),
+    m_compositeQueue("com.videocore.composite.cpu"),
+    m_bufferDuration(frameDuration),
+    m_frameW(frame_w),
+    m_frameH(frame_h),
+    m_backgroundEnd(0),
+    m_foregroundBegin(0),
+    m_damageBegin(0),
+    m_damageEnd(0),
+    m_structureChanged(true),
+    m_staticFrames(0),
+    m_outputPool(frame_w, frame_h, kVCPixelBufferFormat32BGRA, kMaxOutputBuffers),
+    m_epoch(std::chrono::steady_clock::now()),
+    m_exiting(false),
+    m_mixing(false),
+    m_shouldSync(false),
+    m_parallelism(0),
+    m_staticFrameInterval(kDefaultStaticFrameInterval)
+    {
+    }
+    GenericVideoMixer::~GenericVideoMixer()
+    {
+        m_output.reset();
+        m_exiting = true;
+        m_mixThreadCond.notify_all();
+
+        if(m_mixThread.joinable()) {
+            m_mixThread.join();
+        }
+        m_compositeQueue.mark_exiting();
+        m_compositeQueue.enqueue_sync([](){});
+    }
+    void
+    GenericVideoMixer::start()
+    {
+        m_mixThread = std::thread([this](){ this->mixThread(); });
+    }
+    void
+    GenericVideoMixer::registerSource(std::shared_ptr<ISource> source,
+                                      size_t bufferSize)
+    {
+        const auto h = std::hash< std::shared_ptr<ISource> >()(source);
+
+        std::lock_guard<std::mutex> l(m_sourceMutex);
+        for ( auto & it : m_sources ) {
+            if(hash(it) == h) {
+                return;
+            }
+        }
+        m_sources.push_back(source);
+        m_structureChanged = true;
+    }
+    void
+    GenericVideoMixer::unregisterSource(std::shared_ptr<ISource> source)
+    {
+        const auto h = std::hash< std::shared_ptr<ISource> >()(source);
+
+        std::lock_guard<std::mutex> l(m_sourceMutex);
+        for ( auto it = m_sources.begin() ; it != m_sources.end() ; ++it ) {
+            if(hash(*it) == h) {
+                m_sources.erase(it);
+                break;
+            }
+        }
+        m_sourceLayers.erase(h);
+        m_sourceFilters.erase(h);
+        m_structureChanged = true;
+
+        for ( auto & layer : m_layerMap ) {
+            auto iit = std::find(layer.second.begin(), layer.second.end(), h);
+            if(iit != layer.second.end()) {
+                layer.second.erase(iit);
+            }
+        }
+    }
+    void
+    GenericVideoMixer::pushBuffer(const uint8_t *const data,
+                                  size_t size,
+                                  videocore::IMetadata &metadata)
+    {
+        VideoBufferMetadata & md = dynamic_cast<VideoBufferMetadata&>(metadata);
+        const int zIndex = md.getData<kVideoMetadataZIndex>();
+        const auto h = hash(md.getData<kVideoMetadataSource>());
+
+        auto inPixelBuffer = *(std::shared_ptr<IPixelBuffer>*)data;
+
+        std::lock_guard<std::mutex> l(m_sourceMutex);
+
+        Layer& layer = m_sourceLayers[h];
+        if(layer.buffer && layer.buffer != inPixelBuffer) {
+            layer.buffer->setState(kVCPixelBufferStateAvailable);
+        }
+        inPixelBuffer->setState(kVCPixelBufferStateAcquired);
+
+        const glm::mat4 & matrix = md.getData<kVideoMetadataMatrix>();
+        const bool blends = md.getData<kVideoMetadataBlends>();
+        if(layer.buffer != inPixelBuffer || layer.matrix != matrix || layer.blends != blends) {
+            ++layer.generation;
+        }
+        if(layer.buffer && layer.zIndex != zIndex) {
+            auto & oldZ = m_layerMap[layer.zIndex];
+            oldZ.erase(std::remove(oldZ.begin(), oldZ.end(), h), oldZ.end());
+            m_structureChanged = true;
+        }
+        layer.buffer = inPixelBuffer;
+        layer.matrix = matrix;
+        layer.blends = blends;
+        layer.zIndex = zIndex;
+
+        auto & z = m_layerMap[zIndex];
+        if(std::find(z.begin(), z.end(), h) == z.end()) {
+            z.push_back(h);
+            m_structureChanged = true;
+        }
+    }
+    void
+    GenericVideoMixer::setOutput(std::shared_ptr<IOutput> output)
+    {
+        m_output = output;
+    }
+    void
+    GenericVideoMixer::setSourceFilter(std::weak_ptr<ISource> source, IVideoFilter *filter)
+    {
+        std::lock_guard<std::mutex> l(m_sourceMutex);
+        m_sourceFilters[hash(source)] = filter;
+        m_structureChanged = true;
+    }
+    void
+    GenericVideoMixer::sync()
+    {
+        m_syncPoint = std::chrono::steady_clock::now();
+        m_shouldSync = true;
+    }
+    const std::size_t
+    GenericVideoMixer::hash(std::weak_ptr<ISource> source) const
+    {
+        const auto l = source.lock();
+        if (l) {
+            return std::hash< std::shared_ptr<ISource> >()(l);
+        }
+        return 0;
+    }
+    bool
+    GenericVideoMixer::affineMap(const glm::mat4& matrix, int srcWidth, int srcHeight, image::AffineMap& map) const
+    {
+        // 2D affine part of the matrix: clip = [a c; b d] * model + t
+        const float a = matrix[0][0], b = matrix[0][1];
+        const float c = matrix[1][0], d = matrix[1][1];
+        const float tx = matrix[3][0], ty = matrix[3][1];
+        const float det = a * d - b * c;
+
+        if(fabsf(det) < 1e-9f) {
+            return false;
+        }
+        const float sx = 2.f / m_frameW, sy = 2.f / m_frameH;
+
+        // Output pixel -> homogeneous coordinates -> source quad (-1..1) -> source pixel.
+        auto eval = [&](float x, float y, float& u, float& v) {
+            const float cx = (x + 0.5f) * sx - 1.f - tx;
+            const float cy = (y + 0.5f) * sy - 1.f - ty;
+            const float mx = ( d * cx - c * cy) / det;
+            const float my = (-b * cx + a * cy) / det;
+            u = (mx + 1.f) * 0.5f * srcWidth - 0.5f;
+            v = (my + 1.f) * 0.5f * srcHeight - 0.5f;
+        };
+        float u1, v1, u2, v2;
+        eval(0.f, 0.f, map.u0, map.v0);
+        eval(1.f, 0.f, u1, v1);
+        eval(0.f, 1.f, u2, v2);
+
+        map.ux = u1 - map.u0;
+        map.vx = v1 - map.v0;
+        map.uy = u2 - map.u0;
+        map.vy = v2 - map.v0;
+
+        // Snap near-integral values so pure translations take the copy path.
+        auto snap = [](float& f) { const float r = roundf(f); if(fabsf(f - r) < 1e-4f) f = r; };
+        snap(map.ux); snap(map.vx); snap(map.uy); snap(map.vy);
+        snap(map.u0); snap(map.v0);
+        return true;
+    }
+    void
+    GenericVideoMixer::footprint(Layer& layer) const
+    {
+        const glm::mat4& m = layer.matrix;
+        float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+
+        // Map the corners of the source quad to output pixel centres.
+        for ( int i = 0 ; i < 4 ; ++i ) {
+            const float mx = (i & 1) ? 1.f : -1.f;
+            const float my = (i & 2) ? 1.f : -1.f;
+            const float x = ((m[0][0] * mx + m[1][0] * my + m[3][0]) + 1.f) * 0.5f * m_frameW - 0.5f;
+            const float y = ((m[0][1] * mx + m[1][1] * my + m[3][1]) + 1.f) * 0.5f * m_frameH - 0.5f;
+            minX = std::min(minX, x); maxX = std::max(maxX, x);
+            minY = std::min(minY, y); maxY = std::max(maxY, y);
+        }
+        // A pixel whose centre lies within half a pixel of the quad can pick up a bilinear tap.
+        auto clamp = [](float f, int hi) { return int(std::max(0.f, std::min(f, float(hi)))); };
+        layer.colBegin = clamp(floorf(minX) - 1.f, m_frameW);
+        layer.colEnd   = clamp(ceilf(maxX) + 2.f, m_frameW);
+        layer.rowBegin = clamp(floorf(minY) - 1.f, m_frameH);
+        layer.rowEnd   = clamp(ceilf(maxY) + 2.f, m_frameH);
+    }
+    void
+    GenericVideoMixer::composite(std::chrono::steady_clock::time_point time)
+    {
+        auto out = m_outputPool.dequeue();
+        if(!out) {
+            DLog("GenericVideoMixer: all output buffers are in use, dropping frame\n");
+            return;
+        }
+
+        bool structureChanged = false;
+        m_layers.clear();
+        {
+            std::lock_guard<std::mutex> l(m_sourceMutex);
+            for ( auto & z : m_layerMap ) {
+                for ( auto h : z.second ) {
+                    auto it = m_sourceLayers.find(h);
+                    if(it != m_sourceLayers.end() && it->second.buffer) {
+                        m_layers.push_back(it->second);
+
+                        auto fit = m_sourceFilters.find(h);
+                        m_layers.back().source = h;
+                        m_layers.back().filter = (fit != m_sourceFilters.end()) ? dynamic_cast<ICPUVideoFilter*>(fit->second) : nullptr;
+                    }
+                }
+            }
+            structureChanged = m_structureChanged;
+            m_structureChanged = false;
+        }
+
+        auto & pool = WorkerPool::shared();
+        const size_t threads = std::min(m_parallelism ? m_parallelism.load() : pool.threadCount() + 1,
+                                        pool.threadCount() + 1);
+
+        // Resolve the placement of every layer up front; the stripes only read m_layers.
+        size_t maxSrcWidth = 0;
+        for ( auto it = m_layers.begin() ; it != m_layers.end() ; ) {
+            IPixelBuffer& src = *it->buffer;
+            const auto format = src.pixelFormat();
+            if((format != kVCPixelBufferFormat32BGRA && format != kVCPixelBufferFormat32RGBA) ||
+               !affineMap(it->matrix, src.width(), src.height(), it->map)) {
+                it = m_layers.erase(it);
+                continue;
+            }
+            if(it->filter && !it->filter->passthrough()) {
+                filterLayer(*it, threads);
+            } else {
+                it->filter = nullptr;
+            }
+            footprint(*it);
+            maxSrcWidth = std::max(maxSrcWidth, size_t(src.width()));
+            ++it;
+        }
+
+        // Damage: rows covered by a changed layer before or after the change.  Filtered layers are redrawn
+        // every frame since their output is not tied to the source buffer.
+        int damageBegin = m_frameH, damageEnd = 0;
+        auto damage = [&](int begin, int end) {
+            if(begin < end) {
+                damageBegin = std::min(damageBegin, begin);
+                damageEnd = std::max(damageEnd, end);
+            }
+        };
+        if(structureChanged || !m_lastOutput) {
+            damage(0, m_frameH);
+        }
+        std::vector<char> cacheable(m_layers.size(), 0);
+        for ( size_t i = 0 ; i < m_layers.size() ; ++i ) {
+            const Layer& layer = m_layers[i];
+            auto st = m_layerStates.find(layer.source);
+            const bool known = st != m_layerStates.end();
+            LayerState& state = known ? st->second : m_layerStates[layer.source];
+
+            if(!known || layer.filter || state.generation != layer.generation) {
+                damage(layer.rowBegin, layer.rowEnd);
+                if(known) {
+                    damage(state.rowBegin, state.rowEnd);
+                }
+                state.staticFrames = 0;
+            } else if(state.staticFrames < kMinStaticFrames) {
+                ++state.staticFrames;
+            }
+            state.generation = layer.generation;
+            state.rowBegin = layer.rowBegin;
+            state.rowEnd = layer.rowEnd;
+            cacheable[i] = state.staticFrames >= kMinStaticFrames;
+        }
+        for ( auto it = m_layerStates.begin() ; it != m_layerStates.end() ; ) {
+            const auto h = it->first;
+            if(std::none_of(m_layers.begin(), m_layers.end(), [h](const Layer& l) { return l.source == h; })) {
+                damage(it->second.rowBegin, it->second.rowEnd);
+                it = m_layerStates.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // The static layers below the first changing one form the background, the static blending layers
+        // above the last changing one form the foreground.
+        const size_t count = m_layers.size();
+        size_t backgroundEnd = 0;
+        while(backgroundEnd < count && cacheable[backgroundEnd]) {
+            ++backgroundEnd;
+        }
+        size_t foregroundBegin = count;
+        while(foregroundBegin > backgroundEnd && cacheable[foregroundBegin - 1] && m_layers[foregroundBegin - 1].blends) {
+            --foregroundBegin;
+        }
+        m_backgroundEnd = backgroundEnd;
+        m_foregroundBegin = foregroundBegin;
+        m_damageBegin = damageBegin;
+        m_damageEnd = damageEnd;
+
+        const int stripes = std::max(1, std::min(int(threads) * kStripesPerThread, m_frameH / kMinStripeRows));
+        const int rowsPerStripe = (m_frameH + stripes - 1) / stripes;
+
+        if(m_scratch.size() < size_t(stripes)) {
+            m_scratch.resize(stripes);
+        }
+        for ( int i = 0 ; i < stripes ; ++i ) {
+            if(m_scratch[i].size() < m_frameW + maxSrcWidth) {
+                m_scratch[i].resize(m_frameW + maxSrcWidth);
+            }
+        }
+
+        // Drop the filter buffers of sources that have gone away.
+        for ( auto it = m_filterPools.begin() ; it != m_filterPools.end() ; ) {
+            const auto h = it->first;
+            if(std::none_of(m_layers.begin(), m_layers.end(), [h](const Layer& l) { return l.source == h && l.filter; })) {
+                it = m_filterPools.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for ( auto & layer : m_layers ) {
+            layer.buffer->lock(true);
+        }
+        if(damageBegin < damageEnd) {
+            updateCache(m_background, 0, backgroundEnd, true, stripes, threads);
+            updateCache(m_foreground, foregroundBegin, count, false, stripes, threads);
+        }
+
+        uint8_t* dst = (uint8_t*)out->baseAddress();
+        const size_t dstStride = out->bytesPerRowOfPlane(0);
+
+        pool.parallelFor(stripes, threads, [&](size_t i) {
+            const int rowBegin = int(i) * rowsPerStripe;
+            const int rowEnd = std::min(m_frameH, rowBegin + rowsPerStripe);
+            if(rowBegin < rowEnd) {
+                this->compositeRows(dst, dstStride, rowBegin, rowEnd, m_scratch[i]);
+            }
+        });
+
+        for ( auto & layer : m_layers ) {
+            layer.buffer->unlock(true);
+        }
+        m_layers.clear();
+        m_lastOutput = out;
+
+        // Only the redrawn rows can differ from the previous frame.
+        const bool unchanged = damageBegin >= damageEnd ||
+                               !m_frameHash.update(dst, dstStride, m_frameW, m_frameH, damageBegin, damageEnd);
+        m_staticFrames = unchanged ? m_staticFrames + 1 : 0;
+
+        const double interval = m_staticFrameInterval;
+        if(unchanged && interval > 0. && m_staticFrames > kStaticFramesBeforeThrottle &&
+           time - m_lastPushTime < std::chrono::duration<double>(interval)) {
+            return;
+        }
+
+        auto lout = m_output.lock();
+        if(lout) {
+            VideoFrameMetadata md(std::chrono::duration_cast<std::chrono::milliseconds>(time - m_epoch).count());
+            md.setData(unchanged);
+            out->setState(kVCPixelBufferStateEnqueued);
+            lout->pushBuffer((uint8_t*)&out, sizeof(out), md);
+            m_lastPushTime = time;
+        }
+    }
+    void
+    GenericVideoMixer::updateCache(LayerCache& cache, size_t begin, size_t end, bool opaque, int stripes, size_t threads)
+    {
+        std::vector<std::pair<std::size_t, uint64_t>> key;
+        for ( size_t i = begin ; i < end ; ++i ) {
+            key.emplace_back(m_layers[i].source, m_layers[i].generation);
+        }
+        if(key == cache.key) {
+            return;
+        }
+        cache.key.swap(key);
+        if(begin == end) {
+            return;
+        }
+        cache.pixels.resize(size_t(m_frameW) * m_frameH);
+
+        if(opaque) {
+            cache.rowBegin = 0; cache.rowEnd = m_frameH;
+            cache.colBegin = 0; cache.colEnd = m_frameW;
+        } else {
+            cache.rowBegin = m_frameH; cache.rowEnd = 0;
+            cache.colBegin = m_frameW; cache.colEnd = 0;
+            for ( size_t i = begin ; i < end ; ++i ) {
+                const Layer& layer = m_layers[i];
+                if(layer.rowBegin < layer.rowEnd && layer.colBegin < layer.colEnd) {
+                    cache.rowBegin = std::min(cache.rowBegin, layer.rowBegin);
+                    cache.rowEnd   = std::max(cache.rowEnd, layer.rowEnd);
+                    cache.colBegin = std::min(cache.colBegin, layer.colBegin);
+                    cache.colEnd   = std::max(cache.colEnd, layer.colEnd);
+                }
+            }
+            if(cache.rowBegin >= cache.rowEnd) {
+                cache.rowBegin = cache.rowEnd = cache.colBegin = cache.colEnd = 0;
+                return;
+            }
+        }
+
+        uint8_t* pixels = (uint8_t*)&cache.pixels[0];
+        const size_t stride = m_frameW * sizeof(uint32_t);
+        const int rowsPerStripe = (m_frameH + stripes - 1) / stripes;
+
+        WorkerPool::shared().parallelFor(stripes, threads, [&](size_t s) {
+            const int rowBegin = std::max(cache.rowBegin, int(s) * rowsPerStripe);
+            const int rowEnd = std::min(cache.rowEnd, int(s + 1) * rowsPerStripe);
+            if(rowBegin >= rowEnd) {
+                return;
+            }
+            image::fill32(pixels, stride, m_frameW, rowBegin, rowEnd, opaque ? kBackgroundPixel : 0);
+
+            for ( size_t i = begin ; i < end ; ++i ) {
+                const Layer& layer = m_layers[i];
+                const int layerBegin = std::max(rowBegin, layer.rowBegin);
+                const int layerEnd = std::min(rowEnd, layer.rowEnd);
+                if(layerBegin >= layerEnd) {
+                    continue;
+                }
+                IPixelBuffer& src = *layer.buffer;
+                const image::DrawMode mode = !opaque ? image::kDrawAccumulate :
+                                             (layer.blends ? image::kDrawBlend : image::kDrawReplace);
+                image::drawAffine(pixels, stride, m_frameW, layerBegin, layerEnd,
+                                  (const uint8_t*)src.baseAddress(), src.bytesPerRowOfPlane(0), src.width(), src.height(),
+                                  src.pixelFormat() == kVCPixelBufferFormat32RGBA,
+                                  layer.map, mode, &m_scratch[s][0]);
+            }
+        });
+    }
+    void
+    GenericVideoMixer::filterLayer(Layer& layer, size_t threads)
+    {
+        IPixelBuffer& src = *layer.buffer;
+        const int width = int(src.width()), height = int(src.height());
+
+        auto & filterPool = m_filterPools[layer.source];
+        if(!filterPool || filterPool->width() != width || filterPool->height() != height ||
+           filterPool->pixelFormat() != src.pixelFormat()) {
+            filterPool.reset(new PixelBufferPool(width, height, src.pixelFormat()));
+        }
+        auto filtered = filterPool->dequeue();
+        if(!filtered) {
+            return;
+        }
+        ICPUVideoFilter* filter = layer.filter;
+        filter->prepare(width, height);
+
+        src.lock(true);
+        const uint8_t* in = (const uint8_t*)src.baseAddress();
+        const size_t inStride = src.bytesPerRowOfPlane(0);
+        uint8_t* out = (uint8_t*)filtered->baseAddress();
+        const size_t outStride = filtered->bytesPerRowOfPlane(0);
+        const bool isRGBA = src.pixelFormat() == kVCPixelBufferFormat32RGBA;
+
+        const int stripes = std::max(1, std::min(int(threads) * kStripesPerThread, height / kMinStripeRows));
+        const int rowsPerStripe = (height + stripes - 1) / stripes;
+
+        for ( int pass = 0 ; pass < filter->passCount() ; ++pass ) {
+            WorkerPool::shared().parallelFor(stripes, threads, [&](size_t i) {
+                const int rowBegin = int(i) * rowsPerStripe;
+                const int rowEnd = std::min(height, rowBegin + rowsPerStripe);
+                if(rowBegin < rowEnd) {
+                    filter->processPass(pass, in, inStride, out, outStride, width, height, rowBegin, rowEnd, isRGBA);
+                }
+            });
+        }
+        src.unlock(true);
+
+        layer.buffer = filtered;
+    }
+    void
+    GenericVideoMixer::compositeRows(uint8_t* dst, size_t dstStride, int rowBegin, int rowEnd, std::vector<uint32_t>& scratch)
+    {
+        const int begin = std::max(rowBegin, std::min(rowEnd, m_damageBegin));
+        const int end = std::max(begin, std::min(rowEnd, m_damageEnd));
+
+        // Undamaged rows are unchanged from the previous frame.
+        if(m_lastOutput && m_lastOutput->baseAddress() != dst && (begin > rowBegin || end < rowEnd)) {
+            const uint8_t* last = (const uint8_t*)m_lastOutput->baseAddress();
+            const size_t lastStride = m_lastOutput->bytesPerRowOfPlane(0);
+            const size_t rowBytes = m_frameW * sizeof(uint32_t);
+
+            for ( int y = rowBegin ; y < begin ; ++y ) {
+                memcpy(dst + y * dstStride, last + y * lastStride, rowBytes);
+            }
+            for ( int y = end ; y < rowEnd ; ++y ) {
+                memcpy(dst + y * dstStride, last + y * lastStride, rowBytes);
+            }
+        }
+        if(begin >= end) {
+            return;
+        }
+
+        if(m_backgroundEnd > 0) {
+            const size_t stride = m_frameW * sizeof(uint32_t);
+            const uint8_t* background = (const uint8_t*)&m_background.pixels[0];
+            for ( int y = begin ; y < end ; ++y ) {
+                memcpy(dst + y * dstStride, background + y * stride, stride);
+            }
+        } else {
+            image::fill32(dst, dstStride, m_frameW, begin, end, kBackgroundPixel);
+        }
+
+        for ( size_t i = m_backgroundEnd ; i < m_foregroundBegin ; ++i ) {
+            const Layer& layer = m_layers[i];
+            const int layerBegin = std::max(begin, layer.rowBegin);
+            const int layerEnd = std::min(end, layer.rowEnd);
+            if(layerBegin >= layerEnd) {
+                continue;
+            }
+            IPixelBuffer& src = *layer.buffer;
+            image::drawAffine(dst, dstStride, m_frameW, layerBegin, layerEnd,
+                              (const uint8_t*)src.baseAddress(), src.bytesPerRowOfPlane(0), src.width(), src.height(),
+                              src.pixelFormat() == kVCPixelBufferFormat32RGBA,
+                              layer.map, layer.blends ? image::kDrawBlend : image::kDrawReplace, &scratch[0]);
+        }
+
+        if(m_foregroundBegin < m_layers.size() && m_foreground.colBegin < m_foreground.colEnd) {
+            const int foregroundBegin = std::max(begin, m_foreground.rowBegin);
+            const int foregroundEnd = std::min(end, m_foreground.rowEnd);
+            const int cols = m_foreground.colEnd - m_foreground.colBegin;
+
+            for ( int y = foregroundBegin ; y < foregroundEnd ; ++y ) {
+                image::blendPremultipliedRow((uint32_t*)(dst + y * dstStride) + m_foreground.colBegin,
+                                             &m_foreground.pixels[size_t(y) * m_frameW + m_foreground.colBegin], cols);
+            }
+        }
+    }
+    void
+    GenericVideoMixer::mixThread()
+    {
+        pthread_setname_np("com.videocore.compositeloop.cpu");
+
+        m_nextMixTime = m_epoch;
+
+        while(!m_exiting.load())
+        {
+            std::unique_lock<std::mutex> l(m_mutex);
+            const auto now = std::chrono::steady_clock::now();
+            const auto us = std::chrono::microseconds(static_cast<long long>(m_bufferDuration * 1000000.));
+
+            if(now >= m_nextMixTime) {
+
+                auto currentTime = m_nextMixTime;
+                if(!m_shouldSync) {
+                    m_nextMixTime += us;
+                } else {
+                    m_nextMixTime = m_syncPoint > m_nextMixTime ? m_syncPoint + us : m_nextMixTime + us;
+                }
+
+                // Skip the frame if the previous one is still being composited.
+                if(m_mixing.load()) {
+                    continue;
+                }
+                // Every output downstream is backed up (a split reports its least backed-up output), so don't
+                // composite the frame.  Outputs that can't keep up while others can skip frames themselves.
+                auto output = m_output.lock();
+                if(output && output->queuedDuration() > kMaxQueuedDuration) {
+                    continue;
+                }
+                m_mixing = true;
+                m_compositeQueue.enqueue([=]() {
+                    this->composite(currentTime);
+                    this->m_mixing = false;
+                });
+            }
+
+            m_mixThreadCond.wait_until(l, m_nextMixTime);
+        }
+    }
+}
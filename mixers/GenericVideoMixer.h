@@ -0,0 +1,270 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__GenericVideoMixer__
+#define __videocore__GenericVideoMixer__
+
+#include <videocore/mixers/IVideoMixer.hpp>
+#include <videocore/filters/ICPUVideoFilter.hpp>
+#include <videocore/system/JobQueue.hpp>
+#include <videocore/system/WorkerPool.hpp>
+#include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
+#include <videocore/system/pixelBuffer/PixelBufferPool.h>
+#include <videocore/system/image/Composite.h>
+#include <videocore/system/image/FrameHash.h>
+
+#include <map>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace videocore {
+
+    /*!
+     *  Portable CPU compositor.  Takes 32-bit BGRA or RGBA IPixelBuffer inputs and outputs a single BGRA
+     *  GenericPixelBuffer composited from the various sources, so graphs can be built without a GPU.
+     *
+     *  Sources push a pointer to a std::shared_ptr<IPixelBuffer> along with VideoBufferMetadata.  The z-index,
+     *  matrix and blends flag are interpreted exactly as iOS::GLESVideoMixer does: the source image covers the
+     *  homogeneous square (-1, -1) to (1, 1) and is placed by the 2D affine part of the matrix.  The output is
+     *  pushed the same way the inputs are, as a pointer to a std::shared_ptr<IPixelBuffer>.
+     *
+     *  filterFactory() hands out ICPUVideoFilter implementations of the built-in filters; a source's filter is
+     *  applied to its image before it is placed.
+     *
+     *  Work is limited to what changed.  A source is damaged when it pushes a different buffer, matrix or blend
+     *  flag; output rows that no damaged source covers (before or after the change) are copied from the previous
+     *  frame.  Layers that have stayed unchanged for a few frames are flattened into caches: an opaque background
+     *  of the static layers under the lowest damaged one, and a premultiplied foreground of the static blending
+     *  layers above the highest damaged one.  With a camera under a handful of static overlays, each frame then
+     *  draws the camera and a single foreground blend.  Sources that draw into a buffer they have already pushed
+     *  must push it again under a different buffer to be redrawn.
+     *
+     *  The redrawn rows are hashed to tell whether the frame differs from the previous one; identical frames are
+     *  flagged with kVideoFrameMetadataUnchanged in the VideoFrameMetadata pushed with them.  While the output
+     *  stays unchanged, the frame rate drops to one frame per setStaticFrameInterval().
+     */
+    class GenericVideoMixer : public IVideoMixer
+    {
+
+    public:
+        /*! Constructor.
+         *
+         *  \param frame_w          The width of the output frame
+         *  \param frame_h          The height of the output frame
+         *  \param frameDuration    The duration of time a frame is presented, in seconds. 30 FPS would be (1/30)
+         */
+        GenericVideoMixer(int frame_w,
+                          int frame_h,
+                          double frameDuration);
+
+        /*! Destructor */
+        ~GenericVideoMixer();
+
+        /*! IMixer::registerSource */
+        void registerSource(std::shared_ptr<ISource> source,
+                            size_t bufferSize = 0)  ;
+
+        /*! IMixer::unregisterSource */
+        void unregisterSource(std::shared_ptr<ISource> source);
+
+        /*! IVideoMixer::setSourceFilter.  Only ICPUVideoFilter instances are applied; others are ignored. */
+        void setSourceFilter(std::weak_ptr<ISource> source, IVideoFilter *filter);
+
+        /*! IVideoMixer::sync */
+        void sync();
+
+        /*! IVideoMixer::filterFactory */
+        FilterFactory& filterFactory() { return m_filterFactory; };
+
+        /*! IOutput::pushBuffer */
+        void pushBuffer(const uint8_t* const data,
+                        size_t size,
+                        IMetadata& metadata);
+
+        /*! ITransform::setOutput */
+        void setOutput(std::shared_ptr<IOutput> output);
+
+        /*! ITransform::setEpoch */
+        void setEpoch(const std::chrono::steady_clock::time_point epoch) {
+            m_epoch = epoch;
+            m_nextMixTime = epoch;
+        };
+
+        void start();
+
+        /*!
+         *  Set the number of threads used to composite each frame.  The frame is split into horizontal stripes
+         *  that are processed on WorkerPool::shared().
+         *
+         *  \param threadCount  The maximum number of threads, including the composite thread.  0 uses every core.
+         */
+        void setParallelism(size_t threadCount) { m_parallelism = threadCount; };
+
+        /*!
+         *  Set how often a frame is pushed while the output is unchanged.  The first few unchanged frames are
+         *  always pushed so the encoder can refine the static picture.
+         *
+         *  \param seconds  The interval between unchanged frames.  0 pushes every frame.  Defaults to 0.5s.
+         */
+        void setStaticFrameInterval(double seconds) { m_staticFrameInterval = seconds; };
+
+        /*!
+         *  Change the frame rate, for example to follow an AdaptationLadder.  Applies from the next frame.
+         *
+         *  \param frameDuration  The duration of a frame, in seconds.
+         */
+        void setFrameDuration(double frameDuration) { m_bufferDuration = frameDuration; };
+
+    protected:
+
+        struct Layer {
+            Layer() : blends(false), source(0), filter(nullptr), zIndex(0), generation(0) {};
+
+            std::shared_ptr<IPixelBuffer> buffer;
+            glm::mat4                     matrix;
+            bool                          blends;
+            image::AffineMap              map;
+            std::size_t                   source;
+            ICPUVideoFilter*              filter;
+            int                           zIndex;
+            uint64_t                      generation;   /* bumped whenever the layer's image or placement changes */
+            int                           rowBegin, rowEnd, colBegin, colEnd;   /* output pixels it may touch */
+        };
+
+        /*! Damage bookkeeping for a source, composite queue only. */
+        struct LayerState {
+            uint64_t generation;
+            int      staticFrames;
+            int      rowBegin, rowEnd;
+        };
+
+        /*! A run of static layers flattened into a single image. */
+        struct LayerCache {
+            std::vector<std::pair<std::size_t, uint64_t>> key;    /* source and generation of every cached layer */
+            std::vector<uint32_t>                         pixels;
+            int                                           rowBegin, rowEnd, colBegin, colEnd;
+        };
+
+        /*!
+         *  Hash a smart pointer to a source.
+         *
+         *  \return a hash based on the smart pointer to a source.
+         */
+        const std::size_t hash(std::weak_ptr<ISource> source) const;
+
+        /*! Start the compositor thread */
+        void mixThread();
+
+        /*!
+         *  Composite the current layers into an output buffer and push it downstream.  Runs on the composite queue.
+         *
+         *  \param time  The presentation time of the frame.
+         */
+        void composite(std::chrono::steady_clock::time_point time);
+
+        /*!
+         *  Replace a layer's buffer with the output of its filter.  Runs on the composite queue.
+         *
+         *  \param threads  The maximum number of threads to filter with.
+         */
+        void filterLayer(Layer& layer, size_t threads);
+
+        /*!
+         *  Produce rows [rowBegin, rowEnd) of the output: damaged rows are composited from the caches and the
+         *  uncached layers, the others are copied from the previous frame.  Runs on the worker pool.
+         *
+         *  \param scratch  Scratch space owned by the calling stripe.
+         */
+        void compositeRows(uint8_t* dst, size_t dstStride, int rowBegin, int rowEnd, std::vector<uint32_t>& scratch);
+
+        /*!
+         *  Rebuild a cache from layers [begin, end) of m_layers if they differ from the ones it holds.  An opaque
+         *  cache starts from the background colour; otherwise the layers are accumulated premultiplied.
+         */
+        void updateCache(LayerCache& cache, size_t begin, size_t end, bool opaque, int stripes, size_t threads);
+
+        /*! The bounding box of the output pixels a layer can touch. */
+        void footprint(Layer& layer) const;
+
+        /*!
+         *  Compute the mapping from output pixels to source pixels for a layer.
+         *
+         *  \return false if the matrix is degenerate.
+         */
+        bool affineMap(const glm::mat4& matrix, int srcWidth, int srcHeight, image::AffineMap& map) const;
+
+    protected:
+
+        FilterFactory m_filterFactory;
+        JobQueue      m_compositeQueue;
+
+        std::atomic<double> m_bufferDuration;
+
+        std::weak_ptr<IOutput> m_output;
+        std::vector< std::weak_ptr<ISource> > m_sources;
+
+        std::thread m_mixThread;
+        std::mutex  m_mutex;         /* guards the mix thread's wait */
+        std::mutex  m_sourceMutex;   /* guards the source state below */
+        std::condition_variable m_mixThreadCond;
+
+        int m_frameW;
+        int m_frameH;
+
+        std::map<int, std::vector< std::size_t >>       m_layerMap;
+        std::unordered_map<std::size_t, Layer>           m_sourceLayers;
+        std::unordered_map<std::size_t, IVideoFilter*>   m_sourceFilters;
+
+        std::vector<Layer>                         m_layers;        /* composite queue only */
+        std::unordered_map<std::size_t, LayerState> m_layerStates;  /* composite queue only */
+        LayerCache                                 m_background;    /* composite queue only */
+        LayerCache                                 m_foreground;    /* composite queue only */
+        std::shared_ptr<IPixelBuffer>              m_lastOutput;    /* composite queue only */
+        size_t                                     m_backgroundEnd;     /* per frame: m_layers [0, end) are cached */
+        size_t                                     m_foregroundBegin;   /* per frame: m_layers [begin, size) are cached */
+        int                                        m_damageBegin, m_damageEnd;   /* per frame: rows to composite */
+        bool                                       m_structureChanged;  /* guarded by m_sourceMutex */
+        image::FrameHash                           m_frameHash;     /* composite queue only */
+        int                                        m_staticFrames;  /* composite queue only: unchanged frames in a row */
+        std::chrono::steady_clock::time_point      m_lastPushTime;  /* composite queue only */
+        std::vector<std::vector<uint32_t>>         m_scratch;       /* composite queue only, one per stripe */
+        std::unordered_map<std::size_t, std::unique_ptr<PixelBufferPool>> m_filterPools;  /* composite queue only */
+        PixelBufferPool                            m_outputPool;
+
+        std::chrono::steady_clock::time_point m_syncPoint;
+        std::chrono::steady_clock::time_point m_epoch;
+        std::chrono::steady_clock::time_point m_nextMixTime;
+
+        std::atomic<bool> m_exiting;
+        std::atomic<bool> m_mixing;
+        std::atomic<bool> m_shouldSync;
+        std::atomic<size_t> m_parallelism;
+        std::atomic<double> m_staticFrameInterval;
+    };
+}
+#endif /* defined(__videocore__GenericVideoMixer__) */
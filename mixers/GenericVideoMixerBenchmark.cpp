@@ -0,0 +1,176 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Compositing throughput of GenericVideoMixer on one thread, at 1280x720 and 1920x1080 output with 1, 4 and
+ *  16 layers, then how a few of those cases scale from 1 to N threads (setParallelism).  Every layer is a 1280x720 BGRA frame covering the whole output, so 1080p is a 1.5x bilinear
+ *  upscale.  Layers either replace what is under them or blend at 50% alpha.
+ *
+ *  Every layer pushes a different buffer before every frame, so nothing is cached and every row is redrawn: the
+ *  worst case.  A camera under static overlays is also timed, where only the bottom layer changes.
+ *
+ *  Usage: GenericVideoMixerBenchmark [threads].  N defaults to every core.  Threads are taken from
+ *  WorkerPool::shared(), which has one per core, so N is limited to the machine's core count.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  mixers/GenericVideoMixer.cpp, the sources in system/image/ and system/pixelBuffer/, system/WorkerPool.cpp
+ *  and the library's FilterFactory.
+ */
+
+#include <videocore/mixers/GenericVideoMixer.h>
+#include <videocore/sources/ISource.hpp>
+#include <videocore/system/WorkerPool.hpp>
+#include <videocore/system/pixelBuffer/GenericPixelBuffer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace videocore;
+
+namespace {
+
+    const int kLayerWidth = 1280;
+    const int kLayerHeight = 720;
+    const int kFrames = 30;
+
+    class Layer : public ISource
+    {
+    public:
+        void setOutput(std::shared_ptr<IOutput> output) {};
+    };
+
+    class NullOutput : public IOutput
+    {
+    public:
+        /* The output buffer goes back to the mixer's pool when the last reference is dropped. */
+        void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata) {};
+    };
+
+    /* Drives composite() directly, without the mix thread's timing. */
+    class BenchmarkMixer : public GenericVideoMixer
+    {
+    public:
+        BenchmarkMixer(int width, int height) : GenericVideoMixer(width, height, 1. / 30.) {};
+
+        void compositeFrame(int frame) { composite(m_epoch + std::chrono::milliseconds(33 * frame)); };
+    };
+
+    std::shared_ptr<IPixelBuffer>
+    makeFrame(uint32_t seed, uint8_t alpha)
+    {
+        auto buffer = std::make_shared<GenericPixelBuffer>(kLayerWidth, kLayerHeight, kVCPixelBufferFormat32BGRA);
+        uint32_t* p = (uint32_t*)buffer->baseAddress();
+        for ( int i = 0 ; i < kLayerWidth * kLayerHeight ; ++i ) {
+            seed = seed * 1664525u + 1013904223u;
+            p[i] = (uint32_t(alpha) << 24) | (seed >> 8);
+        }
+        return buffer;
+    }
+
+    /*!
+     *  The best time of a frame over kFrames, in ms.  The first `changing` layers push a new buffer before each
+     *  frame; the others push theirs once.
+     */
+    double
+    run(int width, int height, int layerCount, int changing, bool blends, size_t threads = 1)
+    {
+        auto mixer = new BenchmarkMixer(width, height);
+        mixer->setParallelism(threads);
+        mixer->setStaticFrameInterval(0.);
+        mixer->setOutput(std::make_shared<NullOutput>());
+
+        // Two frames per layer to alternate between.
+        std::vector<std::shared_ptr<Layer>> sources;
+        std::vector<std::shared_ptr<IPixelBuffer>> frames;
+        for ( int i = 0 ; i < layerCount ; ++i ) {
+            sources.push_back(std::make_shared<Layer>());
+            mixer->registerSource(sources.back());
+            frames.push_back(makeFrame(2 * i + 1, blends ? 0x80 : 0xFF));
+            frames.push_back(makeFrame(2 * i + 2, blends ? 0x80 : 0xFF));
+        }
+
+        double best = 1e9;
+        for ( int frame = 0 ; frame < kFrames + 1 ; ++frame ) {
+            for ( int i = 0 ; i < layerCount ; ++i ) {
+                if(frame == 0 || i < changing) {
+                    VideoBufferMetadata md(0.);
+                    md.setData(i, glm::mat4(1.f), blends, sources[i]);
+                    auto& buffer = frames[2 * i + (frame & 1)];
+                    mixer->pushBuffer((const uint8_t*)&buffer, sizeof(buffer), md);
+                }
+            }
+            const auto start = std::chrono::steady_clock::now();
+            mixer->compositeFrame(frame);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(frame > 0) {
+                // The first frame allocates the output pool.
+                best = std::min(best, ms);
+            }
+        }
+        // The mixer is leaked: destroying a JobQueue that never ran can block on the non-GCD path.
+        return best;
+    }
+}
+
+int
+main(int argc, char** argv)
+{
+    const size_t available = WorkerPool::shared().threadCount() + 1;
+    const size_t maxThreads = std::min(available, argc > 1 ? size_t(std::max(1, atoi(argv[1]))) : available);
+
+    printf("1280x720 BGRA layers, one thread, best of %d frames\n", kFrames);
+    for ( auto size : { std::make_pair(1280, 720), std::make_pair(1920, 1080) } ) {
+        for ( bool blends : { false, true } ) {
+            printf("%4dx%-4d %-7s", size.first, size.second, blends ? "blend" : "replace");
+            for ( int layers : { 1, 4, 16 } ) {
+                const double ms = run(size.first, size.second, layers, layers, blends);
+                printf("  %2d layers %6.2f ms", layers, ms);
+            }
+            printf("\n");
+        }
+        const double camera = run(size.first, size.second, 4, 1, true);
+        printf("%4dx%-4d camera under 3 static blended overlays  %6.2f ms\n", size.first, size.second, camera);
+    }
+
+    printf("\nEvery layer blending and changing, 1 to %zu threads (%zu available)\n", maxThreads, available);
+    const struct { int width, height, layers; } cases[] = { { 1280, 720, 16 }, { 1920, 1080, 4 }, { 1920, 1080, 16 } };
+    for ( auto& c : cases ) {
+        printf("%4dx%-4d %2d layers", c.width, c.height, c.layers);
+        double single = 0.;
+        for ( size_t threads = 1 ; threads <= maxThreads ; ++threads ) {
+            const double ms = run(c.width, c.height, c.layers, c.layers, true, threads);
+            single = threads == 1 ? ms : single;
+            printf("  %zu: %6.2f ms (%.2fx)", threads, ms, single / ms);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -28,6 +28,7 @@
 #include <videocore/system/Buffer.hpp>
 #include <videocore/mixers/IMixer.hpp>
 #include <videocore/transforms/IMetadata.hpp>
+#include <videocore/filters/IAudioFilter.hpp>
 
 namespace videocore {
 
@@ -42,13 +43,14 @@ namespace videocore {
         kAudioMetadataNumberFrames,     /*!< Number of sample frames in the buffer. */
         kAudioMetadataUsesOSStruct,     /*!< Indicates that the audio is not raw but instead uses a platform-specific struct */
         kAudioMetadataLoops,            /*!< Indicates whether or not the buffer should loop. Currently ignored. */
-        kAudioMetadataSource            /*!< A smart pointer to the source. */
+        kAudioMetadataSource,           /*!< A smart pointer to the source. */
+        kAudioMetadataSilent            /*!< Indicates that every sample in the buffer is below the mixer's silence threshold. */
     };
 
     /*!
      *  Specifies the properties of the incoming audio buffer.
      */
-    typedef MetaData<'soun', int, int, int, int, int, int, bool, bool, std::weak_ptr<ISource> > AudioBufferMetadata;
+    typedef MetaData<'soun', int, int, int, int, int, int, bool, bool, std::weak_ptr<ISource>, bool > AudioBufferMetadata;
 
     class ISource;
 
@@ -69,6 +71,25 @@ namespace videocore {
         virtual void setSourceGain(std::weak_ptr<ISource> source,
                                    float gain) = 0;
 
+        /*!
+         *  Append a processor to the specified source's filter chain.  Filters run in the order they were added,
+         *  before the source gain is applied.
+         *
+         *  \param source  A smart pointer to the source to be modified
+         *  \param filter  The filter.  A filter instance must only be added to one source.
+         */
+        virtual void addSourceFilter(std::weak_ptr<ISource> source,
+                                     std::shared_ptr<IAudioFilter> filter) = 0;
+
+        /*!
+         *  Remove a processor from the specified source's filter chain.
+         *
+         *  \param source  A smart pointer to the source to be modified
+         *  \param filter  The filter to remove.
+         */
+        virtual void removeSourceFilter(std::weak_ptr<ISource> source,
+                                        std::shared_ptr<IAudioFilter> filter) = 0;
+
         /*!
          *  Set the channel count.
          *
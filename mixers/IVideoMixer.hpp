@@ -47,6 +47,16 @@ namespace videocore
      */
     typedef MetaData<'vide', int, glm::mat4, bool, std::weak_ptr<ISource>> VideoBufferMetadata;
     
+    /*! Enum values for the VideoFrameMetadata tuple */
+    enum {
+        kVideoFrameMetadataUnchanged, /*!< Indicates that the frame is identical to the previous frame pushed by the mixer. */
+    };
+    
+    /*!
+     *  Specifies the properties of a composited frame pushed by a video mixer.
+     */
+    typedef MetaData<'vfrm', bool> VideoFrameMetadata;
+    
     /*! IAudioMixer interface.  Defines the required interface methods for Video mixers (compositors). */
     class IVideoMixer : public IMixer
     {
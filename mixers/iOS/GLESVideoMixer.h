@@ -31,6 +31,7 @@
 #include <videocore/mixers/IVideoMixer.hpp>
 #include <videocore/system/JobQueue.hpp>
 #include <videocore/system/pixelBuffer/Apple/PixelBuffer.h>
+#include <videocore/system/image/FrameHash.h>
 
 #include <map>
 #include <thread>
@@ -128,6 +129,22 @@ namespace videocore { namespace iOS {
     public:
         
         void mixPaused(bool paused);
+        
+        /*!
+         *  Set how often a frame is pushed while the output is unchanged.  Frames are compared by hashing them on
+         *  the CPU; identical frames are flagged with kVideoFrameMetadataUnchanged.  The first few unchanged
+         *  frames are always pushed so the encoder can refine the static picture.
+         *
+         *  \param seconds  The interval between unchanged frames.  0 pushes every frame.  Defaults to 0.5s.
+         */
+        void setStaticFrameInterval(double seconds) { m_staticFrameInterval = seconds; };
+        
+        /*!
+         *  Change the frame rate, for example to follow an AdaptationLadder.  Applies from the next frame.
+         *
+         *  \param frameDuration  The duration of a frame, in seconds.
+         */
+        void setFrameDuration(double frameDuration) { m_bufferDuration = frameDuration; };
     private:
         /*!
          * Hash a smart pointer to a source.
@@ -162,7 +179,7 @@ namespace videocore { namespace iOS {
         FilterFactory m_filterFactory;
         JobQueue m_glJobQueue;
         
-        double m_bufferDuration;
+        std::atomic<double> m_bufferDuration;
         
         std::weak_ptr<IOutput> m_output;
         std::vector< std::weak_ptr<ISource> > m_sources;
@@ -203,6 +220,11 @@ namespace videocore { namespace iOS {
         
         bool              m_shouldSync;
         bool              m_catchingUp;
+        
+        image::FrameHash                      m_frameHash;      /* GL queue only */
+        int                                   m_staticFrames;   /* GL queue only: unchanged frames in a row */
+        std::chrono::steady_clock::time_point m_lastPushTime;   /* GL queue only */
+        std::atomic<double>                   m_staticFrameInterval;
     };
     
 }
@@ -40,6 +40,11 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+// Unchanged frames pushed at the full frame rate before it drops to one per static frame interval.
+static const int kStaticFramesBeforeThrottle = 8;
+
+static const double kDefaultStaticFrameInterval = 0.5;
+
 #define SYSTEM_VERSION_GREATER_THAN_OR_EQUAL_TO(v)  ([[[UIDevice currentDevice] systemVersion] compare:v options:NSNumericSearch] != NSOrderedAscending)
 
 
@@ -207,6 +212,8 @@ namespace videocore { namespace iOS {
     m_paused(false),
     m_glJobQueue("com.videocore.composite"),
     m_catchingUp(false),
+    m_staticFrames(0),
+    m_staticFrameInterval(kDefaultStaticFrameInterval),
     m_epoch(std::chrono::steady_clock::now())
     {
         PERF_GL_sync({
@@ -466,10 +473,6 @@ namespace videocore { namespace iOS {
     void
     GLESVideoMixer::mixThread()
     {
-        const auto us = std::chrono::microseconds(static_cast<long long>(m_bufferDuration * 1000000.));
-        const auto us_25 = std::chrono::microseconds(static_cast<long long>(m_bufferDuration * 250000.));
-        m_us25 = us_25;
-        
         pthread_setname_np("com.videocore.compositeloop");
         
         int current_fb = 0;
@@ -482,6 +485,8 @@ namespace videocore { namespace iOS {
         {
             std::unique_lock<std::mutex> l(m_mutex);
             const auto now = std::chrono::steady_clock::now();
+            const auto us = std::chrono::microseconds(static_cast<long long>(m_bufferDuration * 1000000.));
+            m_us25 = std::chrono::microseconds(static_cast<long long>(m_bufferDuration * 250000.));
             
             if(now >= (m_nextMixTime)) {
                 
@@ -496,6 +501,12 @@ namespace videocore { namespace iOS {
                 if(m_mixing.load() || m_paused.load()) {
                     continue;
                 }
+                // Every output downstream is backed up (a split reports its least backed-up output), so don't
+                // composite the frame.  Outputs that can't keep up while others can skip frames themselves.
+                auto output = m_output.lock();
+                if(output && output->queuedDuration() > kMaxQueuedDuration) {
+                    continue;
+                }
                 
                 locked[current_fb] = true;
                 
@@ -555,9 +566,24 @@ namespace videocore { namespace iOS {
                     
                     auto lout = this->m_output.lock();
                     if(lout) {
+                        CVPixelBufferRef frame = this->m_pixelBuffer[!current_fb];
+                        
+                        CVPixelBufferLockBaseAddress(frame, kCVPixelBufferLock_ReadOnly);
+                        const bool unchanged = !this->m_frameHash.update((const uint8_t*)CVPixelBufferGetBaseAddress(frame),
+                                                                         CVPixelBufferGetBytesPerRow(frame),
+                                                                         m_frameW, m_frameH, 0, m_frameH);
+                        CVPixelBufferUnlockBaseAddress(frame, kCVPixelBufferLock_ReadOnly);
                         
-                        MetaData<'vide'> md(std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_epoch).count());
-                        lout->pushBuffer((uint8_t*)this->m_pixelBuffer[!current_fb], sizeof(this->m_pixelBuffer[!current_fb]), md);
+                        this->m_staticFrames = unchanged ? this->m_staticFrames + 1 : 0;
+                        
+                        const double interval = this->m_staticFrameInterval;
+                        if(!unchanged || interval <= 0. || this->m_staticFrames <= kStaticFramesBeforeThrottle ||
+                           currentTime - this->m_lastPushTime >= std::chrono::duration<double>(interval)) {
+                            VideoFrameMetadata md(std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_epoch).count());
+                            md.setData(unchanged);
+                            lout->pushBuffer((uint8_t*)frame, sizeof(frame), md);
+                            this->m_lastPushTime = currentTime;
+                        }
                     }
                     this->m_mixing = false;
         
@@ -41,15 +41,19 @@
 namespace videocore
 {
     static const size_t kMaxSendbufferSize = 10 * 1024 * 1024; // 10 MB
+    static const int kMinKeyframeRequestIntervalMs = 1000;      // give the encoder time to answer before asking again
     
     RTMPSession::RTMPSession(std::string uri, RTMPSessionStateCallback callback)
     : m_streamOutRemainder(65536)
     , m_streamInBuffer(new PreallocBuffer(4096))
     , m_callback(callback)
     , m_bandwidthCallback(nullptr)
+    , m_keyframeRequestCallback(nullptr)
     , m_outChunkSize(128)
     , m_inChunkSize(128)
     , m_bufferSize(0)
+    , m_queuedTimestamp(0)
+    , m_sentTimestamp(0)
     , m_streamId(0)
     , m_numberOfInvokes(0)
     , m_state(kClientStateNone)
@@ -122,13 +126,26 @@ namespace videocore
     RTMPSession::setSessionParameters(videocore::IMetadata &parameters)
     {
         
-        RTMPSessionParameters_t& parms = dynamic_cast<RTMPSessionParameters_t&>(parameters);
-        m_bitrate = parms.getData<kRTMPSessionParameterVideoBitrate>();
-        m_frameDuration = parms.getData<kRTMPSessionParameterFrameDuration>();
-        m_frameHeight = parms.getData<kRTMPSessionParameterHeight>();
-        m_frameWidth = parms.getData<kRTMPSessionParameterWidth>();
-        m_audioSampleRate = parms.getData<kRTMPSessionParameterAudioFrequency>();
-        m_audioStereo = parms.getData<kRTMPSessionParameterStereo>();
+        const RTMPSessionParameters_t parms = dynamic_cast<RTMPSessionParameters_t&>(parameters);
+        
+        auto apply = [=]() {
+            m_bitrate = parms.getData<kRTMPSessionParameterVideoBitrate>();
+            m_frameDuration = parms.getData<kRTMPSessionParameterFrameDuration>();
+            m_frameHeight = parms.getData<kRTMPSessionParameterHeight>();
+            m_frameWidth = parms.getData<kRTMPSessionParameterWidth>();
+            m_audioSampleRate = parms.getData<kRTMPSessionParameterAudioFrequency>();
+            m_audioStereo = parms.getData<kRTMPSessionParameterStereo>();
+        };
+        
+        if(m_state == kClientStateSessionStarted) {
+            // Players already have onMetaData: send it again, queued ahead of any data pushed after this call.
+            m_jobQueue.enqueue([=]() {
+                apply();
+                this->sendHeaderPacket();
+            });
+        } else {
+            apply();
+        }
     }
     void
     RTMPSession::setBandwidthCallback(BandwidthCallback callback)
@@ -137,6 +154,19 @@ namespace videocore
         m_throughputSession.setThroughputCallback(callback);
     }
     void
+    RTMPSession::setKeyframeRequestCallback(KeyframeRequestCallback callback)
+    {
+        m_keyframeRequestCallback = callback;
+    }
+    void
+    RTMPSession::requestKeyframe(std::chrono::steady_clock::time_point now)
+    {
+        if(m_keyframeRequestCallback && now - m_lastKeyframeRequest >= std::chrono::milliseconds(kMinKeyframeRequestIntervalMs)) {
+            m_lastKeyframeRequest = now;
+            m_keyframeRequestCallback();
+        }
+    }
+    void
     RTMPSession::pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
     {
         if(m_ending) {
@@ -159,7 +189,7 @@ namespace videocore
                 std::vector<uint8_t> chunk;
                 chunk.reserve(size+64);
                 size_t len = buf->size();
-                size_t tosend = std::min(len, m_outChunkSize);
+                size_t tosend = std::min(len, size_t(m_outChunkSize));
                 uint8_t* p;
                 buf->read(&p, buf->size());
                 uint64_t ts = inMetadata.getData<kRTMPMetadataTimestamp>() ;
@@ -191,14 +221,14 @@ namespace videocore
                 p += tosend;
                 
                 while(len > 0) {
-                    tosend = std::min(len, m_outChunkSize);
+                    tosend = std::min(len, size_t(m_outChunkSize));
                     p[-1] = RTMP_CHUNK_TYPE_3 | (streamId & 0x1F);
                     
                     put_buff(chunk, p-1, tosend+1);
                     p+=tosend;
                     len-=tosend;
                 }
-                this->write(&chunk[0], chunk.size(), packetTime, inMetadata.getData<kRTMPMetadataIsKeyframe>() );
+                this->write(&chunk[0], chunk.size(), packetTime, inMetadata.getData<kRTMPMetadataIsKeyframe>(), ts );
             }
         });
     }
@@ -216,9 +246,12 @@ namespace videocore
         m_bufferSize = std::max(m_bufferSize + size, 0LL);
     }
     void
-    RTMPSession::write(uint8_t* data, size_t size, std::chrono::steady_clock::time_point packetTime, bool isKeyframe)
+    RTMPSession::write(uint8_t* data, size_t size, std::chrono::steady_clock::time_point packetTime, bool isKeyframe, int64_t timestamp)
     {
         if(size > 0) {
+            if(timestamp >= 0) {
+                m_queuedTimestamp = timestamp;
+            }
             std::shared_ptr<Buffer> buf = std::make_shared<Buffer>(size);
             buf->put(data, size);
             
@@ -228,8 +261,14 @@ namespace videocore
             if(isKeyframe) {
                 m_sentKeyframe = packetTime;
             }
-            if(m_bufferSize > kMaxSendbufferSize && isKeyframe) {
-                m_clearing = true;
+            if(m_bufferSize > kMaxSendbufferSize) {
+                // Everything queued before the next keyframe is dropped, so ask for one now rather than waiting
+                // for the end of the GOP.
+                if(isKeyframe) {
+                    m_clearing = true;
+                } else {
+                    requestKeyframe(packetTime);
+                }
             }
             m_networkQueue.enqueue([=]() {
                 size_t tosend = size;
@@ -254,10 +293,19 @@ namespace videocore
                     }
                 }
                 this->increaseBuffer(-int64_t(size));
+                if(timestamp >= 0) {
+                    this->m_sentTimestamp = timestamp;
+                }
             });
         }
         
     }
+    double
+    RTMPSession::queuedDuration()
+    {
+        // Audio and video timestamps are interleaved, so this can dip below zero for a moment.
+        return std::max(0., double(m_queuedTimestamp - m_sentTimestamp) / 1000.);
+    }
     void
     RTMPSession::dataReceived()
     {
@@ -1022,6 +1070,11 @@ namespace videocore
                 setClientState(kClientStateSessionStarted);
                 
                 m_throughputSession.start();
+                
+                // Viewers joining a new stream can only start decoding at a keyframe.
+                m_jobQueue.enqueue([=]() {
+                    this->requestKeyframe(std::chrono::steady_clock::now());
+                });
             }
         }
         
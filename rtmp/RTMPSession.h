@@ -36,6 +36,7 @@
 #include <queue>
 #include <map>
 #include <chrono>
+#include <atomic>
 
 #include <videocore/system/JobQueue.hpp>
 #include <cstdlib>
@@ -85,9 +86,28 @@ namespace videocore
         // Requires RTMPMetadata_t
         void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
         
+        /*!
+         *  Requires RTMPSessionParameters_t.  Once publishing has started, onMetaData is sent again with the new
+         *  values, e.g. when the encoder changes resolution.
+         */
         void setSessionParameters(IMetadata& parameters);
         void setBandwidthCallback(BandwidthCallback callback);
         
+        /*!
+         *  Set the callback used to ask for a keyframe: when publishing starts, and when the send buffer backs up so
+         *  far that queued data will be dropped up to the next keyframe.  Requests are at most one per second.
+         */
+        void setKeyframeRequestCallback(KeyframeRequestCallback callback);
+        
+        /*!
+         *  IOutput::queuedDuration.  The media time between the last message queued and the last one sent, or
+         *  dropped to clear the buffer.
+         */
+        double queuedDuration();
+        
+        /*! The size of outgoing chunks, for working out the overhead of the chunk headers.  Safe to call from any thread. */
+        size_t outChunkSize() const { return m_outChunkSize; };
+        
     private:
         
         // Deprecate sendPacket
@@ -96,7 +116,7 @@ namespace videocore
         
         
         void streamStatusChanged(StreamStatus_T status);
-        void write(uint8_t* data, size_t size, std::chrono::steady_clock::time_point packetTime = std::chrono::steady_clock::now(), bool isKeyframe = false);
+        void write(uint8_t* data, size_t size, std::chrono::steady_clock::time_point packetTime = std::chrono::steady_clock::now(), bool isKeyframe = false, int64_t timestamp = -1);
         void dataReceived();
         void setClientState(ClientState_t state);
         void handshake();
@@ -116,6 +136,7 @@ namespace videocore
         void sendSetBufferTime(int milliseconds);
         
         void increaseBuffer(int64_t size);
+        void requestKeyframe(std::chrono::steady_clock::time_point now);
         int  reassembleBuffer(uint8_t *p, int msgSize, int packageSize);
         int  tryReadOneMessage(uint8_t *msg, int msgsize, int from_offset);
 
@@ -157,15 +178,20 @@ namespace videocore
         
         RTMPSessionStateCallback        m_callback;
         BandwidthCallback               m_bandwidthCallback;
+        KeyframeRequestCallback         m_keyframeRequestCallback;
+        std::chrono::steady_clock::time_point m_lastKeyframeRequest;  /* m_jobQueue only */
         
         std::string                     m_playPath;
         std::string                     m_app;
         std::map<int32_t, std::string>  m_trackedCommands;
         
-        size_t          m_outChunkSize;
+        std::atomic<size_t> m_outChunkSize;
         size_t          m_inChunkSize;
         int64_t         m_bufferSize;
         
+        std::atomic<int64_t> m_queuedTimestamp;   /* ms; the last media message written */
+        std::atomic<int64_t> m_sentTimestamp;     /* ms; the last media message sent or dropped */
+        
         int32_t         m_streamId;
 //        int32_t         m_createStreamInvoke;
         int32_t         m_numberOfInvokes;
@@ -182,7 +182,8 @@ namespace videocore { namespace iOS {
                        inNumberFrames,
                        false,
                        false,
-                       shared_from_this());
+                       shared_from_this(),
+                       false);
             
             output->pushBuffer(data, data_size, md);
         }
@@ -0,0 +1,117 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/stream/AdaptationLadder.h>
+
+#include <algorithm>
+
+namespace videocore {
+
+    // Bits per pixel per frame bounding a rung's useful bitrates, for H.264 of camera video.
+    static const double kMinBitsPerPixel = 0.05;
+    static const double kMaxBitsPerPixel = 0.15;
+
+    // Rung sizes relative to the top rung, and their frame rate caps.
+    static const double kRungScales[]   = { 1., 2. / 3., 1. / 2., 1. / 3. };
+    static const int    kRungMaxFps[]   = { 60, 30, 24, 15 };
+
+    // Congested samples at the bottom of a rung before moving down.  The bandwidth callback comes every few
+    // seconds, so this is already slow enough to ignore a blip.
+    static const int kDownSwitchSamples = 2;
+
+    // Uncongested samples at the top of a rung before moving up, and the least time between a change and moving up.
+    static const int kUpSwitchSamples = 3;
+    static const std::chrono::seconds kMinUpSwitchInterval(20);
+
+    AdaptationLadder::AdaptationLadder(const std::vector<AdaptationRung>& rungs, int initialBitrate)
+    : m_rungs(rungs), m_index(0), m_upSamples(0), m_downSamples(0)
+    {
+        for ( size_t i = 1 ; i < m_rungs.size() ; ++i ) {
+            if(initialBitrate >= m_rungs[i].minBitrate) {
+                m_index = i;
+            }
+        }
+        m_lastChange = std::chrono::steady_clock::now();
+    }
+    std::vector<AdaptationRung>
+    AdaptationLadder::defaultRungs(int width, int height, int fps, int maxBitrate)
+    {
+        std::vector<AdaptationRung> rungs;
+
+        for ( int i = sizeof(kRungScales) / sizeof(kRungScales[0]) - 1 ; i >= 0 ; --i ) {
+            AdaptationRung rung;
+
+            // Even dimensions, as 4:2:0 needs.
+            rung.width = std::max(2, int(width * kRungScales[i] / 2. + 0.5) * 2);
+            rung.height = std::max(2, int(height * kRungScales[i] / 2. + 0.5) * 2);
+            rung.fps = i == 0 ? fps : std::min(fps, kRungMaxFps[i]);
+
+            const double pixelRate = double(rung.width) * rung.height * rung.fps;
+            rung.minBitrate = rungs.empty() ? 0 : int(pixelRate * kMinBitsPerPixel);
+            rung.maxBitrate = i == 0 ? maxBitrate : std::min(maxBitrate, int(pixelRate * kMaxBitsPerPixel));
+
+            if(rung.minBitrate <= maxBitrate) {
+                rungs.push_back(rung);
+            }
+        }
+        return rungs;
+    }
+    bool
+    AdaptationLadder::update(float rateVector, int bitrate, std::chrono::steady_clock::time_point now)
+    {
+        const size_t index = m_index;
+        const AdaptationRung& current = m_rungs[index];
+
+        m_downSamples = (index > 0 && rateVector < 0.f && bitrate <= current.minBitrate) ? m_downSamples + 1 : 0;
+        m_upSamples = (index + 1 < m_rungs.size() && rateVector >= 0.f && bitrate >= current.maxBitrate) ? m_upSamples + 1 : 0;
+
+        size_t next = index;
+
+        if(m_downSamples >= kDownSwitchSamples) {
+            // Straight to the rung the bitrate fits, in case bandwidth collapsed.
+            next = index - 1;
+            while(next > 0 && bitrate < m_rungs[next].minBitrate) {
+                --next;
+            }
+        } else if(m_upSamples >= kUpSwitchSamples && now - m_lastChange >= kMinUpSwitchInterval) {
+            next = index + 1;
+        }
+
+        if(next == index) {
+            return false;
+        }
+        m_index = next;
+        m_upSamples = m_downSamples = 0;
+        m_lastChange = now;
+        return true;
+    }
+    int
+    AdaptationLadder::clampBitrate(int bitrate) const
+    {
+        const AdaptationRung& current = rung();
+        return std::max(current.minBitrate, std::min(current.maxBitrate, bitrate));
+    }
+}
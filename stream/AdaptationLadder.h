@@ -0,0 +1,99 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__AdaptationLadder__
+#define __videocore__AdaptationLadder__
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace videocore {
+
+    /*! One video format the stream can be sent at, and the bitrates it suits. */
+    struct AdaptationRung
+    {
+        int width;
+        int height;
+        int fps;
+        int minBitrate;     /* bits per second.  Below this the rung below looks better. */
+        int maxBitrate;     /* bits per second.  Above this there is little to gain. */
+    };
+
+    /*!
+     *  Picks the video format to encode at as the available bandwidth changes.  The bitrate controller (the
+     *  bandwidth callback) keeps adjusting the bitrate; the ladder watches it and moves down a rung when the
+     *  bitrate has to go below the current rung's minimum, and up a rung when the bitrate has sat at the current
+     *  rung's maximum without congestion for a while.
+     *
+     *  Moving down is quick, since a congested stream stalls for viewers.  Moving up needs several samples in a
+     *  row and a minimum time since the last change, so that the stream does not flip between formats; each change
+     *  costs a keyframe.
+     */
+    class AdaptationLadder
+    {
+    public:
+        /*!
+         *  \param rungs          The formats, lowest first.
+         *  \param initialBitrate Picks the highest rung whose minimum bitrate it meets.
+         */
+        AdaptationLadder(const std::vector<AdaptationRung>& rungs, int initialBitrate);
+
+        /*!
+         *  A ladder for a stream whose best format is width x height at fps: that format and about 2/3, 1/2 and
+         *  1/3 of its size, at lower frame rates towards the bottom.  Bitrate ranges scale with the pixel rate,
+         *  and rungs that need more than maxBitrate are left out.
+         */
+        static std::vector<AdaptationRung> defaultRungs(int width, int height, int fps, int maxBitrate);
+
+        /*!
+         *  Feed one sample from the bandwidth callback.
+         *
+         *  \param rateVector   The direction the bitrate controller is moving: negative when congested.
+         *  \param bitrate      The encoder bitrate after the controller has adjusted it.
+         *  \param now          The time of the sample.
+         *
+         *  \return true if the rung changed.  Apply rung() to the pipeline and clamp the bitrate to its range.
+         */
+        bool update(float rateVector, int bitrate, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+        /*! The current rung.  Safe to call from any thread. */
+        const AdaptationRung& rung() const { return m_rungs[m_index]; };
+
+        /*! Clamp a bitrate to the current rung's range. */
+        int clampBitrate(int bitrate) const;
+
+    private:
+        std::vector<AdaptationRung>             m_rungs;
+        std::atomic<size_t>                     m_index;
+
+        int                                     m_upSamples;
+        int                                     m_downSamples;
+        std::chrono::steady_clock::time_point   m_lastChange;
+    };
+}
+
+#endif /* defined(__videocore__AdaptationLadder__) */
@@ -0,0 +1,145 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/stream/BitrateAllocator.h>
+#include <videocore/rtmp/RTMPTypes.h>
+
+#include <algorithm>
+
+namespace videocore {
+
+    // RTMPSession starts each message with a type 1 chunk header (basic header plus RTMPChunk_1) and each further
+    // chunk of it with a one byte type 3 header.  The first message of a chunk stream has a larger type 0 header,
+    // which is not worth counting.
+    static const double kMessageHeaderBytes = 1 + sizeof(RTMPChunk_1);
+    static const double kChunkHeaderBytes = 1;
+
+    // The bandwidth to allocate, relative to the throughput measured when congested and to the current rates when not.
+    static const double kCongestedBandwidthScale = 0.9;
+    static const double kProbeBandwidthScale = 1.1;
+
+    std::vector<int>
+    WeightedAllocationPolicy::allocate(int payloadBitrate, const std::vector<BitrateStream>& streams)
+    {
+        std::vector<int> bitrates;
+        std::vector<bool> open;
+        double remaining = payloadBitrate;
+
+        for ( auto& stream : streams ) {
+            bitrates.push_back(stream.minBitrate);
+            open.push_back(stream.maxBitrate > stream.minBitrate && stream.weight > 0.);
+            remaining -= stream.minBitrate;
+        }
+
+        // Each pass either uses up the remainder or fills at least one stream, so this ends.
+        while(remaining >= 1.) {
+            double totalWeight = 0.;
+            for ( size_t i = 0 ; i < streams.size() ; ++i ) {
+                if(open[i]) {
+                    totalWeight += streams[i].weight;
+                }
+            }
+            if(totalWeight <= 0.) {
+                break;
+            }
+            double handedOn = 0.;
+            for ( size_t i = 0 ; i < streams.size() ; ++i ) {
+                if(!open[i]) {
+                    continue;
+                }
+                const double share = remaining * streams[i].weight / totalWeight;
+                const double room = streams[i].maxBitrate - bitrates[i];
+
+                if(share >= room) {
+                    bitrates[i] = streams[i].maxBitrate;
+                    open[i] = false;
+                    handedOn += share - room;
+                } else {
+                    bitrates[i] += int(share);
+                }
+            }
+            remaining = handedOn;
+        }
+        return bitrates;
+    }
+
+    BitrateAllocator::BitrateAllocator(size_t chunkSize, std::unique_ptr<IBitrateAllocationPolicy> policy)
+    : m_policy(std::move(policy)), m_chunkSize(chunkSize)
+    {
+        if(!m_policy) {
+            m_policy.reset(new WeightedAllocationPolicy());
+        }
+    }
+    size_t
+    BitrateAllocator::addStream(const BitrateStream& stream)
+    {
+        m_streams.push_back(stream);
+        m_bitrates.push_back(stream.minBitrate);
+        return m_streams.size() - 1;
+    }
+    void
+    BitrateAllocator::setStreamRange(size_t stream, int minBitrate, int maxBitrate)
+    {
+        m_streams[stream].minBitrate = minBitrate;
+        m_streams[stream].maxBitrate = std::max(minBitrate, maxBitrate);
+    }
+    int
+    BitrateAllocator::wireBitrate(const std::vector<int>& bitrates) const
+    {
+        double total = 0.;
+        for ( size_t i = 0 ; i < m_streams.size() && i < bitrates.size() ; ++i ) {
+            const BitrateStream& stream = m_streams[i];
+            const double messageBits = 8. * (stream.tagHeaderBytes + kMessageHeaderBytes);
+
+            total += bitrates[i] * (1. + kChunkHeaderBytes / m_chunkSize) + stream.messagesPerSecond * messageBits;
+        }
+        return int(total);
+    }
+    int
+    BitrateAllocator::targetBandwidth(float vector, double predicted, const std::vector<int>& bitrates) const
+    {
+        const double wire = wireBitrate(bitrates);
+        if(vector >= 0) {
+            return int(wire * kProbeBandwidthScale);
+        }
+        // Before the first measurement there is nothing to back off to but the current rates.
+        const double measured = predicted > 0. ? predicted * 8. : wire;
+        return int(std::min(wire, measured) * kCongestedBandwidthScale);
+    }
+    std::vector<int>
+    BitrateAllocator::allocate(int bandwidth)
+    {
+        // Overhead is a fixed cost per message plus a type 3 header per chunk, which grows with the payload.
+        double fixed = 0.;
+        for ( auto& stream : m_streams ) {
+            fixed += stream.messagesPerSecond * 8. * (stream.tagHeaderBytes + kMessageHeaderBytes);
+        }
+        const double payload = std::max(0., (bandwidth - fixed) / (1. + kChunkHeaderBytes / m_chunkSize));
+
+        m_bitrates = m_policy->allocate(int(payload), m_streams);
+        return m_bitrates;
+    }
+}
@@ -0,0 +1,136 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__BitrateAllocator__
+#define __videocore__BitrateAllocator__
+
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+namespace videocore {
+
+    /*! One encoder whose bitrate a BitrateAllocator sets. */
+    struct BitrateStream
+    {
+        int    minBitrate;          /* bits per second.  Allocated even if the bandwidth can't carry it. */
+        int    maxBitrate;          /* bits per second. */
+        double weight;              /* Share of the bandwidth above the minimums, relative to the other streams. */
+        double messagesPerSecond;   /* Frames per second, each sent as one RTMP message. */
+        int    tagHeaderBytes;      /* Bytes each message adds ahead of the encoder's output, e.g. the FLV tag header. */
+    };
+
+    /*!
+     *  Decides how the bitrate left after protocol overhead is split between streams.
+     */
+    class IBitrateAllocationPolicy
+    {
+    public:
+        virtual ~IBitrateAllocationPolicy() {};
+
+        /*!
+         *  \param payloadBitrate   The bits per second available to the encoders.
+         *  \param streams          The streams to allocate to.
+         *
+         *  \return A bitrate for every stream, in the same order, within the stream's range.
+         */
+        virtual std::vector<int> allocate(int payloadBitrate, const std::vector<BitrateStream>& streams) = 0;
+    };
+
+    /*!
+     *  Every stream gets its minimum, then the rest is shared out in proportion to the streams' weights.  A stream
+     *  that reaches its maximum hands its share on to the others.
+     */
+    class WeightedAllocationPolicy : public IBitrateAllocationPolicy
+    {
+    public:
+        std::vector<int> allocate(int payloadBitrate, const std::vector<BitrateStream>& streams);
+    };
+
+    /*!
+     *  Turns a bandwidth estimate into target bitrates for every encoder feeding an RTMP session.  The overhead of
+     *  the chunk headers and FLV tag headers is taken off first, as RTMPSession actually writes them, and the rest
+     *  is split between the streams by the policy.
+     *
+     *  Not thread-safe: use it from one thread, normally the bandwidth callback.
+     */
+    class BitrateAllocator
+    {
+    public:
+        /*!
+         *  \param chunkSize    The session's outgoing chunk size.
+         *  \param policy       How to split the bandwidth.  nullptr for a WeightedAllocationPolicy.
+         */
+        BitrateAllocator(size_t chunkSize, std::unique_ptr<IBitrateAllocationPolicy> policy = nullptr);
+
+        /*! Add a stream.  \return Its index, for setStreamRange() and allocate()'s result. */
+        size_t addStream(const BitrateStream& stream);
+
+        /*! Change the range of a stream, for example to follow an AdaptationLadder. */
+        void setStreamRange(size_t stream, int minBitrate, int maxBitrate);
+
+        /*! Change the outgoing chunk size. */
+        void setChunkSize(size_t chunkSize) { m_chunkSize = chunkSize; };
+
+        /*!
+         *  The bits per second a set of stream bitrates takes on the wire, overhead included.
+         */
+        int wireBitrate(const std::vector<int>& bitrates) const;
+
+        /*!
+         *  The bandwidth to allocate after a throughput sample from the session's bandwidth callback.  When
+         *  congested, a little under the lower of what the streams send and what got through; otherwise a little
+         *  over what the streams send, to probe for more.
+         *
+         *  \param vector      The callback's direction: negative when the connection is congested.
+         *  \param predicted   The callback's throughput estimate, in bytes per second.  0 until the session has
+         *                     measured a full turn; it is then ignored.
+         *  \param bitrates    The streams' current bitrates, in the order they were added.
+         */
+        int targetBandwidth(float vector, double predicted, const std::vector<int>& bitrates) const;
+
+        /*!
+         *  Split a bandwidth estimate between the streams.
+         *
+         *  \param bandwidth    The bits per second the connection can carry.
+         *
+         *  \return A bitrate for every stream, in the order they were added.  If the bandwidth can't carry every
+         *          stream's minimum, the minimums are returned anyway.
+         */
+        std::vector<int> allocate(int bandwidth);
+
+        /*! The result of the last allocate(). */
+        const std::vector<int>& bitrates() const { return m_bitrates; };
+
+    private:
+        std::vector<BitrateStream>                  m_streams;
+        std::vector<int>                            m_bitrates;
+        std::unique_ptr<IBitrateAllocationPolicy>   m_policy;
+        size_t                                      m_chunkSize;
+    };
+}
+
+#endif /* defined(__videocore__BitrateAllocator__) */
@@ -0,0 +1,154 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Checks of BitrateAllocator and WeightedAllocationPolicy:
+ *   - the bandwidth above the minimums is split by weight, and a stream that reaches its maximum hands its share on;
+ *   - a bandwidth that can't carry the minimums gives the minimums;
+ *   - allocate() takes off exactly the overhead wireBitrate() adds back;
+ *   - targetBandwidth() backs off from the current rates, not to the minimums, while the session's throughput
+ *     estimate is still 0 at the start of a stream.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  stream/BitrateAllocator.cpp.  Exits with a non-zero status on failure.
+ */
+
+#include <videocore/stream/BitrateAllocator.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace videocore;
+
+namespace {
+
+    int s_failures = 0;
+
+    void
+    expectNear(double actual, double expected, double tolerance, const char* what)
+    {
+        const bool ok = std::fabs(actual - expected) <= tolerance;
+        printf("%s %-56s %10.0f (expected %.0f)\n", ok ? "ok  " : "FAIL", what, actual, expected);
+        s_failures += ok ? 0 : 1;
+    }
+
+    BitrateStream
+    stream(int minBitrate, int maxBitrate, double weight, double messagesPerSecond = 0., int tagHeaderBytes = 0)
+    {
+        BitrateStream s = { minBitrate, maxBitrate, weight, messagesPerSecond, tagHeaderBytes };
+        return s;
+    }
+
+    void
+    testWeightedSplit()
+    {
+        WeightedAllocationPolicy policy;
+
+        auto split = policy.allocate(400000, { stream(0, 1000000, 3.), stream(0, 1000000, 1.) });
+        expectNear(split[0], 300000, 1, "3:1 weights, first stream");
+        expectNear(split[1], 100000, 1, "3:1 weights, second stream");
+
+        split = policy.allocate(500000, { stream(100000, 1000000, 1.), stream(50000, 1000000, 1.) });
+        expectNear(split[0], 100000 + 175000, 1, "minimums first, then equal shares");
+        expectNear(split[1], 50000 + 175000, 1, "minimums first, then equal shares");
+
+        split = policy.allocate(600000, { stream(0, 100000, 1.), stream(0, 1000000, 1.) });
+        expectNear(split[0], 100000, 0, "stream at its maximum");
+        expectNear(split[1], 500000, 1, "share handed on by the full stream");
+
+        split = policy.allocate(5000000, { stream(0, 100000, 1.), stream(0, 1000000, 1.) });
+        expectNear(split[0] + split[1], 1100000, 0, "more than every maximum gives the maximums");
+
+        split = policy.allocate(300000, { stream(64000, 64000, 1.), stream(0, 1000000, 0.) });
+        expectNear(split[1], 0, 0, "zero weight stays at its minimum");
+    }
+
+    void
+    testMinimums()
+    {
+        BitrateAllocator allocator(128);
+        allocator.addStream(stream(200000, 2000000, 1., 30., 9));
+        allocator.addStream(stream(64000, 128000, 0.1, 43., 2));
+
+        for ( int bandwidth : { 0, 100000, 250000 } ) {
+            auto bitrates = allocator.allocate(bandwidth);
+            expectNear(bitrates[0], 200000, 0, "video clamped to its minimum");
+            expectNear(bitrates[1], 64000, 0, "audio clamped to its minimum");
+        }
+    }
+
+    void
+    testOverhead()
+    {
+        BitrateAllocator allocator(128);
+        allocator.addStream(stream(200000, 2000000, 1., 30., 9));
+        allocator.addStream(stream(64000, 128000, 0.1, 43., 2));
+
+        const std::vector<int> rates = { 1000000, 96000 };
+        const int wire = allocator.wireBitrate(rates);
+        expectNear(wire - 1096000, 1096000 / 128. + 30 * 8 * (9 + 8) + 43 * 8 * (2 + 8), 2,
+                   "wire overhead: chunk headers plus per-message headers");
+
+        auto bitrates = allocator.allocate(wire);
+        expectNear(bitrates[0] + bitrates[1], 1096000, 4, "allocate(wireBitrate(x)) gives back x");
+    }
+
+    void
+    testTargetBandwidth()
+    {
+        BitrateAllocator allocator(128);
+        allocator.addStream(stream(200000, 2000000, 1., 30., 9));
+        allocator.addStream(stream(64000, 128000, 0.1, 43., 2));
+
+        const std::vector<int> current = { 1000000, 96000 };
+        const double wire = allocator.wireBitrate(current);
+
+        expectNear(allocator.targetBandwidth(1.f, 0., current), wire * 1.1, 1, "probing: a little over the current rates");
+        expectNear(allocator.targetBandwidth(-1.f, 50000., current), 50000 * 8 * 0.9, 1, "congested: under the measured throughput");
+        expectNear(allocator.targetBandwidth(-1.f, 1e6, current), wire * 0.9, 1, "congested: never above the current rates");
+
+        // Before the first turn the throughput estimate is 0.  Congestion then backs off from the current rates.
+        const int start = allocator.targetBandwidth(-1.f, 0., current);
+        expectNear(start, wire * 0.9, 1, "congested with no estimate yet: under the current rates");
+        auto bitrates = allocator.allocate(start);
+        expectNear(bitrates[0] + bitrates[1], (start - 30 * 8 * (9 + 8) - 43 * 8 * (2 + 8)) / (1. + 1. / 128.), 4,
+                   "... and allocates all of it, not just the minimums");
+    }
+}
+
+int
+main()
+{
+    testWeightedSplit();
+    testMinimums();
+    testOverhead();
+    testTargetBandwidth();
+
+    printf(s_failures ? "%d failures\n" : "all passed\n", s_failures);
+    return s_failures ? 1 : 0;
+}
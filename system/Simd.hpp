@@ -0,0 +1,65 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef videocore_Simd_hpp
+#define videocore_Simd_hpp
+
+/*
+ *  Compile-time SIMD feature detection shared by the vectorized kernels.  Every kernel keeps a scalar
+ *  path, so a target without any of these still builds.
+ */
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VC_SIMD_NEON 1
+#else
+#define VC_SIMD_NEON 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VC_SIMD_SSE2 1
+#else
+#define VC_SIMD_SSE2 0
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define VC_SIMD_SSSE3 1
+#else
+#define VC_SIMD_SSSE3 0
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VC_SIMD_AVX2 1
+#else
+#define VC_SIMD_AVX2 0
+#endif
+
+#define VC_ALIGNED(n) __attribute__((aligned(n)))
+#define VC_RESTRICT   __restrict__
+
+#endif
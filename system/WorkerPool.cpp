@@ -0,0 +1,130 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/WorkerPool.hpp>
+#include <videocore/system/JobQueue.hpp>
+
+#include <algorithm>
+
+namespace videocore {
+
+    WorkerPool&
+    WorkerPool::shared()
+    {
+        static WorkerPool s_pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return s_pool;
+    }
+    WorkerPool::WorkerPool(size_t threadCount)
+    : m_task(nullptr),
+    m_count(0),
+    m_next(0),
+    m_slots(0),
+    m_active(0),
+    m_generation(0),
+    m_exiting(false)
+    {
+        for ( size_t i = 0 ; i < threadCount ; ++i ) {
+            m_threads.emplace_back([this]() { this->thread(); });
+        }
+    }
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> l(m_mutex);
+            m_exiting = true;
+        }
+        m_wakeCond.notify_all();
+        for ( auto & t : m_threads ) {
+            t.join();
+        }
+    }
+    void
+    WorkerPool::runTasks()
+    {
+        size_t i;
+        while((i = m_next.fetch_add(1)) < m_count) {
+            (*m_task)(i);
+        }
+    }
+    void
+    WorkerPool::parallelFor(size_t count, size_t parallelism, const std::function<void(size_t)>& task)
+    {
+        if(parallelism == 0) {
+            parallelism = m_threads.size() + 1;
+        }
+        const size_t helpers = count > 1 ? std::min(std::min(parallelism, count) - 1, m_threads.size()) : 0;
+
+        if(helpers == 0) {
+            for ( size_t i = 0 ; i < count ; ++i ) {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> batch(m_batchMutex);
+        {
+            std::lock_guard<std::mutex> l(m_mutex);
+            m_task = &task;
+            m_count = count;
+            m_next = 0;
+            m_slots = helpers;
+            ++m_generation;
+        }
+        m_wakeCond.notify_all();
+
+        runTasks();
+
+        // Every task has been claimed; wait for the workers still running one.
+        std::unique_lock<std::mutex> l(m_mutex);
+        m_slots = 0;
+        m_doneCond.wait(l, [this]() { return m_active == 0; });
+        m_task = nullptr;
+    }
+    void
+    WorkerPool::thread()
+    {
+        pthread_setname_np("com.videocore.worker");
+
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> l(m_mutex);
+        while(true) {
+            m_wakeCond.wait(l, [&]() { return m_exiting || (m_generation != seen && m_slots > 0); });
+            if(m_exiting) {
+                break;
+            }
+            seen = m_generation;
+            --m_slots;
+            ++m_active;
+
+            l.unlock();
+            runTasks();
+            l.lock();
+
+            if(--m_active == 0) {
+                m_doneCond.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__WorkerPool__
+#define __videocore__WorkerPool__
+
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace videocore {
+
+    /*!
+     *  A fixed set of worker threads for data-parallel work such as compositing or filtering a frame in stripes.
+     *
+     *  Unlike JobQueue, which serialises independent jobs, a WorkerPool runs one batch of indexed tasks at a time
+     *  and the caller blocks on a barrier until every task in the batch has completed.  The calling thread takes
+     *  part in the batch, so a pool with N worker threads executes on up to N + 1 cores.
+     */
+    class WorkerPool
+    {
+    public:
+        /*! The pool shared by the whole process, with one worker per additional hardware thread. */
+        static WorkerPool& shared();
+
+        /*! Constructor.
+         *
+         *  \param threadCount  The number of worker threads to start.  May be 0.
+         */
+        WorkerPool(size_t threadCount);
+
+        /*! Destructor */
+        ~WorkerPool();
+
+        /*! The number of worker threads.  The caller adds one more lane to this. */
+        size_t threadCount() const { return m_threads.size(); };
+
+        /*!
+         *  Run task(index) for every index in [0, count) and return once all of them have finished.
+         *
+         *  Batches from different callers are serialised.  Must not be called from inside a task.
+         *
+         *  \param count        The number of tasks.
+         *  \param parallelism  The maximum number of threads to use, including the caller.  0 uses every thread.
+         *  \param task         The task to run.  Tasks may run concurrently and in any order.
+         */
+        void parallelFor(size_t count, size_t parallelism, const std::function<void(size_t)>& task);
+
+    private:
+        void thread();
+        void runTasks();
+
+    private:
+        std::vector<std::thread> m_threads;
+
+        std::mutex               m_batchMutex;   /* serialises callers */
+        std::mutex               m_mutex;        /* guards the batch state below */
+        std::condition_variable  m_wakeCond, m_doneCond;
+
+        const std::function<void(size_t)>* m_task;
+        size_t                   m_count;
+        std::atomic<size_t>      m_next;
+        size_t                   m_slots;        /* workers still allowed to join the batch */
+        size_t                   m_active;       /* workers currently in the batch */
+        uint64_t                 m_generation;
+        bool                     m_exiting;
+    };
+}
+#endif /* defined(__videocore__WorkerPool__) */
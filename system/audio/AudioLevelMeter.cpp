@@ -0,0 +1,310 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/audio/AudioLevelMeter.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videocore { namespace audio {
+
+    static const float kClipLevel = 32767.f / 32768.f;
+
+    void
+    LevelAccumulator::reset()
+    {
+        memset(peak, 0, sizeof(peak));
+        memset(sumOfSquares, 0, sizeof(sumOfSquares));
+        clipCount = 0;
+        frameCount = 0;
+    }
+
+    AudioLevelMeter::AudioLevelMeter()
+    : m_sequence(0), m_channelCount(0), m_clipCount(0)
+    {
+        for ( int i = 0 ; i < kMaxAudioChannels ; ++i ) {
+            m_peak[i] = 0.f;
+            m_rms[i] = 0.f;
+        }
+    }
+
+    AudioLevelMeter::Levels
+    AudioLevelMeter::levels() const
+    {
+        Levels l;
+        uint32_t before, after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            l.channelCount = m_channelCount.load(std::memory_order_relaxed);
+            for ( int i = 0 ; i < kMaxAudioChannels ; ++i ) {
+                l.peak[i] = m_peak[i].load(std::memory_order_relaxed);
+                l.rms[i] = m_rms[i].load(std::memory_order_relaxed);
+            }
+            l.clipCount = m_clipCount.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ( (before & 1) || before != after );
+
+        return l;
+    }
+
+    void
+    AudioLevelMeter::publish(const LevelAccumulator& acc, int channelCount)
+    {
+        if(!acc.frameCount) {
+            return;
+        }
+        channelCount = std::min(channelCount, kMaxAudioChannels);
+
+        const uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_channelCount.store(channelCount, std::memory_order_relaxed);
+        const float invFrames = 1.f / float(acc.frameCount);
+        for ( int i = 0 ; i < channelCount ; ++i ) {
+            m_peak[i].store(acc.peak[i], std::memory_order_relaxed);
+            m_rms[i].store(sqrtf(acc.sumOfSquares[i] * invFrames), std::memory_order_relaxed);
+        }
+        m_clipCount.store(m_clipCount.load(std::memory_order_relaxed) + acc.clipCount, std::memory_order_relaxed);
+
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // -------------------------------------------------------------------------
+
+    // Scalar path: meters and mixes one sample.  `c` is the sample's channel.
+    static inline void
+    measureSample(float v, int c, LevelAccumulator& acc)
+    {
+        const float a = fabsf(v);
+        acc.peak[c] = std::max(acc.peak[c], a);
+        acc.sumOfSquares[c] += v * v;
+        acc.clipCount += (a >= kClipLevel);
+    }
+    static inline int16_t
+    mixSample(int16_t a, float b)
+    {
+        // Same-signed samples are combined as a + b - a*b so the sum approaches but never exceeds full scale.
+        const float fa = float(a) * (1.f / 32768.f);
+        const float sum = fa + b;
+        const float r = sum - copysignf(std::max(fa * b, 0.f), sum);
+        return int16_t(std::max(-1.f, std::min(kClipLevel, r)) * 32768.f);
+    }
+
+#if VC_SIMD_SSE2 || VC_SIMD_NEON
+    /*
+     *  The vector paths process 8 interleaved samples at a time, so each lane always carries the same channel
+     *  when the channel count divides 8.  Lane statistics are folded back into channels at the end.
+     */
+    struct LaneLevels {
+        float peak[8] VC_ALIGNED(16);
+        float sumOfSquares[8] VC_ALIGNED(16);
+        float clips[8] VC_ALIGNED(16);
+
+        void fold(int channelCount, LevelAccumulator& acc) const {
+            for ( int l = 0 ; l < 8 ; ++l ) {
+                const int c = l % channelCount;
+                acc.peak[c] = std::max(acc.peak[c], peak[l]);
+                acc.sumOfSquares[c] += sumOfSquares[l];
+                acc.clipCount += uint32_t(clips[l]);
+            }
+        }
+    };
+#endif
+
+#if VC_SIMD_SSE2
+    static inline void
+    measure4(__m128 v, __m128& peak, __m128& sum, __m128& clips)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 a = _mm_and_ps(v, absMask);
+        peak  = _mm_max_ps(peak, a);
+        sum   = _mm_add_ps(sum, _mm_mul_ps(v, v));
+        clips = _mm_add_ps(clips, _mm_and_ps(_mm_cmpge_ps(a, _mm_set1_ps(kClipLevel)), _mm_set1_ps(1.f)));
+    }
+    static inline __m128
+    mix4(__m128 a, __m128 b)
+    {
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+        const __m128 sum  = _mm_add_ps(a, b);
+        const __m128 prod = _mm_max_ps(_mm_mul_ps(a, b), _mm_setzero_ps());
+        const __m128 r    = _mm_sub_ps(sum, _mm_or_ps(prod, _mm_and_ps(sum, signMask)));
+        return _mm_min_ps(_mm_max_ps(r, _mm_set1_ps(-1.f)), _mm_set1_ps(kClipLevel));
+    }
+    static inline void
+    load8(const int16_t* p, __m128& lo, __m128& hi)
+    {
+        const __m128i d = _mm_loadu_si128((const __m128i*)p);
+        const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+        lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16)), scale);
+        hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16)), scale);
+    }
+#elif VC_SIMD_NEON
+    static inline void
+    measure4(float32x4_t v, float32x4_t& peak, float32x4_t& sum, float32x4_t& clips)
+    {
+        const float32x4_t a = vabsq_f32(v);
+        peak  = vmaxq_f32(peak, a);
+        sum   = vmlaq_f32(sum, v, v);
+        clips = vaddq_f32(clips, vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(a, vdupq_n_f32(kClipLevel)),
+                                                                  vreinterpretq_u32_f32(vdupq_n_f32(1.f)))));
+    }
+    static inline float32x4_t
+    mix4(float32x4_t a, float32x4_t b)
+    {
+        const uint32x4_t signMask = vdupq_n_u32(0x80000000);
+        const float32x4_t sum  = vaddq_f32(a, b);
+        const float32x4_t prod = vmaxq_f32(vmulq_f32(a, b), vdupq_n_f32(0.f));
+        const float32x4_t r    = vsubq_f32(sum, vbslq_f32(signMask, sum, prod));
+        return vminq_f32(vmaxq_f32(r, vdupq_n_f32(-1.f)), vdupq_n_f32(kClipLevel));
+    }
+    static inline void
+    load8(const int16_t* p, float32x4_t& lo, float32x4_t& hi)
+    {
+        const int16x8_t d = vld1q_s16(p);
+        lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(d))), 1.f / 32768.f);
+        hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(d))), 1.f / 32768.f);
+    }
+#endif
+
+    void
+    mixAndMeasure(int16_t* VC_RESTRICT dst, const float* VC_RESTRICT src, size_t frameCount, int channelCount, float mixGain, LevelAccumulator& acc)
+    {
+        const size_t count = frameCount * channelCount;
+        size_t i = 0;
+
+#if VC_SIMD_SSE2
+        if(8 % channelCount == 0) {
+            __m128 p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+            __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+            __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps();
+            const __m128 g = _mm_set1_ps(mixGain);
+            const __m128 scale = _mm_set1_ps(32768.f);
+
+            for ( ; i + 8 <= count ; i += 8 ) {
+                const __m128 v0 = _mm_loadu_ps(src + i);
+                const __m128 v1 = _mm_loadu_ps(src + i + 4);
+                measure4(v0, p0, s0, c0);
+                measure4(v1, p1, s1, c1);
+                const __m128 b0 = _mm_mul_ps(v0, g);
+                const __m128 b1 = _mm_mul_ps(v1, g);
+
+                __m128 a0, a1;
+                load8(dst + i, a0, a1);
+                const __m128i r = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(mix4(a0, b0), scale)),
+                                                  _mm_cvttps_epi32(_mm_mul_ps(mix4(a1, b1), scale)));
+                _mm_storeu_si128((__m128i*)(dst + i), r);
+            }
+            LaneLevels lanes;
+            _mm_store_ps(lanes.peak, p0); _mm_store_ps(lanes.peak + 4, p1);
+            _mm_store_ps(lanes.sumOfSquares, s0); _mm_store_ps(lanes.sumOfSquares + 4, s1);
+            _mm_store_ps(lanes.clips, c0); _mm_store_ps(lanes.clips + 4, c1);
+            lanes.fold(channelCount, acc);
+        }
+#elif VC_SIMD_NEON
+        if(8 % channelCount == 0) {
+            float32x4_t p0 = vdupq_n_f32(0.f), p1 = p0, s0 = p0, s1 = p0, c0 = p0, c1 = p0;
+
+            for ( ; i + 8 <= count ; i += 8 ) {
+                const float32x4_t v0 = vld1q_f32(src + i);
+                const float32x4_t v1 = vld1q_f32(src + i + 4);
+                measure4(v0, p0, s0, c0);
+                measure4(v1, p1, s1, c1);
+                const float32x4_t b0 = vmulq_n_f32(v0, mixGain);
+                const float32x4_t b1 = vmulq_n_f32(v1, mixGain);
+
+                float32x4_t a0, a1;
+                load8(dst + i, a0, a1);
+                const int16x4_t r0 = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(mix4(a0, b0), 32768.f)));
+                const int16x4_t r1 = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(mix4(a1, b1), 32768.f)));
+                vst1q_s16(dst + i, vcombine_s16(r0, r1));
+            }
+            LaneLevels lanes;
+            vst1q_f32(lanes.peak, p0); vst1q_f32(lanes.peak + 4, p1);
+            vst1q_f32(lanes.sumOfSquares, s0); vst1q_f32(lanes.sumOfSquares + 4, s1);
+            vst1q_f32(lanes.clips, c0); vst1q_f32(lanes.clips + 4, c1);
+            lanes.fold(channelCount, acc);
+        }
+#endif
+        for ( int c = int(i % channelCount) ; i < count ; ++i ) {
+            measureSample(src[i], c, acc);
+            dst[i] = mixSample(dst[i], src[i] * mixGain);
+            if(++c == channelCount) c = 0;
+        }
+        acc.frameCount += frameCount;
+    }
+
+    void
+    measure(const int16_t* VC_RESTRICT src, size_t frameCount, int channelCount, LevelAccumulator& acc)
+    {
+        const size_t count = frameCount * channelCount;
+        size_t i = 0;
+
+#if VC_SIMD_SSE2
+        if(8 % channelCount == 0) {
+            __m128 p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+            __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+            __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps();
+
+            for ( ; i + 8 <= count ; i += 8 ) {
+                __m128 v0, v1;
+                load8(src + i, v0, v1);
+                measure4(v0, p0, s0, c0);
+                measure4(v1, p1, s1, c1);
+            }
+            LaneLevels lanes;
+            _mm_store_ps(lanes.peak, p0); _mm_store_ps(lanes.peak + 4, p1);
+            _mm_store_ps(lanes.sumOfSquares, s0); _mm_store_ps(lanes.sumOfSquares + 4, s1);
+            _mm_store_ps(lanes.clips, c0); _mm_store_ps(lanes.clips + 4, c1);
+            lanes.fold(channelCount, acc);
+        }
+#elif VC_SIMD_NEON
+        if(8 % channelCount == 0) {
+            float32x4_t p0 = vdupq_n_f32(0.f), p1 = p0, s0 = p0, s1 = p0, c0 = p0, c1 = p0;
+
+            for ( ; i + 8 <= count ; i += 8 ) {
+                float32x4_t v0, v1;
+                load8(src + i, v0, v1);
+                measure4(v0, p0, s0, c0);
+                measure4(v1, p1, s1, c1);
+            }
+            LaneLevels lanes;
+            vst1q_f32(lanes.peak, p0); vst1q_f32(lanes.peak + 4, p1);
+            vst1q_f32(lanes.sumOfSquares, s0); vst1q_f32(lanes.sumOfSquares + 4, s1);
+            vst1q_f32(lanes.clips, c0); vst1q_f32(lanes.clips + 4, c1);
+            lanes.fold(channelCount, acc);
+        }
+#endif
+        for ( int c = int(i % channelCount) ; i < count ; ++i ) {
+            measureSample(float(src[i]) * (1.f / 32768.f), c, acc);
+            if(++c == channelCount) c = 0;
+        }
+        acc.frameCount += frameCount;
+    }
+}
+}
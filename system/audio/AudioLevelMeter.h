@@ -0,0 +1,102 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__AudioLevelMeter__
+#define __videocore__AudioLevelMeter__
+
+#include <videocore/system/audio/ChannelLayout.h>
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace audio {
+
+    /*!
+     *  Running per-channel level statistics.  Filled by the mix kernels below and published to an
+     *  AudioLevelMeter once per buffer.
+     */
+    struct LevelAccumulator {
+        LevelAccumulator() { reset(); };
+        void reset();
+
+        float    peak[kMaxAudioChannels];
+        float    sumOfSquares[kMaxAudioChannels];
+        uint32_t clipCount;
+        size_t   frameCount;
+    };
+
+    /*!
+     *  Peak/RMS/clip meter that can be read from any thread without locking.  A single writer (the mixer)
+     *  publishes snapshots; readers copy the latest consistent snapshot and retry if they race a write.
+     */
+    class AudioLevelMeter
+    {
+    public:
+        /*! A snapshot of the meter.  Levels are linear, 1.0 being full scale. */
+        struct Levels {
+            int      channelCount;
+            float    peak[kMaxAudioChannels];   /*!< Peak level over the last published buffer */
+            float    rms[kMaxAudioChannels];    /*!< RMS level over the last published buffer */
+            uint64_t clipCount;                 /*!< Total number of clipped samples since creation */
+        };
+
+    public:
+        AudioLevelMeter();
+
+        /*! Returns the most recent snapshot.  Lock-free; safe to call at any rate from any thread. */
+        Levels levels() const;
+
+        /*! Publish the contents of an accumulator.  Must only be called from one thread. */
+        void publish(const LevelAccumulator& acc, int channelCount);
+
+    private:
+        std::atomic<uint32_t> m_sequence;
+        std::atomic<int>      m_channelCount;
+        std::atomic<float>    m_peak[kMaxAudioChannels];
+        std::atomic<float>    m_rms[kMaxAudioChannels];
+        std::atomic<uint64_t> m_clipCount;
+    };
+
+    /*!
+     *  Mix a block of normalized float samples into 16-bit samples with the mixer's soft-clip sum, and
+     *  accumulate the levels of the incoming samples (before mixGain) in the same pass.
+     *
+     *  \param dst           Interleaved 16-bit samples to mix into.
+     *  \param src           Interleaved float samples.
+     *  \param frameCount    Number of frames.
+     *  \param channelCount  Number of interleaved channels.
+     *  \param mixGain       Gain applied to src as it is mixed.  Not reflected in the levels.
+     *  \param acc           The accumulator for src's levels.
+     */
+    void mixAndMeasure(int16_t* dst, const float* src, size_t frameCount, int channelCount, float mixGain, LevelAccumulator& acc);
+
+    /*!
+     *  Accumulate the levels of a block of 16-bit samples.
+     */
+    void measure(const int16_t* src, size_t frameCount, int channelCount, LevelAccumulator& acc);
+}
+}
+#endif /* defined(__videocore__AudioLevelMeter__) */
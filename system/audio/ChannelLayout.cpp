@@ -0,0 +1,265 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/audio/ChannelLayout.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videocore { namespace audio {
+
+    static const float kMinus3dB = 0.70710678118f;
+    static const float kMinus6dB = 0.5f;
+
+    static const Speaker s_layouts[kMaxAudioChannels][kMaxAudioChannels] = {
+        { kSpeakerCenter },
+        { kSpeakerLeft, kSpeakerRight },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerCenter },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerLeftSurround, kSpeakerRightSurround },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerCenter, kSpeakerLeftSurround, kSpeakerRightSurround },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerCenter, kSpeakerLFE, kSpeakerLeftSurround, kSpeakerRightSurround },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerCenter, kSpeakerLFE, kSpeakerLeftSurround, kSpeakerRightSurround, kSpeakerCenterSurround },
+        { kSpeakerLeft, kSpeakerRight, kSpeakerCenter, kSpeakerLFE, kSpeakerLeftSurround, kSpeakerRightSurround, kSpeakerLeftSide, kSpeakerRightSide }
+    };
+
+    Speaker
+    speakerForChannel(int channelCount, int channel)
+    {
+        channelCount = std::max(1, std::min(channelCount, kMaxAudioChannels));
+        return s_layouts[channelCount-1][channel];
+    }
+
+    ChannelMixMatrix::ChannelMixMatrix(int inChannelCount, int outChannelCount)
+    : m_inChannelCount(std::max(1, std::min(inChannelCount, kMaxAudioChannels))),
+    m_outChannelCount(std::max(1, std::min(outChannelCount, kMaxAudioChannels)))
+    {
+        memset(m_columns, 0, sizeof(m_columns));
+
+        int outIndex[kSpeakerCount];
+        std::fill(outIndex, outIndex + kSpeakerCount, -1);
+        for ( int i = 0 ; i < m_outChannelCount ; ++i ) {
+            outIndex[speakerForChannel(m_outChannelCount, i)] = i;
+        }
+
+        for ( int ic = 0 ; ic < m_inChannelCount ; ++ic ) {
+            float* col = m_columns[ic];
+
+            // Adds `gain` to the output speaker if it exists; returns false otherwise.
+            auto route = [&](Speaker s, float gain) {
+                if(outIndex[s] < 0) return false;
+                col[outIndex[s]] += gain;
+                return true;
+            };
+            const Speaker s = speakerForChannel(m_inChannelCount, ic);
+
+            if(route(s, 1.f)) {
+                continue;
+            }
+            switch(s) {
+                case kSpeakerCenter:
+                    // A mono source keeps its level on both speakers, anything else is folded in at -3dB.
+                    route(kSpeakerLeft,  m_inChannelCount == 1 ? 1.f : kMinus3dB);
+                    route(kSpeakerRight, m_inChannelCount == 1 ? 1.f : kMinus3dB);
+                    break;
+                case kSpeakerLeft:
+                case kSpeakerRight:
+                    route(kSpeakerCenter, kMinus3dB);
+                    break;
+                case kSpeakerLeftSurround:
+                case kSpeakerLeftSide:
+                    route(s == kSpeakerLeftSide ? kSpeakerLeftSurround : kSpeakerLeftSide, 1.f) ||
+                    route(kSpeakerLeft, kMinus3dB) ||
+                    route(kSpeakerCenter, kMinus6dB);
+                    break;
+                case kSpeakerRightSurround:
+                case kSpeakerRightSide:
+                    route(s == kSpeakerRightSide ? kSpeakerRightSurround : kSpeakerRightSide, 1.f) ||
+                    route(kSpeakerRight, kMinus3dB) ||
+                    route(kSpeakerCenter, kMinus6dB);
+                    break;
+                case kSpeakerCenterSurround:
+                    if(outIndex[kSpeakerLeftSurround] >= 0) {
+                        route(kSpeakerLeftSurround, kMinus3dB);
+                        route(kSpeakerRightSurround, kMinus3dB);
+                    } else if(outIndex[kSpeakerLeft] >= 0) {
+                        route(kSpeakerLeft, kMinus6dB);
+                        route(kSpeakerRight, kMinus6dB);
+                    } else {
+                        route(kSpeakerCenter, kMinus6dB);
+                    }
+                    break;
+                case kSpeakerLFE:
+                default:
+                    // LFE is dropped when the output has no LFE channel.
+                    break;
+            }
+        }
+    }
+
+    bool
+    ChannelMixMatrix::isIdentity() const
+    {
+        if(m_inChannelCount != m_outChannelCount) {
+            return false;
+        }
+        for ( int ic = 0 ; ic < m_inChannelCount ; ++ic ) {
+            for ( int oc = 0 ; oc < m_outChannelCount ; ++oc ) {
+                if(m_columns[ic][oc] != (ic == oc ? 1.f : 0.f)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    //
+    //  Sample loaders.  Every format is scaled to the signed 16-bit range.
+    //
+    // -------------------------------------------------------------------------
+
+    struct LoadS8  { enum { kBytes = 1 }; static inline float load(const uint8_t* p) { return float(int8_t(*p)) * 256.f; } };
+    struct LoadS16 { enum { kBytes = 2 }; static inline float load(const uint8_t* p) { int16_t v; memcpy(&v, p, 2); return float(v); } };
+    struct LoadS24 { enum { kBytes = 3 }; static inline float load(const uint8_t* p) {
+        const int32_t v = int32_t(uint32_t(p[0]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 24) >> 8;
+        return float(v) * (1.f / 256.f);
+    } };
+    struct LoadS32 { enum { kBytes = 4 }; static inline float load(const uint8_t* p) { int32_t v; memcpy(&v, p, 4); return float(v) * (1.f / 65536.f); } };
+    struct LoadF32 { enum { kBytes = 4 }; static inline float load(const uint8_t* p) { float v; memcpy(&v, p, 4); return v * 32767.f; } };
+
+    // Accumulates one output frame as the sum of the matrix columns weighted by the input samples.
+    static inline void
+    mixFrame(const float* VC_RESTRICT samples, const ChannelMixMatrix& matrix, int16_t* VC_RESTRICT out)
+    {
+        const int inChannels = matrix.inChannelCount();
+        const int outChannels = matrix.outChannelCount();
+#if VC_SIMD_SSE2
+        __m128 a0 = _mm_setzero_ps();
+        __m128 a1 = _mm_setzero_ps();
+        for ( int c = 0 ; c < inChannels ; ++c ) {
+            const float* col = matrix.column(c);
+            const __m128 s = _mm_set1_ps(samples[c]);
+            a0 = _mm_add_ps(a0, _mm_mul_ps(s, _mm_load_ps(col)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(s, _mm_load_ps(col + 4)));
+        }
+        const __m128 lo = _mm_set1_ps(-32768.f);
+        const __m128 hi = _mm_set1_ps(32767.f);
+        a0 = _mm_min_ps(_mm_max_ps(a0, lo), hi);
+        a1 = _mm_min_ps(_mm_max_ps(a1, lo), hi);
+        int16_t frame[kMaxAudioChannels] __attribute__((aligned(16)));
+        _mm_store_si128((__m128i*)frame, _mm_packs_epi32(_mm_cvtps_epi32(a0), _mm_cvtps_epi32(a1)));
+        memcpy(out, frame, outChannels * sizeof(int16_t));
+#elif VC_SIMD_NEON
+        float32x4_t a0 = vdupq_n_f32(0.f);
+        float32x4_t a1 = vdupq_n_f32(0.f);
+        for ( int c = 0 ; c < inChannels ; ++c ) {
+            const float* col = matrix.column(c);
+            a0 = vmlaq_n_f32(a0, vld1q_f32(col), samples[c]);
+            a1 = vmlaq_n_f32(a1, vld1q_f32(col + 4), samples[c]);
+        }
+        int16_t frame[kMaxAudioChannels] __attribute__((aligned(16)));
+        vst1q_s16(frame, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a0)), vqmovn_s32(vcvtq_s32_f32(a1))));
+        memcpy(out, frame, outChannels * sizeof(int16_t));
+#else
+        for ( int oc = 0 ; oc < outChannels ; ++oc ) {
+            float acc = 0.f;
+            for ( int c = 0 ; c < inChannels ; ++c ) {
+                acc += samples[c] * matrix.coefficient(oc, c);
+            }
+            out[oc] = int16_t(std::max(-32768.f, std::min(32767.f, acc)));
+        }
+#endif
+    }
+
+    template<typename Loader>
+    static void
+    convertResampleAndMixImpl(const uint8_t* in,
+                              size_t inFrameCount,
+                              bool planar,
+                              double ratio,
+                              const ChannelMixMatrix& matrix,
+                              int16_t* out,
+                              size_t outFrameCount)
+    {
+        const int inChannels = matrix.inChannelCount();
+        const int outChannels = matrix.outChannelCount();
+
+        // Distance between two frames of a channel, and between two channels of a frame.
+        const size_t frameStride   = planar ? size_t(Loader::kBytes) : size_t(Loader::kBytes) * inChannels;
+        const size_t channelStride = planar ? size_t(Loader::kBytes) * inFrameCount : size_t(Loader::kBytes);
+
+        float samples[kMaxAudioChannels];
+
+        for ( size_t i = 0 ; i < outFrameCount ; ++i ) {
+            const size_t j = std::min(size_t(double(i) * ratio), inFrameCount - 1);
+            const uint8_t* p = in + j * frameStride;
+
+            for ( int c = 0 ; c < inChannels ; ++c ) {
+                samples[c] = Loader::load(p + c * channelStride);
+            }
+            mixFrame(samples, matrix, out);
+            out += outChannels;
+        }
+    }
+
+    void
+    convertResampleAndMix(const uint8_t* in,
+                          size_t inFrameCount,
+                          int inBitsPerChannel,
+                          int inFlags,
+                          double ratio,
+                          const ChannelMixMatrix& matrix,
+                          int16_t* out,
+                          size_t outFrameCount)
+    {
+        if(!inFrameCount) {
+            return;
+        }
+        const bool planar = (inFlags & kAudioFlagIsNonInterleaved) && matrix.inChannelCount() > 1;
+
+        if(inFlags & kAudioFlagIsFloat) {
+            convertResampleAndMixImpl<LoadF32>(in, inFrameCount, planar, ratio, matrix, out, outFrameCount);
+            return;
+        }
+        switch(inBitsPerChannel) {
+            case 8:
+                convertResampleAndMixImpl<LoadS8>(in, inFrameCount, planar, ratio, matrix, out, outFrameCount);
+                break;
+            case 24:
+                convertResampleAndMixImpl<LoadS24>(in, inFrameCount, planar, ratio, matrix, out, outFrameCount);
+                break;
+            case 32:
+                convertResampleAndMixImpl<LoadS32>(in, inFrameCount, planar, ratio, matrix, out, outFrameCount);
+                break;
+            case 16:
+            default:
+                convertResampleAndMixImpl<LoadS16>(in, inFrameCount, planar, ratio, matrix, out, outFrameCount);
+                break;
+        }
+    }
+}
+}
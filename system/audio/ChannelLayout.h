@@ -0,0 +1,129 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__ChannelLayout__
+#define __videocore__ChannelLayout__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace audio {
+
+    /*! The maximum number of interleaved channels supported by the audio path. */
+    static const int kMaxAudioChannels = 8;
+
+    /*! AudioBufferMetadata flag bits understood by the conversion kernels (same values as CoreAudio's) */
+    enum {
+        kAudioFlagIsFloat          = (1 << 0),
+        kAudioFlagIsNonInterleaved = (1 << 5)
+    };
+
+    /*!
+     *  Speaker positions.  Interleaved buffers use the WAVE/CoreAudio default order for their channel count:
+     *
+     *  1: C
+     *  2: L R
+     *  3: L R C
+     *  4: L R Ls Rs
+     *  5: L R C Ls Rs
+     *  6: L R C LFE Ls Rs
+     *  7: L R C LFE Ls Rs Cs
+     *  8: L R C LFE Ls Rs Lsd Rsd
+     */
+    typedef enum {
+        kSpeakerLeft,
+        kSpeakerRight,
+        kSpeakerCenter,
+        kSpeakerLFE,
+        kSpeakerLeftSurround,
+        kSpeakerRightSurround,
+        kSpeakerCenterSurround,
+        kSpeakerLeftSide,
+        kSpeakerRightSide,
+        kSpeakerCount
+    } Speaker;
+
+    /*!
+     *  Returns the speaker at the given position of the default layout for a channel count.
+     */
+    Speaker speakerForChannel(int channelCount, int channel);
+
+    /*!
+     *  An up/down-mix matrix between two channel layouts.  Coefficients are stored column-major with every
+     *  column padded to kMaxAudioChannels floats so a whole output frame can be accumulated with SIMD.
+     */
+    class ChannelMixMatrix
+    {
+    public:
+        /*!
+         *  Build the default matrix between two layouts.  Matching speakers pass through at unity gain,
+         *  missing speakers are folded into their nearest neighbours at -3dB (ITU-R BS.775) and a mono
+         *  input is copied to the front pair.
+         */
+        ChannelMixMatrix(int inChannelCount, int outChannelCount);
+
+        int inChannelCount() const { return m_inChannelCount; };
+        int outChannelCount() const { return m_outChannelCount; };
+
+        float coefficient(int outChannel, int inChannel) const { return m_columns[inChannel][outChannel]; };
+        void  setCoefficient(int outChannel, int inChannel, float value) { m_columns[inChannel][outChannel] = value; };
+
+        /*! The kMaxAudioChannels coefficients applied to one input channel. */
+        const float* column(int inChannel) const { return m_columns[inChannel]; };
+
+        /*! true if the matrix passes channels straight through. */
+        bool isIdentity() const;
+
+    private:
+        float m_columns[kMaxAudioChannels][kMaxAudioChannels] __attribute__((aligned(16)));
+        int   m_inChannelCount;
+        int   m_outChannelCount;
+    };
+
+    /*!
+     *  Resample (nearest neighbour), convert to 16-bit and remix a buffer of LPCM in a single pass over
+     *  the input.
+     *
+     *  \param in              The input samples.  Planar input stores each channel's frames contiguously.
+     *  \param inFrameCount    Number of input frames.
+     *  \param inBitsPerChannel 8, 16, 24 or 32.  Ignored for float input.
+     *  \param inFlags         kAudioFlagIsFloat and/or kAudioFlagIsNonInterleaved.
+     *  \param ratio           Input sampling rate divided by output sampling rate.
+     *  \param matrix          The channel mix matrix.  Its input channel count describes the input buffer.
+     *  \param out             Interleaved signed 16-bit output with matrix.outChannelCount() channels.
+     *  \param outFrameCount   Number of output frames to produce.
+     */
+    void convertResampleAndMix(const uint8_t* in,
+                               size_t inFrameCount,
+                               int inBitsPerChannel,
+                               int inFlags,
+                               double ratio,
+                               const ChannelMixMatrix& matrix,
+                               int16_t* out,
+                               size_t outFrameCount);
+
+}
+}
+#endif /* defined(__videocore__ChannelLayout__) */
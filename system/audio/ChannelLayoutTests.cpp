@@ -0,0 +1,185 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Checks of the channel routing in ChannelLayout.cpp against hand-computed values:
+ *   - the default matrices for identity, mono to stereo, stereo to mono and 5.1 to stereo;
+ *   - convertResampleAndMix applied with those matrices to 16-bit, float, 8-bit, 24-bit and planar input,
+ *     including clipping and resampling.
+ *
+ *  Integer results may differ by one from the exact value: the SIMD paths round, the scalar path truncates.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/audio/ChannelLayout.cpp.  Exits with a non-zero status on failure.
+ */
+
+#include <videocore/system/audio/ChannelLayout.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace videocore::audio;
+
+namespace {
+
+    const float kM3 = 0.70710678f;  // -3dB
+
+    int s_failures = 0;
+
+    void
+    check(bool ok, const char* what)
+    {
+        if(!ok) {
+            printf("FAIL %s\n", what);
+            ++s_failures;
+        }
+    }
+
+    // The matrix must hold `expected`, given row by row (one row per output channel).
+    void
+    checkMatrix(const ChannelMixMatrix& m, const std::vector<float>& expected, const char* what)
+    {
+        bool ok = int(expected.size()) == m.outChannelCount() * m.inChannelCount();
+        for ( int oc = 0 ; ok && oc < m.outChannelCount() ; ++oc ) {
+            for ( int ic = 0 ; ic < m.inChannelCount() ; ++ic ) {
+                ok &= std::fabs(m.coefficient(oc, ic) - expected[oc * m.inChannelCount() + ic]) < 1e-6f;
+            }
+        }
+        check(ok, what);
+    }
+
+    // Runs the conversion and compares every output sample with `expected`, to within one.
+    void
+    checkMix(const void* in, size_t inFrames, int bits, int flags, double ratio, const ChannelMixMatrix& m,
+             const std::vector<int>& expected, const char* what)
+    {
+        const size_t outFrames = expected.size() / m.outChannelCount();
+        std::vector<int16_t> out(expected.size() + 1, 0x5A5A);
+        convertResampleAndMix(static_cast<const uint8_t*>(in), inFrames, bits, flags, ratio, m, &out[0], outFrames);
+
+        bool ok = out.back() == 0x5A5A;
+        for ( size_t i = 0 ; i < expected.size() ; ++i ) {
+            if(std::abs(out[i] - expected[i]) > 1) {
+                printf("     %s: sample %zu is %d, expected %d\n", what, i, out[i], expected[i]);
+                ok = false;
+            }
+        }
+        check(ok, what);
+    }
+
+    void
+    testMatrices()
+    {
+        for ( int n = 1 ; n <= kMaxAudioChannels ; ++n ) {
+            check(ChannelMixMatrix(n, n).isIdentity(), "n to n channels is the identity");
+        }
+        check(!ChannelMixMatrix(1, 2).isIdentity(), "mono to stereo is not the identity");
+
+        checkMatrix(ChannelMixMatrix(1, 2), { 1.f,
+                                              1.f }, "mono to stereo copies to both sides");
+        checkMatrix(ChannelMixMatrix(2, 1), { kM3, kM3 }, "stereo to mono sums at -3dB");
+
+        //                                     L    R    C    LFE  Ls   Rs
+        checkMatrix(ChannelMixMatrix(6, 2), { 1.f, 0.f, kM3, 0.f, kM3, 0.f,
+                                              0.f, 1.f, kM3, 0.f, 0.f, kM3 }, "5.1 to stereo folds C and surrounds at -3dB, drops LFE");
+
+        checkMatrix(ChannelMixMatrix(2, 6), { 1.f, 0.f,
+                                              0.f, 1.f,
+                                              0.f, 0.f,
+                                              0.f, 0.f,
+                                              0.f, 0.f,
+                                              0.f, 0.f }, "stereo to 5.1 fills the front pair only");
+    }
+
+    void
+    testMix()
+    {
+        {
+            const int16_t in[] = { 1234, -32768, 7 };
+            checkMix(in, 3, 16, 0, 1., ChannelMixMatrix(1, 2), { 1234, 1234, -32768, -32768, 7, 7 }, "s16 mono to stereo");
+        }
+        {
+            const int16_t in[] = { 1000, 2000,  -1000, 3000,  32767, 32767 };
+            // 0.7071 * (1000 + 2000) = 2121.3, 0.7071 * 2000 = 1414.2, 0.7071 * 65534 clips.
+            checkMix(in, 3, 16, 0, 1., ChannelMixMatrix(2, 1), { 2121, 1414, 32767 }, "s16 stereo to mono");
+        }
+        {
+            //                 L      R      C     LFE    Ls     Rs
+            const int16_t in[] = { 1000, -2000, 3000, 30000,   400,  -500,
+                                  30000, 30000, 30000,   0, 30000, 30000 };
+            // L = 1000 + 0.7071 * (3000 + 400) = 3404.2, R = -2000 + 0.7071 * (3000 - 500) = -232.2.
+            checkMix(in, 2, 16, 0, 1., ChannelMixMatrix(6, 2), { 3404, -232, 32767, 32767 }, "s16 5.1 to stereo");
+
+            // The same frames stored channel by channel.
+            int16_t planar[12];
+            for ( int c = 0 ; c < 6 ; ++c ) {
+                planar[c * 2] = in[c];
+                planar[c * 2 + 1] = in[6 + c];
+            }
+            checkMix(planar, 2, 16, kAudioFlagIsNonInterleaved, 1., ChannelMixMatrix(6, 2), { 3404, -232, 32767, 32767 },
+                     "planar s16 5.1 to stereo");
+        }
+        {
+            const float in[] = { 0.5f, -0.25f,  -2.f, 2.f };
+            // Float is scaled by 32767: 16383.5, -8191.75, and the last frame clips both ways.
+            checkMix(in, 2, 32, kAudioFlagIsFloat, 1., ChannelMixMatrix(2, 2), { 16383, -8192, -32768, 32767 }, "float identity");
+            // 0.7071 * 32767 * 0.25 = 5792.4
+            checkMix(in, 1, 32, kAudioFlagIsFloat, 1., ChannelMixMatrix(2, 1), { 5792 }, "float stereo to mono");
+        }
+        {
+            const int8_t in[] = { 64, -128 };
+            checkMix(in, 2, 8, 0, 1., ChannelMixMatrix(1, 2), { 16384, 16384, -32768, -32768 }, "s8 mono to stereo");
+
+            const uint8_t in24[] = { 0x56, 0x34, 0x12 };    // 0x123456 / 256 = 4660.3
+            checkMix(in24, 1, 24, 0, 1., ChannelMixMatrix(1, 1), { 4660 }, "s24 mono");
+        }
+        {
+            int16_t in[8 * 4];
+            std::vector<int> expected;
+            for ( int i = 0 ; i < 8 * 4 ; ++i ) {
+                in[i] = int16_t(i * 1000 - 16000);
+            }
+            // Halving the rate takes every other input frame.
+            for ( int f = 0 ; f < 4 ; f += 2 ) {
+                expected.insert(expected.end(), in + f * 8, in + f * 8 + 8);
+            }
+            checkMix(in, 4, 16, 0, 2., ChannelMixMatrix(8, 8), expected, "s16 7.1 identity at half rate");
+        }
+    }
+}
+
+int
+main()
+{
+    testMatrices();
+    testMix();
+
+    printf(s_failures ? "%d failures\n" : "all passed\n", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/system/audio/GainKernels.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace videocore { namespace audio {
+
+#if VC_SIMD_SSE2
+    static inline __m128
+    abs4(__m128 v)
+    {
+        return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+    }
+#endif
+
+    float
+    peak(const float* VC_RESTRICT src, size_t count)
+    {
+        size_t i = 0;
+        float p = 0.f;
+
+#if VC_SIMD_SSE2
+        __m128 p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+        for ( ; i + 8 <= count ; i += 8 ) {
+            p0 = _mm_max_ps(p0, abs4(_mm_loadu_ps(src + i)));
+            p1 = _mm_max_ps(p1, abs4(_mm_loadu_ps(src + i + 4)));
+        }
+        float lanes[4] VC_ALIGNED(16);
+        _mm_store_ps(lanes, _mm_max_ps(p0, p1));
+        p = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif VC_SIMD_NEON
+        float32x4_t p0 = vdupq_n_f32(0.f), p1 = p0;
+        for ( ; i + 8 <= count ; i += 8 ) {
+            p0 = vmaxq_f32(p0, vabsq_f32(vld1q_f32(src + i)));
+            p1 = vmaxq_f32(p1, vabsq_f32(vld1q_f32(src + i + 4)));
+        }
+        const float32x2_t m = vpmax_f32(vget_low_f32(vmaxq_f32(p0, p1)), vget_high_f32(vmaxq_f32(p0, p1)));
+        p = std::max(vget_lane_f32(m, 0), vget_lane_f32(m, 1));
+#endif
+        for ( ; i < count ; ++i ) {
+            p = std::max(p, fabsf(src[i]));
+        }
+        return p;
+    }
+
+    void
+    framePeaks(const float* VC_RESTRICT src, size_t frameCount, int channelCount, float* VC_RESTRICT peaks)
+    {
+        size_t frame = 0;
+
+#if VC_SIMD_SSE2
+        if(channelCount == 1) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                _mm_storeu_ps(peaks + frame, abs4(_mm_loadu_ps(src + frame)));
+            }
+        } else if(channelCount == 2) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                const __m128 a = abs4(_mm_loadu_ps(src + frame * 2));
+                const __m128 b = abs4(_mm_loadu_ps(src + frame * 2 + 4));
+                // Deinterleave into left and right, then take the larger of the pair.
+                const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm_storeu_ps(peaks + frame, _mm_max_ps(l, r));
+            }
+        }
+#elif VC_SIMD_NEON
+        if(channelCount == 1) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                vst1q_f32(peaks + frame, vabsq_f32(vld1q_f32(src + frame)));
+            }
+        } else if(channelCount == 2) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                const float32x4x2_t lr = vld2q_f32(src + frame * 2);
+                vst1q_f32(peaks + frame, vmaxq_f32(vabsq_f32(lr.val[0]), vabsq_f32(lr.val[1])));
+            }
+        }
+#endif
+        for ( ; frame < frameCount ; ++frame ) {
+            const float* f = src + frame * channelCount;
+            float p = 0.f;
+            for ( int c = 0 ; c < channelCount ; ++c ) {
+                p = std::max(p, fabsf(f[c]));
+            }
+            peaks[frame] = p;
+        }
+    }
+
+    void
+    applyGain(float* VC_RESTRICT samples, size_t count, float gain)
+    {
+        size_t i = 0;
+
+#if VC_SIMD_SSE2
+        const __m128 g = _mm_set1_ps(gain);
+        for ( ; i + 8 <= count ; i += 8 ) {
+            _mm_storeu_ps(samples + i,     _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+            _mm_storeu_ps(samples + i + 4, _mm_mul_ps(_mm_loadu_ps(samples + i + 4), g));
+        }
+#elif VC_SIMD_NEON
+        for ( ; i + 8 <= count ; i += 8 ) {
+            vst1q_f32(samples + i,     vmulq_n_f32(vld1q_f32(samples + i), gain));
+            vst1q_f32(samples + i + 4, vmulq_n_f32(vld1q_f32(samples + i + 4), gain));
+        }
+#endif
+        for ( ; i < count ; ++i ) {
+            samples[i] *= gain;
+        }
+    }
+
+    void
+    applyFrameGains(float* VC_RESTRICT samples, const float* VC_RESTRICT gains, size_t frameCount, int channelCount)
+    {
+        size_t frame = 0;
+
+#if VC_SIMD_SSE2
+        if(channelCount == 1) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                _mm_storeu_ps(samples + frame, _mm_mul_ps(_mm_loadu_ps(samples + frame), _mm_loadu_ps(gains + frame)));
+            }
+        } else if(channelCount == 2) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                // (g0 g1 g2 g3) -> (g0 g0 g1 g1) (g2 g2 g3 g3) to line up with the interleaved pairs.
+                const __m128 g = _mm_loadu_ps(gains + frame);
+                float* f = samples + frame * 2;
+                _mm_storeu_ps(f,     _mm_mul_ps(_mm_loadu_ps(f),     _mm_unpacklo_ps(g, g)));
+                _mm_storeu_ps(f + 4, _mm_mul_ps(_mm_loadu_ps(f + 4), _mm_unpackhi_ps(g, g)));
+            }
+        }
+#elif VC_SIMD_NEON
+        if(channelCount == 1) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                vst1q_f32(samples + frame, vmulq_f32(vld1q_f32(samples + frame), vld1q_f32(gains + frame)));
+            }
+        } else if(channelCount == 2) {
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                const float32x4_t g = vld1q_f32(gains + frame);
+                float32x4x2_t lr = vld2q_f32(samples + frame * 2);
+                lr.val[0] = vmulq_f32(lr.val[0], g);
+                lr.val[1] = vmulq_f32(lr.val[1], g);
+                vst2q_f32(samples + frame * 2, lr);
+            }
+        }
+#endif
+        for ( ; frame < frameCount ; ++frame ) {
+            const float g = gains[frame];
+            float* f = samples + frame * channelCount;
+            for ( int c = 0 ; c < channelCount ; ++c ) {
+                f[c] *= g;
+            }
+        }
+    }
+
+    void
+    applyGainRamp(float* VC_RESTRICT samples, size_t frameCount, int channelCount, float gain, float step)
+    {
+        size_t frame = 0;
+
+        // Gains are computed from the frame index rather than accumulated, so every path produces the same ramp.
+#if VC_SIMD_SSE2
+        if(channelCount == 1) {
+            __m128 n = _mm_setr_ps(1.f, 2.f, 3.f, 4.f);
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                const __m128 g = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(n, _mm_set1_ps(step)));
+                _mm_storeu_ps(samples + frame, _mm_mul_ps(_mm_loadu_ps(samples + frame), g));
+                n = _mm_add_ps(n, _mm_set1_ps(4.f));
+            }
+        } else if(channelCount == 2) {
+            __m128 n = _mm_setr_ps(1.f, 1.f, 2.f, 2.f);
+            for ( ; frame + 2 <= frameCount ; frame += 2 ) {
+                const __m128 g = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(n, _mm_set1_ps(step)));
+                float* f = samples + frame * 2;
+                _mm_storeu_ps(f, _mm_mul_ps(_mm_loadu_ps(f), g));
+                n = _mm_add_ps(n, _mm_set1_ps(2.f));
+            }
+        }
+#elif VC_SIMD_NEON
+        if(channelCount == 1 || channelCount == 2) {
+            const float init[4] = { 1.f, 2.f, 3.f, 4.f };
+            float32x4_t n = vld1q_f32(init);
+            for ( ; frame + 4 <= frameCount ; frame += 4 ) {
+                const float32x4_t g = vmlaq_n_f32(vdupq_n_f32(gain), n, step);
+                if(channelCount == 1) {
+                    vst1q_f32(samples + frame, vmulq_f32(vld1q_f32(samples + frame), g));
+                } else {
+                    float32x4x2_t lr = vld2q_f32(samples + frame * 2);
+                    lr.val[0] = vmulq_f32(lr.val[0], g);
+                    lr.val[1] = vmulq_f32(lr.val[1], g);
+                    vst2q_f32(samples + frame * 2, lr);
+                }
+                n = vaddq_f32(n, vdupq_n_f32(4.f));
+            }
+        }
+#endif
+        for ( ; frame < frameCount ; ++frame ) {
+            const float g = gain + float(frame + 1) * step;
+            float* f = samples + frame * channelCount;
+            for ( int c = 0 ; c < channelCount ; ++c ) {
+                f[c] *= g;
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,56 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__GainKernels__
+#define __videocore__GainKernels__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace audio {
+
+    /*!
+     *  Vectorized helpers for the float audio filters.  All of them work in place on interleaved samples and
+     *  fall back to scalar code for channel counts the vector paths do not handle.
+     */
+
+    /*! Returns the largest absolute value of `count` samples. */
+    float peak(const float* src, size_t count);
+
+    /*! Writes the largest absolute value across the channels of each frame to `peaks[frame]`. */
+    void framePeaks(const float* src, size_t frameCount, int channelCount, float* peaks);
+
+    /*! Multiplies `count` samples by `gain`. */
+    void applyGain(float* samples, size_t count, float gain);
+
+    /*! Multiplies each frame by `gains[frame]`. */
+    void applyFrameGains(float* samples, const float* gains, size_t frameCount, int channelCount);
+
+    /*! Multiplies frame `i` by `gain + (i + 1) * step`, a linear ramp that ends on `gain + frameCount * step`. */
+    void applyGainRamp(float* samples, size_t frameCount, int channelCount, float gain, float step);
+}
+}
+#endif /* defined(__videocore__GainKernels__) */
@@ -0,0 +1,229 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/system/h264/AnnexB.h>
+#include <videocore/system/Simd.hpp>
+
+#include <cstring>
+
+namespace videocore { namespace h264 {
+
+    // The byte that follows 00 00 in the patterns searched for.
+    enum {
+        kFollowedByOne,         // a start code
+        kFollowedByThree,       // an emulation prevention byte
+        kFollowedByAtMostThree  // a sequence that must be escaped
+    };
+
+    template<int Kind>
+    static inline bool matches(uint8_t c)
+    {
+        return Kind == kFollowedByOne ? c == 1 : Kind == kFollowedByThree ? c == 3 : c <= 3;
+    }
+
+    // Returns the offset of the first 00 00 followed by the byte Kind describes, or size.  Sixteen candidate
+    // offsets are tested at once by comparing three overlapping loads; once a block has a hit, or near the end
+    // of the data, the scalar loop takes over.
+    template<int Kind>
+    static size_t findZeroZero(const uint8_t* d, size_t size)
+    {
+        if(size < 3) {
+            return size;
+        }
+        size_t i = 0;
+
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i third = _mm_set1_epi8(Kind == kFollowedByOne ? 1 : 3);
+
+        for( ; i + 18 <= size ; i += 16 ) {
+            const __m128i a = _mm_loadu_si128((const __m128i*)(d + i));
+            const __m128i b = _mm_loadu_si128((const __m128i*)(d + i + 1));
+            const __m128i c = _mm_loadu_si128((const __m128i*)(d + i + 2));
+
+            const __m128i m3 = Kind == kFollowedByAtMostThree ? _mm_cmpeq_epi8(_mm_min_epu8(c, third), c) : _mm_cmpeq_epi8(c, third);
+            const __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)), m3);
+            const int mask = _mm_movemask_epi8(m);
+
+            if(mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#elif VC_SIMD_NEON
+        const uint8x16_t zero = vdupq_n_u8(0);
+        const uint8x16_t third = vdupq_n_u8(Kind == kFollowedByOne ? 1 : 3);
+
+        for( ; i + 18 <= size ; i += 16 ) {
+            const uint8x16_t a = vld1q_u8(d + i);
+            const uint8x16_t b = vld1q_u8(d + i + 1);
+            const uint8x16_t c = vld1q_u8(d + i + 2);
+
+            const uint8x16_t m3 = Kind == kFollowedByAtMostThree ? vcleq_u8(c, third) : vceqq_u8(c, third);
+            const uint64x2_t m = vreinterpretq_u64_u8(vandq_u8(vandq_u8(vceqq_u8(a, zero), vceqq_u8(b, zero)), m3));
+
+            if(vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) {
+                break;
+            }
+        }
+#endif
+        for( ; i + 2 < size ; ++i ) {
+            if(d[i] == 0 && d[i + 1] == 0 && matches<Kind>(d[i + 2])) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    size_t
+    findStartCode(const uint8_t* data, size_t size)
+    {
+        return findZeroZero<kFollowedByOne>(data, size);
+    }
+
+    bool
+    nextAnnexBNal(const uint8_t* data, size_t size, size_t& offset, const uint8_t*& nal, size_t& nalSize)
+    {
+        while(offset < size) {
+            const size_t start = offset + findStartCode(data + offset, size - offset);
+            if(start >= size) {
+                break;
+            }
+            const size_t begin = start + 3;
+            size_t end = begin + findStartCode(data + begin, size - begin);
+
+            offset = end;
+
+            // A NAL unit never ends in a zero byte, so these are trailing_zero_8bits or part of the next start code.
+            while(end > begin && data[end - 1] == 0) {
+                --end;
+            }
+            if(end > begin) {
+                nal = data + begin;
+                nalSize = end - begin;
+                return true;
+            }
+        }
+        offset = size;
+        return false;
+    }
+
+    static inline void writeBE32(uint8_t* p, size_t v)
+    {
+        p[0] = uint8_t(v >> 24);
+        p[1] = uint8_t(v >> 16);
+        p[2] = uint8_t(v >> 8);
+        p[3] = uint8_t(v);
+    }
+
+    size_t
+    annexBToAvcc(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        size_t offset = 0, count = 0, nalSize = 0;
+        const uint8_t* nal = nullptr;
+
+        while(nextAnnexBNal(data, size, offset, nal, nalSize)) {
+            const size_t at = out.size();
+            out.resize(at + 4 + nalSize);
+            writeBE32(&out[at], nalSize);
+            memcpy(&out[at + 4], nal, nalSize);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t
+    annexBToAvccInPlace(uint8_t* data, size_t size)
+    {
+        size_t offset = 0, written = 0, nalSize = 0;
+        const uint8_t* nal = nullptr;
+
+        // The write position never passes the read position, and the search for the next NAL unit only looks
+        // beyond the current one, so nothing is overwritten before it has been read.
+        while(nextAnnexBNal(data, size, offset, nal, nalSize)) {
+            const size_t begin = nal - data;
+            if(written + 4 > begin) {
+                return 0;
+            }
+            memmove(data + written + 4, nal, nalSize);
+            writeBE32(data + written, nalSize);
+            written += 4 + nalSize;
+        }
+        return written;
+    }
+
+    bool
+    avccToAnnexBInPlace(uint8_t* data, size_t size)
+    {
+        size_t i = 0;
+        while(size - i >= 4) {
+            const size_t nalSize = (size_t(data[i]) << 24) | (size_t(data[i + 1]) << 16) | (size_t(data[i + 2]) << 8) | size_t(data[i + 3]);
+            if(nalSize > size - i - 4) {
+                return false;
+            }
+            data[i] = data[i + 1] = data[i + 2] = 0;
+            data[i + 3] = 1;
+            i += 4 + nalSize;
+        }
+        return i == size;
+    }
+
+    size_t
+    unescapeRbsp(const uint8_t* in, size_t size, uint8_t* out)
+    {
+        size_t i = 0, n = 0;
+        while(i < size) {
+            const size_t found = i + findZeroZero<kFollowedByThree>(in + i, size - i);
+            const size_t copyEnd = found < size ? found + 2 : size;
+
+            memmove(out + n, in + i, copyEnd - i);
+            n += copyEnd - i;
+            i = found < size ? found + 3 : size;
+        }
+        return n;
+    }
+
+    size_t
+    escapeRbsp(const uint8_t* in, size_t size, uint8_t* out)
+    {
+        size_t i = 0, n = 0;
+        while(i < size) {
+            const size_t found = i + findZeroZero<kFollowedByAtMostThree>(in + i, size - i);
+            if(found >= size) {
+                memcpy(out + n, in + i, size - i);
+                n += size - i;
+                break;
+            }
+            // The 03 goes between the zeros and the byte after them, which then starts the next search.
+            memcpy(out + n, in + i, found + 2 - i);
+            n += found + 2 - i;
+            out[n++] = 3;
+            i = found + 2;
+        }
+        return n;
+    }
+
+}
+}
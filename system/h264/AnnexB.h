@@ -0,0 +1,106 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__AnnexB__
+#define __videocore__AnnexB__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace videocore { namespace h264 {
+
+    /*!
+     *  Helpers for the two H.264 byte stream formats: Annex-B, where NAL units are separated by 00 00 01 start
+     *  codes, and AVCC, where each NAL unit is preceded by its length as a 4-byte big-endian integer.  The
+     *  encoders, H264Packetizer and MP4Multiplexer all work with AVCC.
+     *
+     *  The byte searches use SSE2 or NEON and run at several GB/s, so parsing a bitstream costs next to nothing
+     *  next to copying it.
+     */
+
+    /*!
+     *  \return the offset of the first 00 00 01 start code in [data, data + size), or size if there is none.
+     */
+    size_t findStartCode(const uint8_t* data, size_t size);
+
+    /*!
+     *  Find the next NAL unit of an Annex-B stream.  The leading zero of a 4-byte start code and any trailing zero
+     *  bytes are not part of the NAL unit.
+     *
+     *  \param offset   Where to start searching.  Moved to the end of the NAL unit found.
+     *  \param nal      Set to the first byte (the NAL header) of the NAL unit.
+     *  \param nalSize  Set to the size of the NAL unit.
+     *
+     *  \return false if there are no more NAL units.
+     */
+    bool nextAnnexBNal(const uint8_t* data, size_t size, size_t& offset, const uint8_t*& nal, size_t& nalSize);
+
+    /*!
+     *  Append the NAL units of an Annex-B stream to out as AVCC.
+     *
+     *  \return the number of NAL units converted.
+     */
+    size_t annexBToAvcc(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    /*!
+     *  Convert an Annex-B stream to AVCC in place.  Each start code is replaced by the NAL unit's length, which
+     *  needs 4 bytes, so this works when the start codes are 00 00 00 01 as encoders write them.
+     *
+     *  \return the size of the AVCC data, or 0 if a 3-byte start code left no room for a length.  The data is
+     *          then partly converted; use annexBToAvcc instead.
+     */
+    size_t annexBToAvccInPlace(uint8_t* data, size_t size);
+
+    /*!
+     *  Convert AVCC to Annex-B in place, replacing each length with a 00 00 00 01 start code.
+     *
+     *  \return false if a length runs past the end of the data.  NAL units before it are converted.
+     */
+    bool avccToAnnexBInPlace(uint8_t* data, size_t size);
+
+    /*!
+     *  Remove the emulation prevention bytes (the 03 of each 00 00 03) from a NAL unit, giving its RBSP.
+     *
+     *  \param out  At least size bytes.  May be the same as in.
+     *
+     *  \return the size of the RBSP.
+     */
+    size_t unescapeRbsp(const uint8_t* in, size_t size, uint8_t* out);
+
+    /*!
+     *  Insert emulation prevention bytes into an RBSP, so that it never holds 00 00 00, 00 00 01, 00 00 02 or
+     *  00 00 03.
+     *
+     *  \param out  At least size + size / 2 + 1 bytes, not overlapping in.
+     *
+     *  \return the size of the escaped NAL unit.
+     */
+    size_t escapeRbsp(const uint8_t* in, size_t size, uint8_t* out);
+
+}
+}
+#endif /* defined(__videocore__AnnexB__) */
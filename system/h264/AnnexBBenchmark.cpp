@@ -0,0 +1,123 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Throughput of the Annex-B helpers in AnnexB.cpp on 64 MB inputs, best of five runs, with memcpy and a
+ *  byte-by-byte start code search for scale.  AnnexBTests.cpp checks their results.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/h264/AnnexB.cpp.
+ */
+
+#include <videocore/system/h264/AnnexB.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace videocore::h264;
+
+namespace {
+
+    const size_t kSize = 64 << 20;
+    const int    kRuns = 5;
+    const int    kNalSize = 1400;
+
+    volatile size_t s_sink;
+
+    size_t
+    scalarFindStartCode(const uint8_t* data, size_t size)
+    {
+        for ( size_t i = 0 ; i + 2 < size ; ++i ) {
+            if(data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /* MB/s of the best of kRuns runs over `bytes` bytes. */
+    double
+    throughput(size_t bytes, const std::function<void()>& f)
+    {
+        double best = 1e9;
+        for ( int i = 0 ; i < kRuns ; ++i ) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return bytes / best / 1e6;
+    }
+
+    size_t
+    countStartCodes(const std::vector<uint8_t>& data, size_t (*find)(const uint8_t*, size_t))
+    {
+        size_t offset = 0, count = 0;
+        while(offset < data.size()) {
+            offset += find(&data[offset], data.size() - offset) + 3;
+            ++count;
+        }
+        return count;
+    }
+}
+
+int
+main()
+{
+    std::mt19937 rng(1);
+
+    // Random bytes, and a stream of kNalSize-byte NAL units with no zero bytes inside them.
+    std::vector<uint8_t> random(kSize);
+    for ( auto& b : random ) {
+        b = uint8_t(rng());
+    }
+    std::vector<uint8_t> stream;
+    stream.reserve(kSize + kNalSize + 5);
+    while(stream.size() < kSize) {
+        stream.insert(stream.end(), { 0, 0, 0, 1, 0x41 });
+        for ( int i = 0 ; i < kNalSize ; ++i ) {
+            const uint8_t b = uint8_t(rng());
+            stream.push_back(b ? b : 0x80);
+        }
+    }
+    std::vector<uint8_t> out(kSize * 2);
+    std::vector<uint8_t> avcc;
+    avcc.reserve(stream.size() + stream.size() / 100);
+
+    printf("findStartCode, random data  %6.0f MB/s\n", throughput(kSize, [&]() { s_sink = countStartCodes(random, findStartCode); }));
+    printf("  byte-by-byte search       %6.0f MB/s\n", throughput(kSize, [&]() { s_sink = countStartCodes(random, scalarFindStartCode); }));
+    printf("annexBToAvcc, %d B NALs   %6.0f MB/s\n", kNalSize,
+           throughput(stream.size(), [&]() { avcc.clear(); s_sink = annexBToAvcc(&stream[0], stream.size(), avcc); }));
+    printf("unescapeRbsp                %6.0f MB/s\n", throughput(kSize, [&]() { s_sink = unescapeRbsp(&random[0], kSize, &out[0]); }));
+    printf("escapeRbsp                  %6.0f MB/s\n", throughput(kSize, [&]() { s_sink = escapeRbsp(&random[0], kSize, &out[0]); }));
+    printf("memcpy                      %6.0f MB/s\n", throughput(kSize, [&]() { memcpy(&out[0], &random[0], kSize); }));
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Randomized checks of the Annex-B helpers in AnnexB.cpp against straightforward scalar references:
+ *   - findStartCode finds the same offset as a byte-by-byte search;
+ *   - unescapeRbsp matches a byte-by-byte unescape, and undoes escapeRbsp;
+ *   - escaped output never holds 00 00 0x with x <= 2;
+ *   - annexBToAvcc and annexBToAvccInPlace agree with each other and with the expected lengths, and
+ *     avccToAnnexBInPlace accepts their output.
+ *
+ *  The inputs are heavy in zero bytes so start codes and escapes are common.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/h264/AnnexB.cpp.  Exits with a non-zero status on failure.
+ */
+
+#include <videocore/system/h264/AnnexB.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace videocore::h264;
+
+namespace {
+
+    const int kCases = 20000;
+
+    size_t
+    referenceFindStartCode(const uint8_t* data, size_t size)
+    {
+        for ( size_t i = 0 ; i + 2 < size ; ++i ) {
+            if(data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    size_t
+    referenceUnescape(const uint8_t* in, size_t size, uint8_t* out)
+    {
+        size_t n = 0;
+        int zeros = 0;
+        for ( size_t i = 0 ; i < size ; ++i ) {
+            if(zeros >= 2 && in[i] == 3) {
+                zeros = 0;
+                continue;
+            }
+            out[n++] = in[i];
+            zeros = in[i] ? 0 : zeros + 1;
+        }
+        return n;
+    }
+
+    /* Mostly zeros and small values, so start codes and escapes are common. */
+    std::vector<uint8_t>
+    randomBytes(std::mt19937& rng, size_t size)
+    {
+        std::vector<uint8_t> bytes(size);
+        for ( auto& b : bytes ) {
+            const int x = rng() % 8;
+            b = uint8_t(x < 4 ? 0 : x < 6 ? rng() % 4 : rng());
+        }
+        return bytes;
+    }
+
+    int s_failures = 0;
+
+    void
+    expect(bool condition, const char* what, int testCase)
+    {
+        if(!condition) {
+            if(s_failures < 20) {
+                printf("FAIL case %d: %s\n", testCase, what);
+            }
+            ++s_failures;
+        }
+    }
+}
+
+int
+main()
+{
+    std::mt19937 rng(1);
+
+    for ( int t = 0 ; t < kCases ; ++t ) {
+        const std::vector<uint8_t> data = randomBytes(rng, rng() % 200);
+        const size_t n = data.size();
+        const uint8_t* d = data.empty() ? nullptr : &data[0];
+
+        expect(findStartCode(d, n) == referenceFindStartCode(d, n), "findStartCode", t);
+
+        std::vector<uint8_t> escaped(n + n / 2 + 1), unescaped(escaped.size()), reference(n + 1);
+        const size_t escapedSize = escapeRbsp(d, n, &escaped[0]);
+        bool clean = true;
+        for ( size_t i = 0 ; i + 2 < escapedSize ; ++i ) {
+            clean &= !(escaped[i] == 0 && escaped[i + 1] == 0 && escaped[i + 2] <= 2);
+        }
+        expect(clean, "escapeRbsp leaves no 00 00 0x with x <= 2", t);
+
+        const size_t roundTrip = unescapeRbsp(&escaped[0], escapedSize, &unescaped[0]);
+        expect(roundTrip == n && memcmp(&unescaped[0], d, n) == 0, "unescapeRbsp undoes escapeRbsp", t);
+
+        const size_t referenceSize = referenceUnescape(d, n, &reference[0]);
+        const size_t unescapedSize = unescapeRbsp(d, n, &unescaped[0]);
+        expect(unescapedSize == referenceSize && memcmp(&unescaped[0], &reference[0], referenceSize) == 0,
+               "unescapeRbsp matches the reference", t);
+
+        // An Annex-B stream of escaped NAL units with 4-byte start codes, some followed by a trailing zero.
+        std::vector<uint8_t> annexB, expected;
+        const int nalCount = 1 + rng() % 4;
+        for ( int j = 0 ; j < nalCount ; ++j ) {
+            std::vector<uint8_t> payload = randomBytes(rng, 1 + rng() % 50);
+            payload[0] = 0x65;
+            payload.back() |= 0x80;
+            std::vector<uint8_t> nal(payload.size() * 2 + 1);
+            nal.resize(escapeRbsp(&payload[0], payload.size(), &nal[0]));
+
+            annexB.insert(annexB.end(), { 0, 0, 0, 1 });
+            annexB.insert(annexB.end(), nal.begin(), nal.end());
+            if(rng() % 3 == 0) {
+                annexB.push_back(0);
+            }
+            const uint32_t length = uint32_t(nal.size());
+            expected.insert(expected.end(), { uint8_t(length >> 24), uint8_t(length >> 16), uint8_t(length >> 8), uint8_t(length) });
+            expected.insert(expected.end(), nal.begin(), nal.end());
+        }
+
+        std::vector<uint8_t> avcc;
+        expect(annexBToAvcc(&annexB[0], annexB.size(), avcc) == size_t(nalCount), "annexBToAvcc NAL count", t);
+        expect(avcc == expected, "annexBToAvcc output", t);
+
+        std::vector<uint8_t> inPlace = annexB;
+        const size_t inPlaceSize = annexBToAvccInPlace(&inPlace[0], inPlace.size());
+        expect(inPlaceSize == avcc.size() && memcmp(&inPlace[0], &avcc[0], inPlaceSize) == 0, "annexBToAvccInPlace output", t);
+
+        expect(avccToAnnexBInPlace(&avcc[0], avcc.size()), "avccToAnnexBInPlace accepts AVCC", t);
+    }
+
+    printf(s_failures ? "%d failures\n" : "all %d cases passed\n", s_failures ? s_failures : kCases);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/system/h264/BitReader.h>
+
+namespace videocore { namespace h264 {
+
+    static const uint64_t kOnes   = 0x0101010101010101ULL;
+    static const uint64_t kHighs  = 0x8080808080808080ULL;
+
+    // Exp-Golomb codes of H.264 syntax elements have at most 31 leading zeros.
+    static const int kMaxLeadingZeros = 31;
+
+    static inline bool hasZeroByte(uint64_t v)
+    {
+        return ((v - kOnes) & ~v & kHighs) != 0;
+    }
+
+    BitReader::BitReader(const uint8_t* data, size_t size, bool skipEmulationPrevention)
+    : m_pos(data), m_end(data + size), m_cache(0), m_cacheBits(0), m_zeroBytes(0), m_bitsRead(0),
+    m_skipEmulationPrevention(skipEmulationPrevention), m_error(false)
+    {
+        refill();
+    }
+    void
+    BitReader::refill()
+    {
+        const int count = (64 - m_cacheBits) >> 3;
+
+        if(count > 0 && m_end - m_pos >= 8) {
+            const uint64_t v = (uint64_t(m_pos[0]) << 56) | (uint64_t(m_pos[1]) << 48) | (uint64_t(m_pos[2]) << 40) |
+                               (uint64_t(m_pos[3]) << 32) | (uint64_t(m_pos[4]) << 24) | (uint64_t(m_pos[5]) << 16) |
+                               (uint64_t(m_pos[6]) << 8)  |  uint64_t(m_pos[7]);
+            const uint64_t bytes = count == 8 ? v : v >> (64 - 8 * count);
+
+            // Without an 03 among the bytes there is nothing to skip, which is nearly always the case.
+            const uint64_t unused = count == 8 ? 0 : ~0ULL << (8 * count);
+            if(!m_skipEmulationPrevention || !hasZeroByte((bytes ^ (kOnes * 3)) | unused)) {
+                m_cache |= bytes << (64 - m_cacheBits - 8 * count);
+                m_cacheBits += 8 * count;
+                m_pos += count;
+                m_zeroBytes = bytes ? __builtin_ctzll(bytes) >> 3 : m_zeroBytes + count;
+                return;
+            }
+        }
+
+        while(m_cacheBits <= 56 && m_pos < m_end) {
+            const uint8_t byte = *m_pos++;
+
+            if(m_skipEmulationPrevention && byte == 3 && m_zeroBytes >= 2) {
+                m_zeroBytes = 0;
+                continue;
+            }
+            m_zeroBytes = byte ? 0 : m_zeroBytes + 1;
+            m_cache |= uint64_t(byte) << (56 - m_cacheBits);
+            m_cacheBits += 8;
+        }
+    }
+    uint32_t
+    BitReader::readBitsSlow(int count)
+    {
+        if(count <= 0) {
+            return 0;
+        }
+        refill();
+        if(m_cacheBits < count) {
+            // Out of data: the cache is zero past m_cacheBits.
+            m_error = true;
+            m_cacheBits = count;
+        }
+        return readBits(count);
+    }
+    void
+    BitReader::skipBits(size_t count)
+    {
+        while(count > 32) {
+            readBits(32);
+            count -= 32;
+        }
+        readBits(int(count));
+    }
+    uint32_t
+    BitReader::readLongUE(int zeros)
+    {
+        if(zeros > kMaxLeadingZeros) {
+            m_error = true;
+            skipBits(zeros);
+            return 0;
+        }
+        skipBits(zeros);
+        return uint32_t(uint64_t(readBits(zeros + 1)) - 1);
+    }
+    int32_t
+    BitReader::readSE()
+    {
+        const uint32_t k = readUE();
+
+        // 1, 2, 3, 4 ... map to 1, -1, 2, -2 ...
+        return (k & 1) ? int32_t((k >> 1) + 1) : -int32_t(k >> 1);
+    }
+
+}
+}
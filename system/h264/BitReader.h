@@ -0,0 +1,130 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__BitReader__
+#define __videocore__BitReader__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace h264 {
+
+    /*!
+     *  Reads the fields of an H.264 NAL unit payload (SPS, PPS, slice headers) MSB first.
+     *
+     *  Bits come from a 64-bit cache refilled up to eight bytes at a time, and ue(v)/se(v) are decoded with a
+     *  single count-leading-zeros.  Emulation prevention bytes (the 03 of 00 00 03) are skipped as the cache is
+     *  filled, so the caller sees the RBSP.  The input is never written to.
+     *
+     *  Reading past the end of the data returns zero bits and sets error(), so a parser can read a whole
+     *  header and check once at the end.
+     */
+    class BitReader
+    {
+    public:
+        /*!
+         *  \param data                     The payload, starting after the NAL header byte or bytes.
+         *  \param size                     Its size in bytes.
+         *  \param skipEmulationPrevention  false if the data has already been unescaped.
+         */
+        BitReader(const uint8_t* data, size_t size, bool skipEmulationPrevention = true);
+
+        /*! Read 0 to 32 bits. */
+        uint32_t readBits(int count)
+        {
+            if(count <= 0 || m_cacheBits < count) {
+                return readBitsSlow(count);
+            }
+            const uint32_t value = uint32_t(m_cache >> (64 - count));
+            m_cache <<= count;
+            m_cacheBits -= count;
+            m_bitsRead += count;
+            return value;
+        };
+
+        /*! Read one bit, u(1). */
+        bool     readBit() { return readBits(1) != 0; };
+
+        /*! Skip any number of bits. */
+        void     skipBits(size_t count);
+
+        /*! Read an unsigned Exp-Golomb code, ue(v). */
+        uint32_t readUE()
+        {
+            if(m_cacheBits < 32) {
+                refill();
+            }
+            const int zeros = __builtin_clzll(m_cache | 1);
+            const int length = 2 * zeros + 1;
+
+            if(length > m_cacheBits) {
+                return readLongUE(zeros);
+            }
+            const uint32_t value = uint32_t(m_cache >> (64 - length)) - 1;
+            m_cache <<= length;
+            m_cacheBits -= length;
+            m_bitsRead += length;
+            return value;
+        };
+
+        /*! Read a signed Exp-Golomb code, se(v). */
+        int32_t  readSE();
+
+        /*! Skip to the next byte boundary of the RBSP. */
+        void     byteAlign() { skipBits((8 - m_bitsRead % 8) % 8); };
+
+        /*! Bits of RBSP consumed so far. */
+        size_t   bitsRead() const { return m_bitsRead; };
+
+        /*! true once a read ran past the end of the data or met an Exp-Golomb code longer than 32 bits. */
+        bool     error() const { return m_error; };
+
+    private:
+        /*! Top the cache up to at least 57 bits, or with whatever is left of the data. */
+        void     refill();
+
+        /*! readBits when the cache runs short. */
+        uint32_t readBitsSlow(int count);
+
+        /*! readUE for a code longer than the cache holds, or a malformed one. */
+        uint32_t readLongUE(int zeros);
+
+    private:
+        const uint8_t* m_pos;
+        const uint8_t* m_end;
+
+        uint64_t       m_cache;      /* the next m_cacheBits bits, MSB aligned; the rest are zero */
+        int            m_cacheBits;
+        int            m_zeroBytes;  /* zero bytes read into the cache immediately before m_pos */
+
+        size_t         m_bitsRead;
+        bool           m_skipEmulationPrevention;
+        bool           m_error;
+    };
+
+}
+}
+#endif /* defined(__videocore__BitReader__) */
@@ -0,0 +1,163 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Decoding speed of BitReader on a stream of 2M ue(v) codes shaped like header and slice syntax (mostly below 8,
+ *  a quarter below 1000), best of seven runs: ue(v) with and without emulation prevention skipping, se(v), and
+ *  readBits(5).  A bit-at-a-time reader is timed on the same codes for scale.  BitReaderTests.cpp checks the
+ *  results.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/h264/BitReader.cpp and system/h264/AnnexB.cpp.
+ */
+
+#include <videocore/system/h264/BitReader.h>
+#include <videocore/system/h264/AnnexB.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace videocore::h264;
+
+namespace {
+
+    const size_t kCodes = 2000000;
+    const int    kRuns = 7;
+
+    volatile uint64_t s_sink;
+
+    /* Best of kRuns runs, in ns per item. */
+    double
+    nsPer(size_t items, const std::function<void()>& f)
+    {
+        double best = 1e9;
+        for ( int i = 0 ; i < kRuns ; ++i ) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best / items * 1e9;
+    }
+
+    /* The textbook decoder: one bit at a time, with no emulation prevention. */
+    class SimpleReader {
+    public:
+        SimpleReader(const uint8_t* data) : m_data(data), m_bit(0) {};
+
+        uint32_t readBit() {
+            const uint32_t bit = (m_data[m_bit >> 3] >> (7 - (m_bit & 7))) & 1;
+            ++m_bit;
+            return bit;
+        }
+        uint32_t readUE() {
+            int zeros = 0;
+            while(!readBit()) {
+                ++zeros;
+            }
+            uint32_t value = 1;
+            for ( int i = 0 ; i < zeros ; ++i ) {
+                value = value << 1 | readBit();
+            }
+            return value - 1;
+        }
+
+    private:
+        const uint8_t* m_data;
+        size_t         m_bit;
+    };
+
+    void
+    put(std::vector<uint8_t>& bytes, int& bitCount, uint32_t value, int count)
+    {
+        for ( int i = count - 1 ; i >= 0 ; --i ) {
+            if(bitCount % 8 == 0) {
+                bytes.push_back(0);
+            }
+            bytes.back() |= uint8_t(((value >> i) & 1) << (7 - bitCount % 8));
+            ++bitCount;
+        }
+    }
+}
+
+int
+main()
+{
+    std::mt19937 rng(5);
+
+    std::vector<uint8_t> rbsp;
+    int bitCount = 0;
+    for ( size_t i = 0 ; i < kCodes ; ++i ) {
+        const uint32_t code = (rng() % 4 == 0 ? rng() % 1000 : rng() % 8) + 1;
+        const int length = 31 - __builtin_clz(code);
+        put(rbsp, bitCount, 0, length);
+        put(rbsp, bitCount, code, length + 1);
+    }
+    put(rbsp, bitCount, 1, 1);
+
+    std::vector<uint8_t> escaped(rbsp.size() + rbsp.size() / 2 + 1);
+    escaped.resize(escapeRbsp(&rbsp[0], rbsp.size(), &escaped[0]));
+
+    printf("%zu codes, %zu bytes, %zu emulation prevention bytes, best of %d\n", kCodes, rbsp.size(),
+           escaped.size() - rbsp.size(), kRuns);
+
+    printf("ue(v)                        %5.2f ns/code\n", nsPer(kCodes, [&]() {
+        BitReader reader(&escaped[0], escaped.size());
+        uint64_t sum = 0;
+        for ( size_t i = 0 ; i < kCodes ; ++i ) sum += reader.readUE();
+        s_sink = sum;
+    }));
+    printf("ue(v), RBSP input            %5.2f ns/code\n", nsPer(kCodes, [&]() {
+        BitReader reader(&rbsp[0], rbsp.size(), false);
+        uint64_t sum = 0;
+        for ( size_t i = 0 ; i < kCodes ; ++i ) sum += reader.readUE();
+        s_sink = sum;
+    }));
+    printf("se(v)                        %5.2f ns/code\n", nsPer(kCodes, [&]() {
+        BitReader reader(&escaped[0], escaped.size());
+        int64_t sum = 0;
+        for ( size_t i = 0 ; i < kCodes ; ++i ) sum += reader.readSE();
+        s_sink = uint64_t(sum);
+    }));
+    const size_t fields = rbsp.size() * 8 / 5;
+    printf("readBits(5)                  %5.2f ns/field\n", nsPer(fields, [&]() {
+        BitReader reader(&escaped[0], escaped.size());
+        uint64_t sum = 0;
+        for ( size_t i = 0 ; i < fields ; ++i ) sum += reader.readBits(5);
+        s_sink = sum;
+    }));
+    printf("ue(v), bit at a time, RBSP   %5.2f ns/code\n", nsPer(kCodes, [&]() {
+        SimpleReader reader(&rbsp[0]);
+        uint64_t sum = 0;
+        for ( size_t i = 0 ; i < kCodes ; ++i ) sum += reader.readUE();
+        s_sink = sum;
+    }));
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Randomized round trips through BitReader.  Each case writes a random mix of u(n) fields of 0 to 32 bits,
+ *  ue(v) and se(v) codes (including the longest, 0xFFFFFFFE), skips and byte alignments with a straightforward
+ *  bit writer, escapes the result with escapeRbsp, and checks that:
+ *   - BitReader reads every field back, both from the escaped data and, with emulation prevention skipping
+ *     off, from the RBSP;
+ *   - bitsRead() counts RBSP bits;
+ *   - error() stays clear until a read runs past the end, and is set once one does;
+ *   - an Exp-Golomb code with more than 31 leading zeros sets error().
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/h264/BitReader.cpp and system/h264/AnnexB.cpp.  Exits with a non-zero status on failure.
+ */
+
+#include <videocore/system/h264/BitReader.h>
+#include <videocore/system/h264/AnnexB.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace videocore::h264;
+
+namespace {
+
+    const int kCases = 3000;
+
+    /* MSB-first bit writer with ue(v) and se(v) as the spec defines them. */
+    class BitWriter {
+    public:
+        BitWriter() : m_bits(0), m_count(0) {};
+
+        void put(uint32_t value, int count) {
+            for ( int i = count - 1 ; i >= 0 ; --i ) {
+                m_bits = uint8_t(m_bits << 1 | ((value >> i) & 1));
+                if(++m_count == 8) {
+                    bytes.push_back(m_bits);
+                    m_count = 0;
+                }
+            }
+        }
+        void putUE(uint32_t value) {
+            // value is at most 0xFFFFFFFE, so the code has at most 31 leading zeros and fits in 32 bits.
+            const uint32_t code = value + 1;
+            const int length = 31 - __builtin_clz(code);
+            put(0, length);
+            put(code, length + 1);
+        }
+        void putSE(int32_t value) {
+            putUE(value > 0 ? uint32_t(2 * int64_t(value) - 1) : uint32_t(-2 * int64_t(value)));
+        }
+        void byteAlign() { while(m_count) put(0, 1); }
+        size_t bitCount() const { return bytes.size() * 8 + m_count; }
+
+        std::vector<uint8_t> bytes;
+
+    private:
+        uint8_t m_bits;
+        int     m_count;
+    };
+
+    enum FieldType { kFieldBits, kFieldUE, kFieldSE, kFieldSkip, kFieldAlign };
+
+    struct Field {
+        FieldType type;
+        int       count;
+        uint32_t  value;
+    };
+
+    /* Values that are mostly small, as in real headers, with the occasional large or longest one. */
+    uint32_t
+    randomUE(std::mt19937& rng)
+    {
+        switch(rng() % 8) {
+            case 0:  return 0xFFFFFFFEu - rng() % 4;
+            case 1:  return rng() % 0xFFFFFFFEu;
+            case 2:  return rng() % 100000;
+            default: return rng() % 20;
+        }
+    }
+
+    std::vector<Field>
+    randomFields(std::mt19937& rng, BitWriter& writer)
+    {
+        std::vector<Field> fields(rng() % 300);
+        for ( auto& f : fields ) {
+            f.type = FieldType(rng() % 5);
+            f.count = 0;
+            f.value = 0;
+            switch(f.type) {
+                case kFieldBits:
+                    f.count = rng() % 33;
+                    f.value = f.count ? uint32_t(rng()) >> (32 - f.count) : 0;
+                    // Runs of zero bytes, so the escaper has something to do.
+                    f.value = rng() % 3 ? 0 : f.value;
+                    writer.put(f.value, f.count);
+                    break;
+                case kFieldUE:
+                    f.value = randomUE(rng);
+                    writer.putUE(f.value);
+                    break;
+                case kFieldSE:
+                    f.value = uint32_t(int32_t(rng() % 200001) - 100000);
+                    writer.putSE(int32_t(f.value));
+                    break;
+                case kFieldSkip:
+                    f.count = rng() % 100;
+                    writer.put(0, f.count % 32);
+                    for ( int i = 0 ; i < f.count / 32 ; ++i ) {
+                        writer.put(0, 32);
+                    }
+                    break;
+                case kFieldAlign:
+                    writer.byteAlign();
+                    break;
+            }
+        }
+        // rbsp_stop_one_bit and alignment.
+        writer.put(1, 1);
+        writer.byteAlign();
+        return fields;
+    }
+
+    int s_failures = 0;
+
+    void
+    expect(bool condition, const char* what, int testCase)
+    {
+        if(!condition) {
+            if(s_failures < 20) {
+                printf("FAIL case %d: %s\n", testCase, what);
+            }
+            ++s_failures;
+        }
+    }
+
+    void
+    readBack(BitReader& reader, const std::vector<Field>& fields, size_t rbspBits, int t)
+    {
+        bool match = true;
+        for ( auto& f : fields ) {
+            switch(f.type) {
+                case kFieldBits:  match &= reader.readBits(f.count) == f.value; break;
+                case kFieldUE:    match &= reader.readUE() == f.value; break;
+                case kFieldSE:    match &= reader.readSE() == int32_t(f.value); break;
+                case kFieldSkip:  reader.skipBits(f.count); break;
+                case kFieldAlign: reader.byteAlign(); break;
+            }
+        }
+        expect(match, "every field reads back", t);
+        expect(reader.readBit(), "the stop bit follows the fields", t);
+        reader.byteAlign();
+        expect(reader.bitsRead() == rbspBits, "bitsRead counts the RBSP", t);
+        expect(!reader.error(), "no error within the data", t);
+        reader.readBits(1);
+        expect(reader.error(), "error once past the end", t);
+    }
+}
+
+int
+main()
+{
+    std::mt19937 rng(1);
+
+    for ( int t = 0 ; t < kCases ; ++t ) {
+        BitWriter writer;
+        const std::vector<Field> fields = randomFields(rng, writer);
+        const std::vector<uint8_t>& rbsp = writer.bytes;
+
+        std::vector<uint8_t> escaped(rbsp.size() + rbsp.size() / 2 + 1);
+        escaped.resize(escapeRbsp(&rbsp[0], rbsp.size(), &escaped[0]));
+
+        BitReader reader(&escaped[0], escaped.size());
+        readBack(reader, fields, writer.bitCount(), t);
+
+        BitReader unescaped(&rbsp[0], rbsp.size(), false);
+        readBack(unescaped, fields, writer.bitCount(), t);
+    }
+
+    // 32 leading zeros: longer than ue(v) allows.
+    const uint8_t tooLong[] = { 0, 0, 0, 0, 0x80, 0, 0, 0, 0, 0x80 };
+    BitReader reader(tooLong, sizeof(tooLong), false);
+    reader.readUE();
+    expect(reader.error(), "a ue(v) with 32 leading zeros sets error", kCases);
+
+    printf(s_failures ? "%d failures\n" : "all %d cases passed\n", s_failures ? s_failures : kCases);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/system/h264/ParameterSets.h>
+#include <videocore/system/h264/BitReader.h>
+
+namespace videocore { namespace h264 {
+
+    // Sample aspect ratios for aspect_ratio_idc 1 to 16 (Table E-1).  255 is Extended_SAR, coded explicitly.
+    static const int kSampleAspectRatios[17][2] = {
+        { 1, 1 },  { 1, 1 },   { 12, 11 }, { 10, 11 }, { 16, 11 }, { 40, 33 }, { 24, 11 }, { 20, 11 }, { 32, 11 },
+        { 80, 33 }, { 18, 11 }, { 15, 11 }, { 64, 33 }, { 160, 99 }, { 4, 3 },  { 3, 2 },   { 2, 1 }
+    };
+    static const int kExtendedSar = 255;
+
+    // Sanity limits on values used as sizes, well beyond any level's.
+    static const uint32_t kMaxMbsPerDimension = 1024;
+    static const uint32_t kMaxCountInLoop = 256;
+
+    static void skipScalingList(BitReader& reader, int size)
+    {
+        int lastScale = 8, nextScale = 8;
+        for ( int j = 0 ; j < size ; ++j ) {
+            if(nextScale != 0) {
+                nextScale = (lastScale + reader.readSE() + 256) % 256;
+            }
+            lastScale = nextScale ? nextScale : lastScale;
+        }
+    }
+
+    static void skipHrdParameters(BitReader& reader)
+    {
+        const uint32_t cpbCount = reader.readUE() + 1;
+        reader.skipBits(4 + 4);                         // bit_rate_scale, cpb_size_scale
+        for ( uint32_t i = 0 ; i < cpbCount && i < kMaxCountInLoop ; ++i ) {
+            reader.readUE();                            // bit_rate_value_minus1
+            reader.readUE();                            // cpb_size_value_minus1
+            reader.skipBits(1);                         // cbr_flag
+        }
+        reader.skipBits(5 + 5 + 5 + 5);                 // the four delay and offset lengths
+    }
+
+    static void parseVui(BitReader& reader, SequenceParameterSet& sps)
+    {
+        if(reader.readBit()) {                          // aspect_ratio_info_present_flag
+            const int idc = reader.readBits(8);
+            if(idc == kExtendedSar) {
+                sps.sarWidth = reader.readBits(16);
+                sps.sarHeight = reader.readBits(16);
+            } else if(idc > 0 && idc <= 16) {
+                sps.sarWidth = kSampleAspectRatios[idc][0];
+                sps.sarHeight = kSampleAspectRatios[idc][1];
+            }
+        }
+        if(reader.readBit()) {                          // overscan_info_present_flag
+            reader.skipBits(1);
+        }
+        if(reader.readBit()) {                          // video_signal_type_present_flag
+            sps.videoFormat = reader.readBits(3);
+            sps.fullRange = reader.readBit();
+            if(reader.readBit()) {                      // colour_description_present_flag
+                sps.colourPrimaries = reader.readBits(8);
+                sps.transferCharacteristics = reader.readBits(8);
+                sps.matrixCoefficients = reader.readBits(8);
+            }
+        }
+        if(reader.readBit()) {                          // chroma_loc_info_present_flag
+            reader.readUE();
+            reader.readUE();
+        }
+        if(reader.readBit()) {                          // timing_info_present_flag
+            sps.numUnitsInTick = reader.readBits(32);
+            sps.timeScale = reader.readBits(32);
+            sps.fixedFrameRate = reader.readBit();
+        }
+        const bool nalHrd = reader.readBit();
+        if(nalHrd) {
+            skipHrdParameters(reader);
+        }
+        const bool vclHrd = reader.readBit();
+        if(vclHrd) {
+            skipHrdParameters(reader);
+        }
+        if(nalHrd || vclHrd) {
+            reader.skipBits(1);                         // low_delay_hrd_flag
+        }
+        reader.skipBits(1);                             // pic_struct_present_flag
+        if(reader.readBit()) {                          // bitstream_restriction_flag
+            reader.skipBits(1);                         // motion_vectors_over_pic_boundaries_flag
+            reader.readUE();                            // max_bytes_per_pic_denom
+            reader.readUE();                            // max_bits_per_mb_denom
+            reader.readUE();                            // log2_max_mv_length_horizontal
+            reader.readUE();                            // log2_max_mv_length_vertical
+            sps.maxNumReorderFrames = reader.readUE();
+            reader.readUE();                            // max_dec_frame_buffering
+        }
+    }
+
+    bool
+    parseSequenceParameterSet(const uint8_t* nal, size_t size, SequenceParameterSet& sps)
+    {
+        if(size < 4 || (nal[0] & 0x1F) != 7) {
+            return false;
+        }
+        BitReader reader(nal + 1, size - 1);
+        sps = SequenceParameterSet();
+
+        sps.profileIdc = reader.readBits(8);
+        sps.constraintFlags = reader.readBits(8);
+        sps.levelIdc = reader.readBits(8);
+        sps.id = reader.readUE();
+
+        switch(sps.profileIdc) {
+            case 100: case 110: case 122: case 244: case 44: case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            {
+                sps.chromaFormatIdc = reader.readUE();
+                if(sps.chromaFormatIdc == 3) {
+                    sps.separateColourPlane = reader.readBit();
+                }
+                sps.bitDepthLuma = reader.readUE() + 8;
+                sps.bitDepthChroma = reader.readUE() + 8;
+                reader.skipBits(1);                     // qpprime_y_zero_transform_bypass_flag
+                if(reader.readBit()) {                  // seq_scaling_matrix_present_flag
+                    const int lists = sps.chromaFormatIdc != 3 ? 8 : 12;
+                    for ( int i = 0 ; i < lists ; ++i ) {
+                        if(reader.readBit()) {
+                            skipScalingList(reader, i < 6 ? 16 : 64);
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        sps.log2MaxFrameNum = reader.readUE() + 4;
+        sps.picOrderCntType = reader.readUE();
+        if(sps.picOrderCntType == 0) {
+            sps.log2MaxPicOrderCntLsb = reader.readUE() + 4;
+        } else if(sps.picOrderCntType == 1) {
+            reader.skipBits(1);                         // delta_pic_order_always_zero_flag
+            reader.readSE();                            // offset_for_non_ref_pic
+            reader.readSE();                            // offset_for_top_to_bottom_field
+            const uint32_t cycle = reader.readUE();
+            if(cycle >= kMaxCountInLoop) {
+                return false;
+            }
+            for ( uint32_t i = 0 ; i < cycle ; ++i ) {
+                reader.readSE();
+            }
+        }
+        sps.maxNumRefFrames = reader.readUE();
+        reader.skipBits(1);                             // gaps_in_frame_num_value_allowed_flag
+
+        const uint32_t widthInMbs = reader.readUE() + 1;
+        const uint32_t heightInMapUnits = reader.readUE() + 1;
+        sps.frameMbsOnly = reader.readBit();
+        if(!sps.frameMbsOnly) {
+            reader.skipBits(1);                         // mb_adaptive_frame_field_flag
+        }
+        reader.skipBits(1);                             // direct_8x8_inference_flag
+
+        if(widthInMbs > kMaxMbsPerDimension || heightInMapUnits > kMaxMbsPerDimension || sps.chromaFormatIdc > 3) {
+            return false;
+        }
+        const int fieldFactor = sps.frameMbsOnly ? 1 : 2;
+        sps.codedWidth = widthInMbs * 16;
+        sps.codedHeight = heightInMapUnits * 16 * fieldFactor;
+
+        if(reader.readBit()) {                          // frame_cropping_flag
+            // Crop offsets count chroma samples, and field pairs when interlaced (7.4.2.1.1).
+            const int chromaArrayType = sps.separateColourPlane ? 0 : sps.chromaFormatIdc;
+            const int cropUnitX = (chromaArrayType == 1 || chromaArrayType == 2) ? 2 : 1;
+            const int cropUnitY = (chromaArrayType == 1 ? 2 : 1) * fieldFactor;
+
+            sps.cropLeft = reader.readUE() * cropUnitX;
+            sps.cropRight = reader.readUE() * cropUnitX;
+            sps.cropTop = reader.readUE() * cropUnitY;
+            sps.cropBottom = reader.readUE() * cropUnitY;
+        }
+        sps.width = sps.codedWidth - sps.cropLeft - sps.cropRight;
+        sps.height = sps.codedHeight - sps.cropTop - sps.cropBottom;
+
+        sps.vuiPresent = reader.readBit();
+        if(sps.vuiPresent) {
+            parseVui(reader, sps);
+        }
+        return !reader.error() && sps.width > 0 && sps.height > 0;
+    }
+
+    bool
+    parsePictureParameterSet(const uint8_t* nal, size_t size, PictureParameterSet& pps)
+    {
+        if(size < 2 || (nal[0] & 0x1F) != 8) {
+            return false;
+        }
+        BitReader reader(nal + 1, size - 1);
+        pps = PictureParameterSet();
+
+        pps.id = reader.readUE();
+        pps.spsId = reader.readUE();
+        pps.entropyCodingMode = reader.readBit();
+        pps.bottomFieldPicOrderInFramePresent = reader.readBit();
+        pps.numSliceGroups = reader.readUE() + 1;
+
+        if(pps.numSliceGroups > 1) {
+            if(pps.numSliceGroups > 8) {
+                return false;
+            }
+            const uint32_t mapType = reader.readUE();
+            if(mapType == 0) {
+                for ( int i = 0 ; i < pps.numSliceGroups ; ++i ) {
+                    reader.readUE();                    // run_length_minus1
+                }
+            } else if(mapType == 2) {
+                for ( int i = 0 ; i < pps.numSliceGroups - 1 ; ++i ) {
+                    reader.readUE();                    // top_left
+                    reader.readUE();                    // bottom_right
+                }
+            } else if(mapType >= 3 && mapType <= 5) {
+                reader.skipBits(1);                     // slice_group_change_direction_flag
+                reader.readUE();                        // slice_group_change_rate_minus1
+            } else if(mapType == 6) {
+                const uint32_t mapUnits = reader.readUE() + 1;
+                if(mapUnits > kMaxMbsPerDimension * kMaxMbsPerDimension) {
+                    return false;
+                }
+                int bits = 0;
+                while((1 << bits) < pps.numSliceGroups) {
+                    ++bits;
+                }
+                reader.skipBits(size_t(mapUnits) * bits); // slice_group_id
+            }
+        }
+        pps.numRefIdxL0DefaultActive = reader.readUE() + 1;
+        pps.numRefIdxL1DefaultActive = reader.readUE() + 1;
+        pps.weightedPred = reader.readBit();
+        pps.weightedBipredIdc = reader.readBits(2);
+        pps.picInitQp = 26 + reader.readSE();
+        pps.picInitQs = 26 + reader.readSE();
+        pps.chromaQpIndexOffset = reader.readSE();
+        pps.deblockingFilterControlPresent = reader.readBit();
+        pps.constrainedIntraPred = reader.readBit();
+        pps.redundantPicCntPresent = reader.readBit();
+
+        return !reader.error();
+    }
+
+}
+}
@@ -0,0 +1,127 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#ifndef __videocore__ParameterSets__
+#define __videocore__ParameterSets__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace h264 {
+
+    /*!
+     *  The fields of an H.264 sequence parameter set (7.3.2.1) and its VUI (E.1.1) that describe the video
+     *  format.  Defaults are those the spec infers when a field is absent.
+     */
+    struct SequenceParameterSet
+    {
+        int      profileIdc = 0;
+        int      constraintFlags = 0;       /* constraint_set0_flag .. constraint_set5_flag and reserved bits */
+        int      levelIdc = 0;
+        int      id = 0;
+
+        int      chromaFormatIdc = 1;       /* 0 monochrome, 1 4:2:0, 2 4:2:2, 3 4:4:4 */
+        bool     separateColourPlane = false;
+        int      bitDepthLuma = 8;
+        int      bitDepthChroma = 8;
+
+        int      log2MaxFrameNum = 4;
+        int      picOrderCntType = 0;
+        int      log2MaxPicOrderCntLsb = 4;
+        int      maxNumRefFrames = 0;
+        bool     frameMbsOnly = true;
+
+        int      codedWidth = 0;            /* in luma samples, whole macroblocks */
+        int      codedHeight = 0;
+        int      cropLeft = 0;              /* in luma samples */
+        int      cropRight = 0;
+        int      cropTop = 0;
+        int      cropBottom = 0;
+        int      width = 0;                 /* after cropping */
+        int      height = 0;
+
+        bool     vuiPresent = false;
+        int      sarWidth = 1;              /* sample aspect ratio */
+        int      sarHeight = 1;
+        int      videoFormat = 5;           /* unspecified */
+        bool     fullRange = false;
+        int      colourPrimaries = 2;       /* unspecified */
+        int      transferCharacteristics = 2;
+        int      matrixCoefficients = 2;
+        uint32_t numUnitsInTick = 0;
+        uint32_t timeScale = 0;
+        bool     fixedFrameRate = false;
+        int      maxNumReorderFrames = -1;  /* -1 when the VUI does not say */
+
+        /*!
+         *  The frame rate given by the VUI timing info, or 0 if there is none.  Without fixedFrameRate the timing
+         *  info only gives the resolution of the timestamps (x264 with variable frame rate input writes its
+         *  timebase), so 0 is returned then too.
+         */
+        double frameRate() const { return fixedFrameRate && numUnitsInTick && timeScale ? timeScale / (2. * numUnitsInTick) : 0.; };
+    };
+
+    /*!
+     *  The fields of an H.264 picture parameter set (7.3.2.2) that do not depend on its SPS.  Slice group maps
+     *  are skipped.
+     */
+    struct PictureParameterSet
+    {
+        int      id = 0;
+        int      spsId = 0;
+        bool     entropyCodingMode = false; /* CABAC */
+        bool     bottomFieldPicOrderInFramePresent = false;
+        int      numSliceGroups = 1;
+        int      numRefIdxL0DefaultActive = 1;
+        int      numRefIdxL1DefaultActive = 1;
+        bool     weightedPred = false;
+        int      weightedBipredIdc = 0;
+        int      picInitQp = 26;
+        int      picInitQs = 26;
+        int      chromaQpIndexOffset = 0;
+        bool     deblockingFilterControlPresent = false;
+        bool     constrainedIntraPred = false;
+        bool     redundantPicCntPresent = false;
+    };
+
+    /*!
+     *  Parse an SPS NAL unit.
+     *
+     *  \param nal   The NAL unit, starting with its header byte, with emulation prevention bytes in place.
+     *  \param size  Its size in bytes.
+     *
+     *  \return false if the data is not an SPS or is truncated or out of range.
+     */
+    bool parseSequenceParameterSet(const uint8_t* nal, size_t size, SequenceParameterSet& sps);
+
+    /*!
+     *  Parse a PPS NAL unit, as parseSequenceParameterSet.
+     */
+    bool parsePictureParameterSet(const uint8_t* nal, size_t size, PictureParameterSet& pps);
+
+}
+}
+#endif /* defined(__videocore__ParameterSets__) */
@@ -0,0 +1,224 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/image/ChannelMatrix.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#include <vector>
+
+static const int kCoefficientShift = 12;
+
+namespace videocore { namespace image {
+
+    ChannelMatrix
+    ChannelMatrix::identity()
+    {
+        ChannelMatrix r;
+        for ( int i = 0 ; i < 4 ; ++i ) {
+            for ( int j = 0 ; j < 5 ; ++j ) {
+                r.m[i][j] = (i == j) ? 1.f : 0.f;
+            }
+        }
+        return r;
+    }
+
+    ChannelMatrix
+    ChannelMatrix::operator*(const ChannelMatrix& rhs) const
+    {
+        ChannelMatrix r;
+        for ( int i = 0 ; i < 4 ; ++i ) {
+            for ( int j = 0 ; j < 5 ; ++j ) {
+                float v = (j == 4) ? m[i][4] : 0.f;
+                for ( int k = 0 ; k < 4 ; ++k ) {
+                    v += m[i][k] * rhs.m[k][j];
+                }
+                r.m[i][j] = v;
+            }
+        }
+        return r;
+    }
+
+    bool
+    ChannelMatrix::isIdentity() const
+    {
+        for ( int i = 0 ; i < 4 ; ++i ) {
+            for ( int j = 0 ; j < 5 ; ++j ) {
+                if(fabsf(m[i][j] - ((i == j) ? 1.f : 0.f)) > 1e-6f) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool
+    ChannelMatrix::isBounded() const
+    {
+        static const float kTolerance = 1.f / 512.f;
+
+        for ( int i = 0 ; i < 4 ; ++i ) {
+            float lo = m[i][4], hi = m[i][4];
+            for ( int k = 0 ; k < 4 ; ++k ) {
+                lo += std::min(0.f, m[i][k]);
+                hi += std::max(0.f, m[i][k]);
+            }
+            if(lo < -kTolerance || hi > 1.f + kTolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    namespace {
+        // A matrix in memory channel order with 12-bit fixed point coefficients; offsets include the rounding term.
+        struct Quantized {
+            int16_t w[4][4];
+            int32_t offset[4];
+#if VC_SIMD_SSE2
+            __m128i wv[4];
+            __m128i ov[4];
+#endif
+        };
+
+        void
+        quantize(const ChannelMatrix& matrix, bool isRGBA, Quantized& q)
+        {
+            const int order[4] = { isRGBA ? 0 : 2, 1, isRGBA ? 2 : 0, 3 };   // memory position -> RGBA index
+            for ( int out = 0 ; out < 4 ; ++out ) {
+                const float* row = matrix.m[order[out]];
+                for ( int in = 0 ; in < 4 ; ++in ) {
+                    q.w[out][in] = int16_t(lroundf(row[order[in]] * (1 << kCoefficientShift)));
+                }
+                q.offset[out] = int32_t(lroundf(row[4] * 255.f * (1 << kCoefficientShift))) + (1 << (kCoefficientShift - 1));
+            }
+#if VC_SIMD_SSE2
+            for ( int c = 0 ; c < 4 ; ++c ) {
+                q.wv[c] = _mm_setr_epi16(q.w[c][0], q.w[c][1], q.w[c][2], q.w[c][3], q.w[c][0], q.w[c][1], q.w[c][2], q.w[c][3]);
+                q.ov[c] = _mm_set1_epi32(q.offset[c]);
+            }
+#endif
+        }
+
+        // One matrix over count pixels of a row.  src may equal dst.
+        void
+        transformRow(const uint8_t* src, uint8_t* dst, int count, const Quantized& q)
+        {
+            int x = 0;
+#if VC_SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i w0 = q.wv[0], w1 = q.wv[1], w2 = q.wv[2], w3 = q.wv[3];
+            const __m128i o0 = q.ov[0], o1 = q.ov[1], o2 = q.ov[2], o3 = q.ov[3];
+
+            // madd leaves two partial sums per pixel; fold them into one value per pixel.
+            auto channel = [](__m128i lo, __m128i hi, __m128i w, __m128i o) {
+                const __m128 fa = _mm_castsi128_ps(_mm_madd_epi16(lo, w)), fb = _mm_castsi128_ps(_mm_madd_epi16(hi, w));
+                const __m128i sum = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0))),
+                                                  _mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1))));
+                return _mm_srai_epi32(_mm_add_epi32(sum, o), kCoefficientShift);
+            };
+            for ( ; x + 4 <= count ; x += 4 ) {
+                const __m128i p = _mm_loadu_si128((const __m128i*)(src + x * 4));
+                const __m128i lo = _mm_unpacklo_epi8(p, zero), hi = _mm_unpackhi_epi8(p, zero);
+
+                // [c0 x4, c1 x4, c2 x4, c3 x4] -> interleaved pixels.
+                const __m128i planar = _mm_packus_epi16(_mm_packs_epi32(channel(lo, hi, w0, o0), channel(lo, hi, w1, o1)),
+                                                        _mm_packs_epi32(channel(lo, hi, w2, o2), channel(lo, hi, w3, o3)));
+                const __m128i t = _mm_unpacklo_epi8(planar, _mm_srli_si128(planar, 8));
+                _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_unpacklo_epi8(t, _mm_srli_si128(t, 8)));
+            }
+#elif VC_SIMD_NEON
+            for ( ; x + 8 <= count ; x += 8 ) {
+                const uint8x8x4_t p = vld4_u8(src + x * 4);
+                int16x8_t in[4];
+                for ( int c = 0 ; c < 4 ; ++c ) {
+                    in[c] = vreinterpretq_s16_u16(vmovl_u8(p.val[c]));
+                }
+                uint8x8x4_t o;
+                for ( int c = 0 ; c < 4 ; ++c ) {
+                    int32x4_t lo = vdupq_n_s32(q.offset[c]), hi = lo;
+                    for ( int k = 0 ; k < 4 ; ++k ) {
+                        lo = vmlal_n_s16(lo, vget_low_s16(in[k]), q.w[c][k]);
+                        hi = vmlal_n_s16(hi, vget_high_s16(in[k]), q.w[c][k]);
+                    }
+                    o.val[c] = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, kCoefficientShift), vqshrn_n_s32(hi, kCoefficientShift)));
+                }
+                vst4_u8(dst + x * 4, o);
+            }
+#endif
+            for ( ; x < count ; ++x ) {
+                const uint8_t* ps = src + x * 4;
+                int v[4];
+                for ( int c = 0 ; c < 4 ; ++c ) {
+                    v[c] = (q.w[c][0] * ps[0] + q.w[c][1] * ps[1] + q.w[c][2] * ps[2] + q.w[c][3] * ps[3] + q.offset[c]) >> kCoefficientShift;
+                }
+                uint8_t* pd = dst + x * 4;
+                for ( int c = 0 ; c < 4 ; ++c ) {
+                    pd[c] = uint8_t(std::min(255, std::max(0, v[c])));
+                }
+            }
+        }
+    }
+
+    void
+    applyChannelMatrix(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                       int width, int rowBegin, int rowEnd, const ChannelMatrix& matrix, bool isRGBA)
+    {
+        applyChannelMatrices(src, srcStride, dst, dstStride, width, rowBegin, rowEnd, &matrix, 1, isRGBA);
+    }
+
+    void
+    applyChannelMatrices(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                         int width, int rowBegin, int rowEnd, const ChannelMatrix* matrices, size_t count, bool isRGBA)
+    {
+        if(count == 0) {
+            for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+                memmove(dst + y * dstStride, src + y * srcStride, width * 4);
+            }
+            return;
+        }
+        // Later matrices run in place over a tile of the row that is still in L1.
+        static const int kTilePixels = 256;
+
+        std::vector<Quantized> q(count);
+        for ( size_t i = 0 ; i < count ; ++i ) {
+            quantize(matrices[i], isRGBA, q[i]);
+        }
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            const uint8_t* s = src + y * srcStride;
+            uint8_t* d = dst + y * dstStride;
+            for ( int x = 0 ; x < width ; x += kTilePixels ) {
+                const int n = std::min(kTilePixels, width - x);
+                transformRow(s + x * 4, d + x * 4, n, q[0]);
+                for ( size_t i = 1 ; i < count ; ++i ) {
+                    transformRow(d + x * 4, d + x * 4, n, q[i]);
+                }
+            }
+        }
+    }
+}
+}
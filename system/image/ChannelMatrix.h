@@ -0,0 +1,75 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__ChannelMatrix__
+#define __videocore__ChannelMatrix__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace image {
+
+    /*!
+     *  An affine transform of RGBA colour, as used by per-pixel colour filters (grayscale, sepia, invert, ...).
+     *
+     *  Rows are the output channels R, G, B, A and columns the input channels R, G, B, A followed by a constant
+     *  term.  Values are normalized: 1.0 is full intensity.
+     */
+    struct ChannelMatrix {
+        float m[4][5];
+
+        /*! The identity transform. */
+        static ChannelMatrix identity();
+
+        /*! The transform that applies rhs first, then this. */
+        ChannelMatrix operator*(const ChannelMatrix& rhs) const;
+
+        bool isIdentity() const;
+
+        /*!
+         *  true if every output channel stays within [0, 1] for inputs within [0, 1].  Applying such a matrix never
+         *  clamps, so it can be multiplied with the next one without changing the result.
+         */
+        bool isBounded() const;
+    };
+
+    /*!
+     *  Apply a ChannelMatrix to rows [rowBegin, rowEnd) of a 32-bit image.  src and dst may be the same image.
+     *  Coefficients are rounded to 12 fractional bits and must lie in (-8, 8).
+     *
+     *  \param isRGBA  true if the pixels are RGBA rather than BGRA.
+     */
+    void applyChannelMatrix(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                            int width, int rowBegin, int rowEnd, const ChannelMatrix& matrix, bool isRGBA);
+
+    /*!
+     *  Apply count matrices in order in a single pass, saturating to 8 bits after each one as separate passes
+     *  would.  A count of 0 copies.
+     */
+    void applyChannelMatrices(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                              int width, int rowBegin, int rowEnd, const ChannelMatrix* matrices, size_t count, bool isRGBA);
+}
+}
+#endif /* defined(__videocore__ChannelMatrix__) */
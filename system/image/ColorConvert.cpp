@@ -0,0 +1,579 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/image/ColorConvert.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Fixed-point precision of the RGB->YUV and YUV->RGB coefficients.  The inverse needs more headroom
+// because its chroma gains exceed 2.0 in limited range.
+static const int kForwardShift = 14;
+static const int kInverseShift = 13;
+
+namespace videocore { namespace image {
+
+    namespace {
+
+        // RGB->YUV coefficients in source channel order (B, G, R, A for BGRA input).
+        struct ForwardCoeffs {
+            int16_t y[4];
+            int16_t u[4];
+            int16_t v[4];
+            int     yOffset;
+        };
+
+        // YUV->RGB coefficients.  G subtracts gu and gv.
+        struct InverseCoeffs {
+            int16_t ys, rv, gu, gv, bu;
+            int     yOffset;
+        };
+
+        void
+        lumaWeights(ColorMatrix matrix, double& kr, double& kb)
+        {
+            if(matrix == kColorMatrixBT709) {
+                kr = 0.2126; kb = 0.0722;
+            } else {
+                kr = 0.299;  kb = 0.114;
+            }
+        }
+
+        ForwardCoeffs
+        forwardCoeffs(ColorMatrix matrix, ColorRange range, bool rgba)
+        {
+            double kr, kb;
+            lumaWeights(matrix, kr, kb);
+            const double ys = (range == kColorRangeLimited ? 219. / 255. : 1.);
+            const double cs = (range == kColorRangeLimited ? 224. / 255. : 1.);
+            const double one = 1 << kForwardShift;
+
+            // Round R and B, then derive G so that greys map exactly (Y sums to ys, U and V sum to zero).
+            const int yr = int(lround(kr * ys * one)), yb = int(lround(kb * ys * one));
+            const int yg = int(lround(ys * one)) - yr - yb;
+            const int ur = int(lround(-kr / (2. * (1. - kb)) * cs * one)), ub = int(lround(0.5 * cs * one));
+            const int ug = -ur - ub;
+            const int vr = int(lround(0.5 * cs * one)), vb = int(lround(-kb / (2. * (1. - kr)) * cs * one));
+            const int vg = -vr - vb;
+
+            const int r = rgba ? 0 : 2, b = rgba ? 2 : 0;
+            ForwardCoeffs c;
+            c.y[r] = yr; c.y[1] = yg; c.y[b] = yb; c.y[3] = 0;
+            c.u[r] = ur; c.u[1] = ug; c.u[b] = ub; c.u[3] = 0;
+            c.v[r] = vr; c.v[1] = vg; c.v[b] = vb; c.v[3] = 0;
+            c.yOffset = (range == kColorRangeLimited ? 16 : 0);
+            return c;
+        }
+
+        InverseCoeffs
+        inverseCoeffs(ColorMatrix matrix, ColorRange range)
+        {
+            double kr, kb;
+            lumaWeights(matrix, kr, kb);
+            const double kg = 1. - kr - kb;
+            const double ys = (range == kColorRangeLimited ? 255. / 219. : 1.);
+            const double cs = (range == kColorRangeLimited ? 255. / 224. : 1.);
+            const double one = 1 << kInverseShift;
+
+            InverseCoeffs c;
+            c.ys = int16_t(lround(ys * one));
+            c.rv = int16_t(lround(2. * (1. - kr) * cs * one));
+            c.gu = int16_t(lround(2. * kb * (1. - kb) / kg * cs * one));
+            c.gv = int16_t(lround(2. * kr * (1. - kr) / kg * cs * one));
+            c.bu = int16_t(lround(2. * (1. - kb) * cs * one));
+            c.yOffset = (range == kColorRangeLimited ? 16 : 0);
+            return c;
+        }
+
+        inline uint8_t
+        clamp8(int x)
+        {
+            return uint8_t(std::min(255, std::max(0, x)));
+        }
+
+        // Converts columns [x, width) of a row pair.  y1 is null when the second row is not written.
+        void
+        rgbRowPairScalar(const uint8_t* s0, const uint8_t* s1, int x, int width,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int chromaStep, const ForwardCoeffs& c)
+        {
+            const int yRound = (c.yOffset << kForwardShift) + (1 << (kForwardShift - 1));
+            const int cRound = (128 << (kForwardShift + 2)) + (1 << (kForwardShift + 1));
+
+            for ( ; x < width ; x += 2 ) {
+                const int x1 = std::min(x + 1, width - 1);
+                const uint8_t* p[4] = { s0 + x * 4, s0 + x1 * 4, s1 + x * 4, s1 + x1 * 4 };
+
+                y0[x] = clamp8((c.y[0] * p[0][0] + c.y[1] * p[0][1] + c.y[2] * p[0][2] + yRound) >> kForwardShift);
+                if(x1 != x) {
+                    y0[x1] = clamp8((c.y[0] * p[1][0] + c.y[1] * p[1][1] + c.y[2] * p[1][2] + yRound) >> kForwardShift);
+                }
+                if(y1) {
+                    y1[x] = clamp8((c.y[0] * p[2][0] + c.y[1] * p[2][1] + c.y[2] * p[2][2] + yRound) >> kForwardShift);
+                    if(x1 != x) {
+                        y1[x1] = clamp8((c.y[0] * p[3][0] + c.y[1] * p[3][1] + c.y[2] * p[3][2] + yRound) >> kForwardShift);
+                    }
+                }
+                int sum[3] = { 0, 0, 0 };
+                for ( int i = 0 ; i < 4 ; ++i ) {
+                    sum[0] += p[i][0]; sum[1] += p[i][1]; sum[2] += p[i][2];
+                }
+                const int ci = (x >> 1) * chromaStep;
+                u[ci] = clamp8((c.u[0] * sum[0] + c.u[1] * sum[1] + c.u[2] * sum[2] + cRound) >> (kForwardShift + 2));
+                v[ci] = clamp8((c.v[0] * sum[0] + c.v[1] * sum[1] + c.v[2] * sum[2] + cRound) >> (kForwardShift + 2));
+            }
+        }
+
+        void
+        yuvRowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, int chromaStep, int x, int width,
+                     uint8_t* dst, bool rgba, const InverseCoeffs& c)
+        {
+            const int round = 1 << (kInverseShift - 1);
+            const int r = rgba ? 0 : 2, b = rgba ? 2 : 0;
+
+            for ( ; x < width ; ++x ) {
+                const int ci = (x >> 1) * chromaStep;
+                const int yy = (y[x] - c.yOffset) * c.ys + round;
+                const int uu = u[ci] - 128, vv = v[ci] - 128;
+                uint8_t* p = dst + x * 4;
+                p[r] = clamp8((yy + c.rv * vv) >> kInverseShift);
+                p[1] = clamp8((yy - c.gu * uu - c.gv * vv) >> kInverseShift);
+                p[b] = clamp8((yy + c.bu * uu) >> kInverseShift);
+                p[3] = 0xFF;
+            }
+        }
+
+#if VC_SIMD_SSE2
+        inline __m128i
+        hadd32(__m128i a, __m128i b)
+        {
+#if VC_SIMD_SSSE3
+            return _mm_hadd_epi32(a, b);
+#else
+            const __m128 fa = _mm_castsi128_ps(a), fb = _mm_castsi128_ps(b);
+            return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0))),
+                                 _mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1))));
+#endif
+        }
+
+        // Dot product of each of the 4 pixels in p with the channel weights: 4 x int32.
+        inline __m128i
+        dot4(__m128i p, __m128i weights)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            return hadd32(_mm_madd_epi16(_mm_unpacklo_epi8(p, zero), weights),
+                          _mm_madd_epi16(_mm_unpackhi_epi8(p, zero), weights));
+        }
+
+        inline __m128i
+        luma4(const uint8_t* p, __m128i weights, __m128i offset)
+        {
+            return _mm_srai_epi32(_mm_add_epi32(dot4(_mm_loadu_si128((const __m128i*)p), weights), offset), kForwardShift);
+        }
+
+        // Sums horizontally adjacent pixels of 4 pixels: [p0 + p1, p2 + p3] as 8 x int16.
+        inline __m128i
+        pairSums(__m128i p)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lo = _mm_unpacklo_epi8(p, zero), hi = _mm_unpackhi_epi8(p, zero);
+            return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+        }
+#endif
+#if VC_SIMD_AVX2
+        inline __m256i
+        dot8(__m256i p, __m256i weights)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            return _mm256_hadd_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(p, zero), weights),
+                                     _mm256_madd_epi16(_mm256_unpackhi_epi8(p, zero), weights));
+        }
+
+        inline __m256i
+        pairSums8(__m256i p)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i lo = _mm256_unpacklo_epi8(p, zero), hi = _mm256_unpackhi_epi8(p, zero);
+            return _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+        }
+
+        // Chroma of 16 columns, from the vertically averaged rows a (pixels 0-7) and b (pixels 8-15): 8 x int16.
+        inline __m128i
+        chroma8(__m256i a, __m256i b, __m256i weights, __m256i offset)
+        {
+            __m256i c = _mm256_hadd_epi32(_mm256_madd_epi16(pairSums8(a), weights), _mm256_madd_epi16(pairSums8(b), weights));
+            c = _mm256_permutevar8x32_epi32(c, _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+            c = _mm256_srai_epi32(_mm256_add_epi32(c, offset), kForwardShift + 1);
+            return _mm_packs_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+        }
+
+        inline __m128i
+        luma16(const uint8_t* p, __m256i weights, __m256i offset)
+        {
+            const __m256i a = _mm256_srai_epi32(_mm256_add_epi32(dot8(_mm256_loadu_si256((const __m256i*)p), weights), offset), kForwardShift);
+            const __m256i b = _mm256_srai_epi32(_mm256_add_epi32(dot8(_mm256_loadu_si256((const __m256i*)(p + 32)), weights), offset), kForwardShift);
+            const __m256i w = _mm256_packs_epi32(a, b);   // [0-3, 8-11 | 4-7, 12-15]
+            const __m128i y = _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+            return _mm_shuffle_epi32(y, _MM_SHUFFLE(3, 1, 2, 0));
+        }
+#endif
+
+        // Converts the SIMD-friendly prefix of a row pair and returns the first column left for the scalar tail.
+        int
+        rgbRowPairSIMD(const uint8_t* s0, const uint8_t* s1, int width,
+                       uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, bool interleaved, const ForwardCoeffs& c)
+        {
+            int x = 0;
+#if VC_SIMD_AVX2
+            const __m256i yw = _mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)c.y));
+            const __m256i uw = _mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)c.u));
+            const __m256i vw = _mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)c.v));
+            const __m256i yo = _mm256_set1_epi32((c.yOffset << kForwardShift) + (1 << (kForwardShift - 1)));
+            const __m256i co = _mm256_set1_epi32((128 << (kForwardShift + 1)) + (1 << kForwardShift));
+
+            for ( ; x + 16 <= width ; x += 16 ) {
+                const uint8_t* p0 = s0 + x * 4;
+                const uint8_t* p1 = s1 + x * 4;
+
+                _mm_storeu_si128((__m128i*)(y0 + x), luma16(p0, yw, yo));
+                if(y1) {
+                    _mm_storeu_si128((__m128i*)(y1 + x), luma16(p1, yw, yo));
+                }
+                const __m256i a = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)p0), _mm256_loadu_si256((const __m256i*)p1));
+                const __m256i b = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(p0 + 32)), _mm256_loadu_si256((const __m256i*)(p1 + 32)));
+                const __m128i uu = chroma8(a, b, uw, co);
+                const __m128i vv = chroma8(a, b, vw, co);
+
+                if(interleaved) {
+                    _mm_storeu_si128((__m128i*)(u + x), _mm_packus_epi16(_mm_unpacklo_epi16(uu, vv), _mm_unpackhi_epi16(uu, vv)));
+                } else {
+                    _mm_storel_epi64((__m128i*)(u + x / 2), _mm_packus_epi16(uu, uu));
+                    _mm_storel_epi64((__m128i*)(v + x / 2), _mm_packus_epi16(vv, vv));
+                }
+            }
+#elif VC_SIMD_SSE2
+            const __m128i yw = _mm_loadl_epi64((const __m128i*)c.y);
+            const __m128i uw = _mm_loadl_epi64((const __m128i*)c.u);
+            const __m128i vw = _mm_loadl_epi64((const __m128i*)c.v);
+            const __m128i ywq = _mm_unpacklo_epi64(yw, yw), uwq = _mm_unpacklo_epi64(uw, uw), vwq = _mm_unpacklo_epi64(vw, vw);
+            const __m128i yo = _mm_set1_epi32((c.yOffset << kForwardShift) + (1 << (kForwardShift - 1)));
+            const __m128i co = _mm_set1_epi32((128 << (kForwardShift + 1)) + (1 << kForwardShift));
+
+            for ( ; x + 16 <= width ; x += 16 ) {
+                const uint8_t* p0 = s0 + x * 4;
+                const uint8_t* p1 = s1 + x * 4;
+
+                _mm_storeu_si128((__m128i*)(y0 + x), _mm_packus_epi16(_mm_packs_epi32(luma4(p0, ywq, yo), luma4(p0 + 16, ywq, yo)),
+                                                                      _mm_packs_epi32(luma4(p0 + 32, ywq, yo), luma4(p0 + 48, ywq, yo))));
+                if(y1) {
+                    _mm_storeu_si128((__m128i*)(y1 + x), _mm_packus_epi16(_mm_packs_epi32(luma4(p1, ywq, yo), luma4(p1 + 16, ywq, yo)),
+                                                                          _mm_packs_epi32(luma4(p1 + 32, ywq, yo), luma4(p1 + 48, ywq, yo))));
+                }
+                __m128i sums[4];
+                for ( int i = 0 ; i < 4 ; ++i ) {
+                    sums[i] = pairSums(_mm_avg_epu8(_mm_loadu_si128((const __m128i*)(p0 + i * 16)),
+                                                    _mm_loadu_si128((const __m128i*)(p1 + i * 16))));
+                }
+                __m128i uu = _mm_packs_epi32(
+                    _mm_srai_epi32(_mm_add_epi32(hadd32(_mm_madd_epi16(sums[0], uwq), _mm_madd_epi16(sums[1], uwq)), co), kForwardShift + 1),
+                    _mm_srai_epi32(_mm_add_epi32(hadd32(_mm_madd_epi16(sums[2], uwq), _mm_madd_epi16(sums[3], uwq)), co), kForwardShift + 1));
+                __m128i vv = _mm_packs_epi32(
+                    _mm_srai_epi32(_mm_add_epi32(hadd32(_mm_madd_epi16(sums[0], vwq), _mm_madd_epi16(sums[1], vwq)), co), kForwardShift + 1),
+                    _mm_srai_epi32(_mm_add_epi32(hadd32(_mm_madd_epi16(sums[2], vwq), _mm_madd_epi16(sums[3], vwq)), co), kForwardShift + 1));
+
+                if(interleaved) {
+                    _mm_storeu_si128((__m128i*)(u + x), _mm_packus_epi16(_mm_unpacklo_epi16(uu, vv), _mm_unpackhi_epi16(uu, vv)));
+                } else {
+                    _mm_storel_epi64((__m128i*)(u + x / 2), _mm_packus_epi16(uu, uu));
+                    _mm_storel_epi64((__m128i*)(v + x / 2), _mm_packus_epi16(vv, vv));
+                }
+            }
+#elif VC_SIMD_NEON
+            const int32x4_t yo = vdupq_n_s32((c.yOffset << kForwardShift) + (1 << (kForwardShift - 1)));
+            const int32x4_t co = vdupq_n_s32((128 << (kForwardShift + 2)) + (1 << (kForwardShift + 1)));
+
+            auto luma8 = [&](uint8x8_t c0, uint8x8_t c1, uint8x8_t c2) {
+                const int16x8_t a = vreinterpretq_s16_u16(vmovl_u8(c0));
+                const int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(c1));
+                const int16x8_t d = vreinterpretq_s16_u16(vmovl_u8(c2));
+                int32x4_t lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(yo, vget_low_s16(a), c.y[0]), vget_low_s16(b), c.y[1]), vget_low_s16(d), c.y[2]);
+                int32x4_t hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(yo, vget_high_s16(a), c.y[0]), vget_high_s16(b), c.y[1]), vget_high_s16(d), c.y[2]);
+                return vqmovun_s16(vcombine_s16(vshrn_n_s32(lo, kForwardShift), vshrn_n_s32(hi, kForwardShift)));
+            };
+            auto chroma = [&](const int16x8_t* s, const int16_t* w) {
+                int32x4_t lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(co, vget_low_s16(s[0]), w[0]), vget_low_s16(s[1]), w[1]), vget_low_s16(s[2]), w[2]);
+                int32x4_t hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(co, vget_high_s16(s[0]), w[0]), vget_high_s16(s[1]), w[1]), vget_high_s16(s[2]), w[2]);
+                return vqmovun_s16(vcombine_s16(vshrn_n_s32(lo, kForwardShift + 2), vshrn_n_s32(hi, kForwardShift + 2)));
+            };
+
+            for ( ; x + 16 <= width ; x += 16 ) {
+                const uint8x16x4_t p0 = vld4q_u8(s0 + x * 4);
+                const uint8x16x4_t p1 = vld4q_u8(s1 + x * 4);
+
+                vst1q_u8(y0 + x, vcombine_u8(luma8(vget_low_u8(p0.val[0]), vget_low_u8(p0.val[1]), vget_low_u8(p0.val[2])),
+                                             luma8(vget_high_u8(p0.val[0]), vget_high_u8(p0.val[1]), vget_high_u8(p0.val[2]))));
+                if(y1) {
+                    vst1q_u8(y1 + x, vcombine_u8(luma8(vget_low_u8(p1.val[0]), vget_low_u8(p1.val[1]), vget_low_u8(p1.val[2])),
+                                                 luma8(vget_high_u8(p1.val[0]), vget_high_u8(p1.val[1]), vget_high_u8(p1.val[2]))));
+                }
+                int16x8_t sums[3];
+                for ( int i = 0 ; i < 3 ; ++i ) {
+                    sums[i] = vreinterpretq_s16_u16(vaddq_u16(vpaddlq_u8(p0.val[i]), vpaddlq_u8(p1.val[i])));
+                }
+                const uint8x8_t uu = chroma(sums, c.u);
+                const uint8x8_t vv = chroma(sums, c.v);
+
+                if(interleaved) {
+                    uint8x8x2_t uv;
+                    uv.val[0] = uu;
+                    uv.val[1] = vv;
+                    vst2_u8(u + x, uv);
+                } else {
+                    vst1_u8(u + x / 2, uu);
+                    vst1_u8(v + x / 2, vv);
+                }
+            }
+#endif
+            return x;
+        }
+
+        // Converts the SIMD-friendly prefix of a row and returns the first column left for the scalar tail.
+        int
+        yuvRowSIMD(const uint8_t* y, const uint8_t* u, const uint8_t* v, bool interleaved, int width,
+                   uint8_t* dst, bool rgba, const InverseCoeffs& c)
+        {
+            int x = 0;
+#if VC_SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i yOffset = _mm_set1_epi16(c.yOffset);
+            const __m128i k128 = _mm_set1_epi16(128);
+            const __m128i byteMask = _mm_set1_epi16(0xFF);
+            const __m128i alpha = _mm_set1_epi8(char(0xFF));
+            const __m128i round = _mm_set1_epi32(1 << (kInverseShift - 1));
+            const __m128i wr = _mm_setr_epi16(c.ys, c.rv, c.ys, c.rv, c.ys, c.rv, c.ys, c.rv);
+            const __m128i wb = _mm_setr_epi16(c.ys, c.bu, c.ys, c.bu, c.ys, c.bu, c.ys, c.bu);
+            const __m128i wg = _mm_setr_epi16(c.ys, -c.gu, c.ys, -c.gu, c.ys, -c.gu, c.ys, -c.gu);
+            const __m128i wgv = _mm_setr_epi16(-c.gv, 0, -c.gv, 0, -c.gv, 0, -c.gv, 0);
+
+            auto channel = [&](__m128i a, __m128i w) {
+                return _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(a, w), round), kInverseShift);
+            };
+            for ( ; x + 8 <= width ; x += 8 ) {
+                __m128i uu, vv;
+                if(interleaved) {
+                    const __m128i uv = _mm_loadl_epi64((const __m128i*)(u + x));
+                    uu = _mm_and_si128(uv, byteMask);
+                    vv = _mm_srli_epi16(uv, 8);
+                } else {
+                    int32_t u4, v4;
+                    memcpy(&u4, u + x / 2, 4);
+                    memcpy(&v4, v + x / 2, 4);
+                    uu = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero);
+                    vv = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero);
+                }
+                uu = _mm_sub_epi16(_mm_unpacklo_epi16(uu, uu), k128);
+                vv = _mm_sub_epi16(_mm_unpacklo_epi16(vv, vv), k128);
+                const __m128i yy = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + x)), zero), yOffset);
+
+                const __m128i yuLo = _mm_unpacklo_epi16(yy, uu), yuHi = _mm_unpackhi_epi16(yy, uu);
+                const __m128i yvLo = _mm_unpacklo_epi16(yy, vv), yvHi = _mm_unpackhi_epi16(yy, vv);
+                const __m128i v0Lo = _mm_unpacklo_epi16(vv, zero), v0Hi = _mm_unpackhi_epi16(vv, zero);
+
+                const __m128i r = _mm_packs_epi32(channel(yvLo, wr), channel(yvHi, wr));
+                const __m128i b = _mm_packs_epi32(channel(yuLo, wb), channel(yuHi, wb));
+                const __m128i g = _mm_packs_epi32(
+                    _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, wg), _mm_madd_epi16(v0Lo, wgv)), round), kInverseShift),
+                    _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, wg), _mm_madd_epi16(v0Hi, wgv)), round), kInverseShift));
+
+                const __m128i c0 = _mm_packus_epi16(rgba ? r : b, zero);
+                const __m128i c2 = _mm_packus_epi16(rgba ? b : r, zero);
+                const __m128i c01 = _mm_unpacklo_epi8(c0, _mm_packus_epi16(g, zero));
+                const __m128i c23 = _mm_unpacklo_epi8(c2, alpha);
+                _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_unpacklo_epi16(c01, c23));
+                _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_unpackhi_epi16(c01, c23));
+            }
+#elif VC_SIMD_NEON
+            const int16x8_t yOffset = vdupq_n_s16(c.yOffset);
+            const int16x8_t k128 = vdupq_n_s16(128);
+
+            for ( ; x + 8 <= width ; x += 8 ) {
+                uint8x8_t uu, vv;
+                if(interleaved) {
+                    const uint8x8x2_t uv = vuzp_u8(vld1_u8(u + x), vld1_u8(u + x));
+                    uu = vzip_u8(uv.val[0], uv.val[0]).val[0];
+                    vv = vzip_u8(uv.val[1], uv.val[1]).val[0];
+                } else {
+                    uint32_t u4, v4;
+                    memcpy(&u4, u + x / 2, 4);
+                    memcpy(&v4, v + x / 2, 4);
+                    uu = vreinterpret_u8_u32(vdup_n_u32(u4));
+                    vv = vreinterpret_u8_u32(vdup_n_u32(v4));
+                    uu = vzip_u8(uu, uu).val[0];
+                    vv = vzip_u8(vv, vv).val[0];
+                }
+                const int16x8_t yy = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), yOffset);
+                const int16x8_t us = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uu)), k128);
+                const int16x8_t vs = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vv)), k128);
+
+                const int32x4_t yLo = vmull_n_s16(vget_low_s16(yy), c.ys);
+                const int32x4_t yHi = vmull_n_s16(vget_high_s16(yy), c.ys);
+
+                const int32x4_t rLo = vmlal_n_s16(yLo, vget_low_s16(vs), c.rv);
+                const int32x4_t rHi = vmlal_n_s16(yHi, vget_high_s16(vs), c.rv);
+                const int32x4_t bLo = vmlal_n_s16(yLo, vget_low_s16(us), c.bu);
+                const int32x4_t bHi = vmlal_n_s16(yHi, vget_high_s16(us), c.bu);
+                const int32x4_t gLo = vmlsl_n_s16(vmlsl_n_s16(yLo, vget_low_s16(us), c.gu), vget_low_s16(vs), c.gv);
+                const int32x4_t gHi = vmlsl_n_s16(vmlsl_n_s16(yHi, vget_high_s16(us), c.gu), vget_high_s16(vs), c.gv);
+
+                const uint8x8_t r = vqmovun_s16(vcombine_s16(vqrshrn_n_s32(rLo, kInverseShift), vqrshrn_n_s32(rHi, kInverseShift)));
+                const uint8x8_t g = vqmovun_s16(vcombine_s16(vqrshrn_n_s32(gLo, kInverseShift), vqrshrn_n_s32(gHi, kInverseShift)));
+                const uint8x8_t b = vqmovun_s16(vcombine_s16(vqrshrn_n_s32(bLo, kInverseShift), vqrshrn_n_s32(bHi, kInverseShift)));
+
+                uint8x8x4_t px;
+                px.val[0] = rgba ? r : b;
+                px.val[1] = g;
+                px.val[2] = rgba ? b : r;
+                px.val[3] = vdup_n_u8(0xFF);
+                vst4_u8(dst + x * 4, px);
+            }
+#endif
+            return x;
+        }
+
+        void
+        rgbToYUVImpl(const uint8_t* src, size_t srcStride, bool srcIsRGBA, int width, int height, int rowBegin, int rowEnd,
+                     const YUVPlanes& dst, ColorMatrix matrix, ColorRange range, bool simd)
+        {
+            const ForwardCoeffs c = forwardCoeffs(matrix, range, srcIsRGBA);
+            const int chromaStep = dst.interleaved ? 2 : 1;
+            rowEnd = std::min(rowEnd, height);
+
+            for ( int row = rowBegin & ~1 ; row < rowEnd ; row += 2 ) {
+                const bool pair = row + 1 < height;
+                const uint8_t* s0 = src + row * srcStride;
+                const uint8_t* s1 = pair ? s0 + srcStride : s0;
+                uint8_t* y0 = dst.y + row * dst.yStride;
+                uint8_t* y1 = pair ? y0 + dst.yStride : nullptr;
+                uint8_t* u = dst.u + (row / 2) * dst.uStride;
+                uint8_t* v = dst.v + (row / 2) * dst.vStride;
+
+                const int x = simd ? rgbRowPairSIMD(s0, s1, width, y0, y1, u, v, dst.interleaved, c) : 0;
+                rgbRowPairScalar(s0, s1, x, width, y0, y1, u, v, chromaStep, c);
+            }
+        }
+
+        void
+        yuvToRGBImpl(const YUVPlanes& src, int width, int height, int rowBegin, int rowEnd,
+                     uint8_t* dst, size_t dstStride, bool dstIsRGBA, ColorMatrix matrix, ColorRange range, bool simd)
+        {
+            const InverseCoeffs c = inverseCoeffs(matrix, range);
+            const int chromaStep = src.interleaved ? 2 : 1;
+            rowEnd = std::min(rowEnd, height);
+
+            for ( int row = rowBegin ; row < rowEnd ; ++row ) {
+                const uint8_t* y = src.y + row * src.yStride;
+                const uint8_t* u = src.u + (row / 2) * src.uStride;
+                const uint8_t* v = src.v + (row / 2) * src.vStride;
+                uint8_t* out = dst + row * dstStride;
+
+                const int x = simd ? yuvRowSIMD(y, u, v, src.interleaved, width, out, dstIsRGBA, c) : 0;
+                yuvRowScalar(y, u, v, chromaStep, x, width, out, dstIsRGBA, c);
+            }
+        }
+    }
+
+    bool
+    isYUVFormat(PixelBufferFormatType format)
+    {
+        return format == kCVPixelBufferFormat420v || format == kVCPixelBufferFormat420f || format == kVCPixelBufferFormatI420;
+    }
+
+    ColorRange
+    rangeForFormat(PixelBufferFormatType format, ColorRange fallback)
+    {
+        switch(format) {
+            case kCVPixelBufferFormat420v:
+                return kColorRangeLimited;
+            case kVCPixelBufferFormat420f:
+                return kColorRangeFull;
+            default:
+                return fallback;
+        }
+    }
+
+    bool
+    planesForBuffer(const IPixelBuffer& buffer, YUVPlanes& planes)
+    {
+        const auto format = buffer.pixelFormat();
+        if(!isYUVFormat(format)) {
+            return false;
+        }
+        planes.y = (uint8_t*)buffer.baseAddressOfPlane(0);
+        planes.yStride = buffer.bytesPerRowOfPlane(0);
+        planes.u = (uint8_t*)buffer.baseAddressOfPlane(1);
+        planes.uStride = buffer.bytesPerRowOfPlane(1);
+
+        if(format == kVCPixelBufferFormatI420) {
+            planes.v = (uint8_t*)buffer.baseAddressOfPlane(2);
+            planes.vStride = buffer.bytesPerRowOfPlane(2);
+            planes.interleaved = false;
+        } else {
+            planes.v = planes.u + 1;
+            planes.vStride = planes.uStride;
+            planes.interleaved = true;
+        }
+        return true;
+    }
+
+    void
+    rgbToYUV(const uint8_t* src, size_t srcStride, bool srcIsRGBA, int width, int height, int rowBegin, int rowEnd,
+             const YUVPlanes& dst, ColorMatrix matrix, ColorRange range)
+    {
+        rgbToYUVImpl(src, srcStride, srcIsRGBA, width, height, rowBegin, rowEnd, dst, matrix, range, true);
+    }
+
+    void
+    rgbToYUVScalar(const uint8_t* src, size_t srcStride, bool srcIsRGBA, int width, int height, int rowBegin, int rowEnd,
+                   const YUVPlanes& dst, ColorMatrix matrix, ColorRange range)
+    {
+        rgbToYUVImpl(src, srcStride, srcIsRGBA, width, height, rowBegin, rowEnd, dst, matrix, range, false);
+    }
+
+    void
+    yuvToRGB(const YUVPlanes& src, int width, int height, int rowBegin, int rowEnd,
+             uint8_t* dst, size_t dstStride, bool dstIsRGBA, ColorMatrix matrix, ColorRange range)
+    {
+        yuvToRGBImpl(src, width, height, rowBegin, rowEnd, dst, dstStride, dstIsRGBA, matrix, range, true);
+    }
+
+    void
+    yuvToRGBScalar(const YUVPlanes& src, int width, int height, int rowBegin, int rowEnd,
+                   uint8_t* dst, size_t dstStride, bool dstIsRGBA, ColorMatrix matrix, ColorRange range)
+    {
+        yuvToRGBImpl(src, width, height, rowBegin, rowEnd, dst, dstStride, dstIsRGBA, matrix, range, false);
+    }
+}
+}
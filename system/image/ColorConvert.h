@@ -0,0 +1,102 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__ColorConvert__
+#define __videocore__ColorConvert__
+
+#include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace image {
+
+    typedef enum {
+        kColorMatrixBT601,      /*!< SD video (ITU-R BT.601) */
+        kColorMatrixBT709       /*!< HD video (ITU-R BT.709) */
+    } ColorMatrix;
+
+    typedef enum {
+        kColorRangeLimited,     /*!< Y in [16, 235], Cb/Cr in [16, 240] ("video" range) */
+        kColorRangeFull         /*!< Y, Cb and Cr in [0, 255] */
+    } ColorRange;
+
+    /*!
+     *  The planes of a 4:2:0 image.  For NV12 the chroma is interleaved: u points at the CbCr plane,
+     *  v at u + 1 and both strides are the CbCr plane stride.
+     */
+    struct YUVPlanes {
+        uint8_t* y;
+        size_t   yStride;
+        uint8_t* u;
+        size_t   uStride;
+        uint8_t* v;
+        size_t   vStride;
+        bool     interleaved;
+    };
+
+    /*! true if the format is a 4:2:0 layout understood by the conversions. */
+    bool isYUVFormat(PixelBufferFormatType format);
+
+    /*!
+     *  The range implied by a format: '420v' is limited range, '420f' is full range.  Other formats do not
+     *  carry a range, so the fallback is returned.
+     */
+    ColorRange rangeForFormat(PixelBufferFormatType format, ColorRange fallback);
+
+    /*!
+     *  Describe the planes of a 4:2:0 pixel buffer.
+     *
+     *  \return false if the buffer is not in a 4:2:0 format.
+     */
+    bool planesForBuffer(const IPixelBuffer& buffer, YUVPlanes& planes);
+
+    /*!
+     *  Convert 32-bit BGRA or RGBA to 4:2:0.  Each chroma sample is the average of a 2x2 block.
+     *
+     *  \param src, srcStride, srcIsRGBA  The source pixels.
+     *  \param width, height              The image dimensions.  Odd sizes repeat the last row/column for chroma.
+     *  \param rowBegin, rowEnd           The rows to convert.  rowBegin must be even so stripes own whole chroma rows.
+     *  \param dst                        The destination planes.
+     */
+    void rgbToYUV(const uint8_t* src, size_t srcStride, bool srcIsRGBA, int width, int height, int rowBegin, int rowEnd,
+                  const YUVPlanes& dst, ColorMatrix matrix, ColorRange range);
+
+    /*!
+     *  Convert 4:2:0 to 32-bit BGRA or RGBA with opaque alpha.  Chroma is upsampled by replication.
+     *
+     *  \param rowBegin, rowEnd  The rows to convert.
+     */
+    void yuvToRGB(const YUVPlanes& src, int width, int height, int rowBegin, int rowEnd,
+                  uint8_t* dst, size_t dstStride, bool dstIsRGBA, ColorMatrix matrix, ColorRange range);
+
+    /*! Scalar reference implementations of the conversions above; same arguments and fixed-point rounding. */
+    void rgbToYUVScalar(const uint8_t* src, size_t srcStride, bool srcIsRGBA, int width, int height, int rowBegin, int rowEnd,
+                        const YUVPlanes& dst, ColorMatrix matrix, ColorRange range);
+    void yuvToRGBScalar(const YUVPlanes& src, int width, int height, int rowBegin, int rowEnd,
+                        uint8_t* dst, size_t dstStride, bool dstIsRGBA, ColorMatrix matrix, ColorRange range);
+}
+}
+#endif /* defined(__videocore__ColorConvert__) */
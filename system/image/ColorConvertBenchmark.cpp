@@ -0,0 +1,104 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Throughput of the SIMD color conversions in ColorConvert.cpp against the scalar reference, for one 1080p
+ *  frame in each direction.  ColorConvertTests.cpp checks that the two paths agree.
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/image/ColorConvert.cpp.
+ */
+
+#include <videocore/system/image/ColorConvert.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using namespace videocore;
+using namespace videocore::image;
+
+namespace {
+
+    const int kWidth = 1920;
+    const int kHeight = 1080;
+    const int kIterations = 50;
+
+    double
+    timeIt(const std::function<void()>& f)
+    {
+        f();
+        const auto start = std::chrono::steady_clock::now();
+        for ( int i = 0 ; i < kIterations ; ++i ) {
+            f();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kIterations;
+    }
+
+    void
+    compare(const char* name, const std::function<void()>& scalar, const std::function<void()>& simd)
+    {
+        const double s = timeIt(scalar);
+        const double v = timeIt(simd);
+        printf("%-14s scalar %6.2f ms  simd %6.2f ms  speedup %.1fx\n", name, s, v, s / v);
+    }
+}
+
+int
+main()
+{
+    std::vector<uint8_t> rgb(size_t(kWidth) * kHeight * 4);
+    for ( size_t i = 0 ; i < rgb.size() ; ++i ) {
+        rgb[i] = uint8_t(i * 7 + (i >> 12));
+    }
+    std::vector<uint8_t> yuv(size_t(kWidth) * kHeight * 3 / 2);
+
+    for ( int interleaved = 0 ; interleaved < 2 ; ++interleaved ) {
+        YUVPlanes planes;
+        planes.y = &yuv[0];
+        planes.yStride = kWidth;
+        planes.u = planes.y + size_t(kWidth) * kHeight;
+        planes.interleaved = interleaved;
+        planes.uStride = planes.vStride = interleaved ? kWidth : kWidth / 2;
+        planes.v = interleaved ? planes.u + 1 : planes.u + size_t(kWidth / 2) * (kHeight / 2);
+
+        const char* layout = interleaved ? "NV12" : "I420";
+        char name[32];
+
+        snprintf(name, sizeof(name), "BGRA -> %s", layout);
+        compare(name,
+                [&]() { rgbToYUVScalar(&rgb[0], kWidth * 4, false, kWidth, kHeight, 0, kHeight, planes, kColorMatrixBT709, kColorRangeLimited); },
+                [&]() { rgbToYUV(&rgb[0], kWidth * 4, false, kWidth, kHeight, 0, kHeight, planes, kColorMatrixBT709, kColorRangeLimited); });
+
+        snprintf(name, sizeof(name), "%s -> BGRA", layout);
+        compare(name,
+                [&]() { yuvToRGBScalar(planes, kWidth, kHeight, 0, kHeight, &rgb[0], kWidth * 4, false, kColorMatrixBT709, kColorRangeLimited); },
+                [&]() { yuvToRGB(planes, kWidth, kHeight, 0, kHeight, &rgb[0], kWidth * 4, false, kColorMatrixBT709, kColorRangeLimited); });
+    }
+    return 0;
+}
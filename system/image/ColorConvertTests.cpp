@@ -0,0 +1,237 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  Accuracy checks for the color conversions in ColorConvert.cpp.
+ *
+ *  For every matrix, range, chroma layout and source order, on a 1080p image and an odd-sized one:
+ *   - the SIMD paths must match the scalar reference to within 1 code value, and
+ *   - the output must be close to a double-precision reference of the same transform (PSNR).
+ *
+ *  Not part of the library, and excluded from the pod.  Build it as a command line tool with a directory that
+ *  contains a `videocore` link to the repository root on the include path, together with
+ *  system/image/ColorConvert.cpp.  Exits with a non-zero status on failure.
+ */
+
+#include <videocore/system/image/ColorConvert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace videocore;
+using namespace videocore::image;
+
+namespace {
+
+    // Lowest acceptable PSNR, in dB, against the double-precision reference.
+    const double kMinLumaPSNR = 48.;
+    const double kMinChromaPSNR = 40.;
+    const double kMinInversePSNR = 45.;
+
+    // Largest acceptable difference between the SIMD and scalar paths.
+    const int kMaxSimdDifference = 1;
+
+    double
+    psnr(const std::vector<double>& reference, const std::vector<uint8_t>& actual)
+    {
+        double sum = 0.;
+        for ( size_t i = 0 ; i < reference.size() ; ++i ) {
+            const double d = reference[i] - actual[i];
+            sum += d * d;
+        }
+        const double mse = std::max(sum / reference.size(), 1e-10);
+        return 10. * log10(255. * 255. / mse);
+    }
+
+    double
+    clamp255(double v)
+    {
+        return std::min(255., std::max(0., v));
+    }
+
+    int
+    maxDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+    {
+        int d = 0;
+        for ( size_t i = 0 ; i < a.size() ; ++i ) {
+            d = std::max(d, std::abs(int(a[i]) - int(b[i])));
+        }
+        return d;
+    }
+
+    /*
+     *  Points `planes` at a contiguous 4:2:0 image in `storage`.
+     */
+    void
+    makePlanes(std::vector<uint8_t>& storage, int width, int height, bool interleaved, YUVPlanes& planes)
+    {
+        const size_t chromaWidth = (width + 1) / 2;
+        const size_t chromaHeight = (height + 1) / 2;
+        storage.assign(size_t(width) * height + 2 * chromaWidth * chromaHeight, 0);
+
+        planes.y = &storage[0];
+        planes.yStride = width;
+        planes.u = planes.y + size_t(width) * height;
+        planes.interleaved = interleaved;
+        if(interleaved) {
+            planes.uStride = planes.vStride = chromaWidth * 2;
+            planes.v = planes.u + 1;
+        } else {
+            planes.uStride = planes.vStride = chromaWidth;
+            planes.v = planes.u + chromaWidth * chromaHeight;
+        }
+    }
+
+    struct Coefficients {
+        Coefficients(ColorMatrix matrix, ColorRange range) {
+            kr = matrix == kColorMatrixBT709 ? 0.2126 : 0.299;
+            kb = matrix == kColorMatrixBT709 ? 0.0722 : 0.114;
+            kg = 1. - kr - kb;
+            yScale = range == kColorRangeFull ? 1. : 219. / 255.;
+            cScale = range == kColorRangeFull ? 1. : 224. / 255.;
+            yOffset = range == kColorRangeFull ? 0. : 16.;
+        }
+        double kr, kg, kb, yScale, cScale, yOffset;
+    };
+
+    bool
+    check(int width, int height, bool interleaved, ColorMatrix matrix, ColorRange range, bool rgba)
+    {
+        // Gradients, a smooth pattern and noise, one per channel.
+        std::vector<uint8_t> src(size_t(width) * height * 4);
+        srand(1);
+        for ( int y = 0 ; y < height ; ++y ) {
+            for ( int x = 0 ; x < width ; ++x ) {
+                uint8_t* p = &src[(size_t(y) * width + x) * 4];
+                p[0] = uint8_t(x * 3 + y);
+                p[1] = uint8_t(128 + 100 * sin(x * 0.01 + y * 0.02));
+                p[2] = uint8_t(rand());
+                p[3] = 255;
+            }
+        }
+        const size_t stride = size_t(width) * 4;
+        auto R = [&](int x, int y) { const uint8_t* p = &src[y * stride + x * 4]; return double(rgba ? p[0] : p[2]); };
+        auto G = [&](int x, int y) { return double(src[y * stride + x * 4 + 1]); };
+        auto B = [&](int x, int y) { const uint8_t* p = &src[y * stride + x * 4]; return double(rgba ? p[2] : p[0]); };
+
+        std::vector<uint8_t> simdStorage, scalarStorage;
+        YUVPlanes simd, scalar;
+        makePlanes(simdStorage, width, height, interleaved, simd);
+        makePlanes(scalarStorage, width, height, interleaved, scalar);
+
+        rgbToYUV(&src[0], stride, rgba, width, height, 0, height, simd, matrix, range);
+        rgbToYUVScalar(&src[0], stride, rgba, width, height, 0, height, scalar, matrix, range);
+        const int forwardDifference = maxDifference(simdStorage, scalarStorage);
+
+        const Coefficients k(matrix, range);
+        const size_t step = interleaved ? 2 : 1;
+
+        // Forward transform against the double reference; chroma is the 2x2 average.
+        std::vector<double> lumaReference, chromaReference;
+        std::vector<uint8_t> luma, chroma;
+        for ( int y = 0 ; y < height ; ++y ) {
+            for ( int x = 0 ; x < width ; ++x ) {
+                lumaReference.push_back(clamp255(k.yOffset + k.yScale * (k.kr * R(x, y) + k.kg * G(x, y) + k.kb * B(x, y))));
+                luma.push_back(simd.y[y * simd.yStride + x]);
+            }
+        }
+        for ( int y = 0 ; y < (height + 1) / 2 ; ++y ) {
+            for ( int x = 0 ; x < (width + 1) / 2 ; ++x ) {
+                double r = 0., g = 0., b = 0.;
+                for ( int dy = 0 ; dy < 2 ; ++dy ) {
+                    for ( int dx = 0 ; dx < 2 ; ++dx ) {
+                        const int sx = std::min(2 * x + dx, width - 1), sy = std::min(2 * y + dy, height - 1);
+                        r += R(sx, sy) / 4.; g += G(sx, sy) / 4.; b += B(sx, sy) / 4.;
+                    }
+                }
+                const double l = k.kr * r + k.kg * g + k.kb * b;
+                chromaReference.push_back(clamp255(128. + k.cScale * (b - l) / (2. * (1. - k.kb))));
+                chromaReference.push_back(clamp255(128. + k.cScale * (r - l) / (2. * (1. - k.kr))));
+                chroma.push_back(simd.u[y * simd.uStride + x * step]);
+                chroma.push_back(simd.v[y * simd.vStride + x * step]);
+            }
+        }
+
+        // Inverse transform of the SIMD output, against the scalar path and the double reference.
+        std::vector<uint8_t> back(stride * height), backScalar(stride * height);
+        yuvToRGB(simd, width, height, 0, height, &back[0], stride, rgba, matrix, range);
+        yuvToRGBScalar(simd, width, height, 0, height, &backScalar[0], stride, rgba, matrix, range);
+        const int inverseDifference = maxDifference(back, backScalar);
+
+        std::vector<double> rgbReference;
+        std::vector<uint8_t> rgb;
+        for ( int y = 0 ; y < height ; ++y ) {
+            for ( int x = 0 ; x < width ; ++x ) {
+                const double l = (simd.y[y * simd.yStride + x] - k.yOffset) / k.yScale;
+                const double u = (simd.u[(y / 2) * simd.uStride + (x / 2) * step] - 128.) / k.cScale;
+                const double v = (simd.v[(y / 2) * simd.vStride + (x / 2) * step] - 128.) / k.cScale;
+                const double r = l + 2. * (1. - k.kr) * v;
+                const double b = l + 2. * (1. - k.kb) * u;
+                const double g = (l - k.kr * r - k.kb * b) / k.kg;
+                const uint8_t* p = &back[y * stride + x * 4];
+                rgbReference.push_back(clamp255(r)); rgb.push_back(rgba ? p[0] : p[2]);
+                rgbReference.push_back(clamp255(g)); rgb.push_back(p[1]);
+                rgbReference.push_back(clamp255(b)); rgb.push_back(rgba ? p[2] : p[0]);
+            }
+        }
+
+        const double lumaPSNR = psnr(lumaReference, luma);
+        const double chromaPSNR = psnr(chromaReference, chroma);
+        const double inversePSNR = psnr(rgbReference, rgb);
+        const bool ok = forwardDifference <= kMaxSimdDifference && inverseDifference <= kMaxSimdDifference &&
+                        lumaPSNR >= kMinLumaPSNR && chromaPSNR >= kMinChromaPSNR && inversePSNR >= kMinInversePSNR;
+
+        printf("%s %4dx%-4d %s %s %-7s %s  simd-vs-scalar fwd %d inv %d  PSNR Y %.1f C %.1f inv %.1f\n",
+               ok ? "ok  " : "FAIL", width, height, interleaved ? "NV12" : "I420",
+               matrix == kColorMatrixBT709 ? "709" : "601", range == kColorRangeFull ? "full" : "limited",
+               rgba ? "RGBA" : "BGRA", forwardDifference, inverseDifference, lumaPSNR, chromaPSNR, inversePSNR);
+        return ok;
+    }
+}
+
+int
+main()
+{
+    const int sizes[][2] = { { 1920, 1080 }, { 37, 21 } };
+    bool ok = true;
+
+    for ( auto& size : sizes ) {
+        for ( int interleaved = 0 ; interleaved < 2 ; ++interleaved ) {
+            for ( int matrix = 0 ; matrix < 2 ; ++matrix ) {
+                for ( int range = 0 ; range < 2 ; ++range ) {
+                    for ( int rgba = 0 ; rgba < 2 ; ++rgba ) {
+                        ok &= check(size[0], size[1], interleaved, ColorMatrix(matrix), ColorRange(range), rgba);
+                    }
+                }
+            }
+        }
+    }
+    printf(ok ? "all passed\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
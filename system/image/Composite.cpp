@@ -0,0 +1,360 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/image/Composite.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videocore { namespace image {
+
+    void
+    fill32(uint8_t* dst, size_t dstStride, int width, int rowBegin, int rowEnd, uint32_t pixel)
+    {
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            uint32_t* row = (uint32_t*)(dst + y * dstStride);
+            std::fill(row, row + width, pixel);
+        }
+    }
+
+    static inline uint32_t
+    swapRB(uint32_t p)
+    {
+        return (p & 0xFF00FF00) | ((p & 0xFF) << 16) | ((p >> 16) & 0xFF);
+    }
+
+    // Interpolates two pixels, two channels at a time.  w is in [0, 256].
+    static inline uint32_t
+    lerp32(uint32_t a, uint32_t b, uint32_t w)
+    {
+        const uint32_t iw = 256 - w;
+        const uint32_t rb = (((a & 0x00FF00FF) * iw + (b & 0x00FF00FF) * w) >> 8) & 0x00FF00FF;
+        const uint32_t ag = ((((a >> 8) & 0x00FF00FF) * iw + ((b >> 8) & 0x00FF00FF) * w)) & 0xFF00FF00;
+        return rb | ag;
+    }
+
+    // src * a + dst * (1 - a) per channel.  When accumulating, the alpha channel takes 1 as its source value so
+    // that dst alpha becomes the coverage of everything blended into it.
+    template<bool Accumulate>
+    static inline void
+    blendPixel(uint32_t& d, uint32_t s)
+    {
+        const uint32_t a = s >> 24;
+        if(Accumulate) {
+            s |= 0xFF000000;
+        }
+        uint32_t r = 0;
+        for ( int shift = 0 ; shift < 32 ; shift += 8 ) {
+            uint32_t x = ((s >> shift) & 0xFF) * a + ((d >> shift) & 0xFF) * (255 - a) + 128;
+            x = (x + (x >> 8)) >> 8;
+            r |= x << shift;
+        }
+        d = r;
+    }
+
+    template<bool Accumulate>
+    static void
+    blendRowImpl(uint32_t* VC_RESTRICT dst, const uint32_t* VC_RESTRICT src, size_t count)
+    {
+        size_t i = 0;
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i k255 = _mm_set1_epi16(255);
+        const __m128i k128 = _mm_set1_epi16(128);
+        const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+        for ( ; i + 4 <= count ; i += 4 ) {
+            const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            const __m128i alpha = _mm_and_si128(s, alphaMask);
+
+            // Fully opaque or fully transparent groups are common in overlays and need no arithmetic.
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+                _mm_storeu_si128((__m128i*)(dst + i), s);
+                continue;
+            }
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) {
+                continue;
+            }
+            const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            const __m128i v = Accumulate ? _mm_or_si128(s, alphaMask) : s;
+
+            const __m128i sl = _mm_unpacklo_epi8(v, zero);
+            const __m128i sh = _mm_unpackhi_epi8(v, zero);
+            const __m128i dl = _mm_unpacklo_epi8(d, zero);
+            const __m128i dh = _mm_unpackhi_epi8(d, zero);
+            const __m128i al = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpacklo_epi8(s, zero), 0xFF), 0xFF);
+            const __m128i ah = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpackhi_epi8(s, zero), 0xFF), 0xFF);
+
+            __m128i xl = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(sl, al), _mm_mullo_epi16(dl, _mm_sub_epi16(k255, al))), k128);
+            __m128i xh = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(sh, ah), _mm_mullo_epi16(dh, _mm_sub_epi16(k255, ah))), k128);
+            xl = _mm_srli_epi16(_mm_add_epi16(xl, _mm_srli_epi16(xl, 8)), 8);
+            xh = _mm_srli_epi16(_mm_add_epi16(xh, _mm_srli_epi16(xh, 8)), 8);
+
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(xl, xh));
+        }
+#elif VC_SIMD_NEON
+        for ( ; i + 8 <= count ; i += 8 ) {
+            uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+            uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+            const uint8x8_t a = s.val[3];
+            const uint8x8_t ia = vmvn_u8(a);
+            if(Accumulate) {
+                s.val[3] = vdup_n_u8(255);
+            }
+            for ( int c = 0 ; c < 4 ; ++c ) {
+                const uint16x8_t x = vmlal_u8(vmull_u8(s.val[c], a), d.val[c], ia);
+                d.val[c] = vraddhn_u16(x, vrshrq_n_u16(x, 8));
+            }
+            vst4_u8((uint8_t*)(dst + i), d);
+        }
+#endif
+        for ( ; i < count ; ++i ) {
+            blendPixel<Accumulate>(dst[i], src[i]);
+        }
+    }
+
+    void
+    blendRow(uint32_t* VC_RESTRICT dst, const uint32_t* VC_RESTRICT src, size_t count)
+    {
+        blendRowImpl<false>(dst, src, count);
+    }
+
+    void
+    accumulateRow(uint32_t* VC_RESTRICT dst, const uint32_t* VC_RESTRICT src, size_t count)
+    {
+        blendRowImpl<true>(dst, src, count);
+    }
+
+    void
+    blendPremultipliedRow(uint32_t* VC_RESTRICT dst, const uint32_t* VC_RESTRICT src, size_t count)
+    {
+        size_t i = 0;
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i k255 = _mm_set1_epi16(255);
+        const __m128i k128 = _mm_set1_epi16(128);
+        const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+        for ( ; i + 4 <= count ; i += 4 ) {
+            const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            const __m128i alpha = _mm_and_si128(s, alphaMask);
+
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+                _mm_storeu_si128((__m128i*)(dst + i), s);
+                continue;
+            }
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) {
+                continue;
+            }
+            const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            const __m128i ial = _mm_sub_epi16(k255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpacklo_epi8(s, zero), 0xFF), 0xFF));
+            const __m128i iah = _mm_sub_epi16(k255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpackhi_epi8(s, zero), 0xFF), 0xFF));
+
+            __m128i xl = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ial), k128);
+            __m128i xh = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), iah), k128);
+            xl = _mm_srli_epi16(_mm_add_epi16(xl, _mm_srli_epi16(xl, 8)), 8);
+            xh = _mm_srli_epi16(_mm_add_epi16(xh, _mm_srli_epi16(xh, 8)), 8);
+
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(s, _mm_packus_epi16(xl, xh)));
+        }
+#elif VC_SIMD_NEON
+        for ( ; i + 8 <= count ; i += 8 ) {
+            const uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+            uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+            const uint8x8_t ia = vmvn_u8(s.val[3]);
+            for ( int c = 0 ; c < 4 ; ++c ) {
+                const uint16x8_t x = vmull_u8(d.val[c], ia);
+                d.val[c] = vqadd_u8(s.val[c], vraddhn_u16(x, vrshrq_n_u16(x, 8)));
+            }
+            vst4_u8((uint8_t*)(dst + i), d);
+        }
+#endif
+        for ( ; i < count ; ++i ) {
+            const uint32_t s = src[i], d = dst[i];
+            const uint32_t ia = 255 - (s >> 24);
+            uint32_t r = 0;
+            for ( int shift = 0 ; shift < 32 ; shift += 8 ) {
+                uint32_t x = ((d >> shift) & 0xFF) * ia + 128;
+                x = ((s >> shift) & 0xFF) + ((x + (x >> 8)) >> 8);
+                r |= std::min(x, 255u) << shift;
+            }
+            dst[i] = r;
+        }
+    }
+
+    // Vertical interpolation of two rows.  w is in [0, 256].
+    static void
+    lerpRows(uint32_t* VC_RESTRICT dst, const uint32_t* VC_RESTRICT a, const uint32_t* VC_RESTRICT b, size_t count, uint32_t w)
+    {
+        size_t i = 0;
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wb = _mm_set1_epi16(short(w));
+        const __m128i wa = _mm_set1_epi16(short(256 - w));
+        for ( ; i + 4 <= count ; i += 4 ) {
+            const __m128i pa = _mm_loadu_si128((const __m128i*)(a + i));
+            const __m128i pb = _mm_loadu_si128((const __m128i*)(b + i));
+            const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+                                                            _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb)), 8);
+            const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+                                                            _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb)), 8);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+        }
+#elif VC_SIMD_NEON
+        const uint8x8_t wb = vdup_n_u8(uint8_t(w));
+        const uint8x8_t wa = vdup_n_u8(uint8_t(256 - w));
+        for ( ; i + 2 <= count ; i += 2 ) {
+            const uint8x8_t pa = vld1_u8((const uint8_t*)(a + i));
+            const uint8x8_t pb = vld1_u8((const uint8_t*)(b + i));
+            vst1_u8((uint8_t*)(dst + i), vshrn_n_u16(vmlal_u8(vmull_u8(pa, wa), pb, wb), 8));
+        }
+#endif
+        for ( ; i < count ; ++i ) {
+            dst[i] = lerp32(a[i], b[i], w);
+        }
+    }
+
+    // Narrows [xmin, xmax] to the x for which c0 + cx * x lies in [lo, hi).
+    static inline void
+    clipSpan(float c0, float cx, float lo, float hi, float& xmin, float& xmax)
+    {
+        if(fabsf(cx) < 1e-6f) {
+            if(c0 < lo || c0 >= hi) {
+                xmin = 1.f;
+                xmax = 0.f;
+            }
+            return;
+        }
+        float a = (lo - c0) / cx;
+        float b = (hi - c0) / cx;
+        if(a > b) std::swap(a, b);
+        xmin = std::max(xmin, a);
+        xmax = std::min(xmax, b);
+    }
+
+    void
+    drawAffine(uint8_t* dst, size_t dstStride, int dstWidth, int rowBegin, int rowEnd,
+               const uint8_t* src, size_t srcStride, int srcWidth, int srcHeight, bool srcIsRGBA,
+               const AffineMap& map, DrawMode mode, uint32_t* scratch)
+    {
+        // A translation by a whole number of pixels needs no resampling.
+        const bool unitScale = map.ux == 1.f && map.vx == 0.f && map.uy == 0.f && map.vy == 1.f &&
+                               map.u0 == floorf(map.u0) && map.v0 == floorf(map.v0);
+
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            const float u0 = map.u0 + map.uy * y;
+            const float v0 = map.v0 + map.vy * y;
+
+            float xmin = 0.f, xmax = float(dstWidth - 1);
+            clipSpan(u0, map.ux, -0.5f, srcWidth - 0.5f, xmin, xmax);
+            clipSpan(v0, map.vx, -0.5f, srcHeight - 0.5f, xmin, xmax);
+
+            const int xb = std::max(0, int(ceilf(xmin)));
+            const int xe = std::min(dstWidth, int(floorf(xmax)) + 1);
+            if(xe <= xb) {
+                continue;
+            }
+            const size_t count = xe - xb;
+            uint32_t* out = (uint32_t*)(dst + y * dstStride) + xb;
+            const uint32_t* row = nullptr;
+
+            if(unitScale) {
+                const int sy = std::min(srcHeight - 1, std::max(0, int(v0)));
+                const int sx = std::min(srcWidth - 1, std::max(0, int(u0) + xb));
+                row = (const uint32_t*)(src + sy * srcStride) + sx;
+                if(srcIsRGBA) {
+                    for ( size_t i = 0 ; i < count ; ++i ) {
+                        scratch[i] = swapRB(row[i]);
+                    }
+                    row = scratch;
+                }
+            } else if(map.vx == 0.f && map.uy == 0.f) {
+                // Axis aligned: interpolate the two source rows once (SIMD), then gather horizontally.
+                const int32_t v = int32_t(v0 * 65536.f);
+                const uint32_t wy = (v >> 8) & 0xFF;
+                const int y0 = std::min(srcHeight - 1, std::max(0, v >> 16));
+                const int y1 = std::min(srcHeight - 1, std::max(0, (v >> 16) + 1));
+                const uint32_t* r0 = (const uint32_t*)(src + y0 * srcStride);
+                const uint32_t* r1 = (const uint32_t*)(src + y1 * srcStride);
+
+                int32_t u = int32_t((u0 + map.ux * xb) * 65536.f);
+                const int32_t du = int32_t(map.ux * 65536.f);
+                const int32_t uLast = u + du * int32_t(count - 1);
+                const int maxX = srcWidth - 1;
+                const int sx0 = std::min(maxX, std::max(0, std::min(u, uLast) >> 16));
+                const int sx1 = std::min(maxX, std::max(0, (std::max(u, uLast) >> 16) + 1));
+
+                const uint32_t* vrow = r0;
+                if(wy && y0 != y1) {
+                    uint32_t* blended = scratch + dstWidth;
+                    lerpRows(blended + sx0, r0 + sx0, r1 + sx0, sx1 - sx0 + 1, wy);
+                    vrow = blended;
+                }
+                for ( size_t i = 0 ; i < count ; ++i, u += du ) {
+                    const int xi = u >> 16;
+                    const int x0 = std::min(maxX, std::max(0, xi)), x1 = std::min(maxX, std::max(0, xi + 1));
+                    const uint32_t p = lerp32(vrow[x0], vrow[x1], (u >> 8) & 0xFF);
+                    scratch[i] = srcIsRGBA ? swapRB(p) : p;
+                }
+                row = scratch;
+            } else {
+                // General affine: bilinear gather in 16.16 fixed point.
+                int32_t u = int32_t((u0 + map.ux * xb) * 65536.f);
+                int32_t v = int32_t((v0 + map.vx * xb) * 65536.f);
+                const int32_t du = int32_t(map.ux * 65536.f);
+                const int32_t dv = int32_t(map.vx * 65536.f);
+                const int maxX = srcWidth - 1, maxY = srcHeight - 1;
+
+                for ( size_t i = 0 ; i < count ; ++i, u += du, v += dv ) {
+                    const int xi = u >> 16, yi = v >> 16;
+                    const uint32_t wx = (u >> 8) & 0xFF, wy = (v >> 8) & 0xFF;
+                    const int x0 = std::min(maxX, std::max(0, xi)), x1 = std::min(maxX, std::max(0, xi + 1));
+                    const int y0 = std::min(maxY, std::max(0, yi)), y1 = std::min(maxY, std::max(0, yi + 1));
+
+                    const uint32_t* r0 = (const uint32_t*)(src + y0 * srcStride);
+                    const uint32_t* r1 = (const uint32_t*)(src + y1 * srcStride);
+                    const uint32_t p = lerp32(lerp32(r0[x0], r0[x1], wx), lerp32(r1[x0], r1[x1], wx), wy);
+                    scratch[i] = srcIsRGBA ? swapRB(p) : p;
+                }
+                row = scratch;
+            }
+
+            switch(mode) {
+                case kDrawReplace:
+                    memcpy(out, row, count * sizeof(uint32_t));
+                    break;
+                case kDrawBlend:
+                    blendRow(out, row, count);
+                    break;
+                case kDrawAccumulate:
+                    accumulateRow(out, row, count);
+                    break;
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,93 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__Composite__
+#define __videocore__Composite__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace videocore { namespace image {
+
+    /*!
+     *  A 2D affine mapping from destination pixel coordinates to source pixel coordinates:
+     *
+     *      u = u0 + ux * x + uy * y
+     *      v = v0 + vx * x + vy * y
+     *
+     *  Coordinates refer to pixel centers on both sides: (u, v) = (0, 0) is the center of the first source pixel.
+     */
+    struct AffineMap {
+        float u0, ux, uy;
+        float v0, vx, vy;
+    };
+
+    /*! How drawAffine() combines source pixels with the destination. */
+    enum DrawMode {
+        kDrawReplace,       /*!< dst = src */
+        kDrawBlend,         /*!< dst = src * a + dst * (1 - a), see blendRow() */
+        kDrawAccumulate     /*!< dst is premultiplied, see accumulateRow() */
+    };
+
+    /*!
+     *  Fill rows [rowBegin, rowEnd) of a 32-bit image with a single pixel value.
+     */
+    void fill32(uint8_t* dst, size_t dstStride, int width, int rowBegin, int rowEnd, uint32_t pixel);
+
+    /*!
+     *  Draw a 32-bit source image into rows [rowBegin, rowEnd) of a BGRA destination through an affine map,
+     *  with bilinear sampling.  Pixels that map outside the source are left untouched.
+     *
+     *  \param dst, dstStride, dstWidth   The BGRA destination.
+     *  \param rowBegin, rowEnd           The destination rows to draw; lets callers split the work in stripes.
+     *  \param src, srcStride             The source pixels.
+     *  \param srcWidth, srcHeight        The source dimensions.
+     *  \param srcIsRGBA                  true if the source is RGBA rather than BGRA.
+     *  \param map                        Destination to source mapping.
+     *  \param mode                       How source pixels are combined with the destination.
+     *  \param scratch                    Scratch space of at least dstWidth + srcWidth pixels.
+     */
+    void drawAffine(uint8_t* dst, size_t dstStride, int dstWidth, int rowBegin, int rowEnd,
+                    const uint8_t* src, size_t srcStride, int srcWidth, int srcHeight, bool srcIsRGBA,
+                    const AffineMap& map, DrawMode mode, uint32_t* scratch);
+
+    /*!
+     *  Alpha blend a row of BGRA pixels over another (non-premultiplied, src * a + dst * (1 - a)).
+     */
+    void blendRow(uint32_t* dst, const uint32_t* src, size_t count);
+
+    /*!
+     *  Blend a row of straight-alpha BGRA pixels over a premultiplied row, keeping it premultiplied.  Used to
+     *  flatten several overlays into one layer that can later be drawn with blendPremultipliedRow().
+     */
+    void accumulateRow(uint32_t* dst, const uint32_t* src, size_t count);
+
+    /*!
+     *  Draw a row of premultiplied BGRA pixels over an opaque row (src + dst * (1 - a)).
+     */
+    void blendPremultipliedRow(uint32_t* dst, const uint32_t* src, size_t count);
+}
+}
+#endif /* defined(__videocore__Composite__) */
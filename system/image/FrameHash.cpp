@@ -0,0 +1,138 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/image/FrameHash.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace videocore { namespace image {
+
+    // Each step, h = x ^ (x >> 7) with x = (h ^ v) * k, is a bijection of h for a given input because k is odd.  A
+    // single changed chunk therefore always changes the hash, and the non-linear mixing keeps several changes in
+    // the same lane from cancelling out except by chance.
+    static const uint16_t kMultiplier = 0x9E37;
+
+    // Four independent chains hide the multiply latency; each covers every fourth 16-byte chunk of a row.
+    static const int kChains = 4;
+
+#if VC_SIMD_SSE2
+    typedef __m128i Lanes;
+    static inline Lanes splat(uint16_t v) { return _mm_set1_epi16(short(v)); }
+    static inline Lanes load(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static inline Lanes step(Lanes h, Lanes k, Lanes v) {
+        const __m128i t = _mm_mullo_epi16(_mm_xor_si128(h, v), k);
+        return _mm_xor_si128(t, _mm_srli_epi16(t, 7));
+    }
+    static inline void  store(uint64_t* out, Lanes h) { _mm_storeu_si128((__m128i*)out, h); }
+#elif VC_SIMD_NEON
+    typedef uint16x8_t Lanes;
+    static inline Lanes splat(uint16_t v) { return vdupq_n_u16(v); }
+    static inline Lanes load(const uint8_t* p) { return vreinterpretq_u16_u8(vld1q_u8(p)); }
+    static inline Lanes step(Lanes h, Lanes k, Lanes v) {
+        const uint16x8_t t = vmulq_u16(veorq_u16(h, v), k);
+        return veorq_u16(t, vshrq_n_u16(t, 7));
+    }
+    static inline void  store(uint64_t* out, Lanes h) { vst1q_u8((uint8_t*)out, vreinterpretq_u8_u16(h)); }
+#else
+    struct Lanes { uint16_t l[8]; };
+    static inline Lanes splat(uint16_t v) { Lanes r; std::fill(r.l, r.l + 8, v); return r; }
+    static inline Lanes load(const uint8_t* p) { Lanes r; memcpy(r.l, p, sizeof(r.l)); return r; }
+    static inline Lanes step(Lanes h, Lanes k, Lanes v) {
+        for ( int i = 0 ; i < 8 ; ++i ) {
+            const uint16_t t = uint16_t((h.l[i] ^ v.l[i]) * k.l[i]);
+            h.l[i] = t ^ (t >> 7);
+        }
+        return h;
+    }
+    static inline void  store(uint64_t* out, Lanes h) { memcpy(out, h.l, sizeof(h.l)); }
+#endif
+
+    static void
+    hashRows(const uint8_t* pixels, size_t stride, size_t rowBytes, int rowBegin, int rowEnd, uint64_t* out)
+    {
+        const Lanes k = splat(kMultiplier);
+        Lanes h[kChains];
+        for ( int c = 0 ; c < kChains ; ++c ) {
+            h[c] = splat(uint16_t(c + 1));
+        }
+        for ( int y = rowBegin ; y < rowEnd ; ++y ) {
+            const uint8_t* row = pixels + y * stride;
+            size_t i = 0;
+            for ( ; i + 16 * kChains <= rowBytes ; i += 16 * kChains ) {
+                for ( int c = 0 ; c < kChains ; ++c ) {
+                    h[c] = step(h[c], k, load(row + i + 16 * c));
+                }
+            }
+            for ( ; i + 16 <= rowBytes ; i += 16 ) {
+                h[0] = step(h[0], k, load(row + i));
+            }
+            if(i < rowBytes) {
+                uint8_t tail[16] = { 0 };
+                memcpy(tail, row + i, rowBytes - i);
+                h[0] = step(h[0], k, load(tail));
+            }
+        }
+        for ( int c = 1 ; c < kChains ; ++c ) {
+            h[0] = step(h[0], k, h[c]);
+        }
+        store(out, h[0]);
+    }
+
+    FrameHash::FrameHash()
+    : m_width(0), m_height(0), m_valid(false)
+    {
+    }
+    bool
+    FrameHash::update(const uint8_t* pixels, size_t stride, int width, int height, int rowBegin, int rowEnd)
+    {
+        if(width != m_width || height != m_height) {
+            m_width = width;
+            m_height = height;
+            m_bands.assign((height + kBandRows - 1) / kBandRows, Hash());
+            m_valid = false;
+        }
+        rowBegin = std::max(0, rowBegin);
+        rowEnd = std::min(height, rowEnd);
+
+        const int firstBand = m_valid ? rowBegin / kBandRows : 0;
+        const int lastBand = m_valid ? (rowEnd + kBandRows - 1) / kBandRows : int(m_bands.size());
+        bool changed = !m_valid;
+
+        for ( int b = firstBand ; b < lastBand ; ++b ) {
+            Hash hash;
+            hashRows(pixels, stride, size_t(width) * 4, b * kBandRows, std::min(height, (b + 1) * kBandRows), hash.v);
+            if(!(hash == m_bands[b])) {
+                m_bands[b] = hash;
+                changed = true;
+            }
+        }
+        m_valid = true;
+        return changed;
+    }
+
+}
+}
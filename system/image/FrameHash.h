@@ -0,0 +1,77 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__FrameHash__
+#define __videocore__FrameHash__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace videocore { namespace image {
+
+    /*!
+     *  Detects whether a 32-bit frame differs from the previous one passed in.  The frame is split into bands of
+     *  kBandRows rows, each summarised by a 128-bit SIMD hash, so that callers that know which rows may have
+     *  changed only pay for hashing those.
+     *
+     *  The hash mixes 16-bit lanes with multiplies and shifts; any single changed byte always changes it, and it
+     *  runs at about memcpy speed.  It is not a cryptographic hash.
+     */
+    class FrameHash
+    {
+    public:
+        /*! Rows hashed together. */
+        static const int kBandRows = 16;
+
+        FrameHash();
+
+        /*!
+         *  Rehash the bands of a frame that overlap rows [rowBegin, rowEnd).  The other rows must be identical to
+         *  the previous frame.
+         *
+         *  \return true if the frame differs from the previous one.  Always true for the first frame and after
+         *          the frame size changes or invalidate() is called.
+         */
+        bool update(const uint8_t* pixels, size_t stride, int width, int height, int rowBegin, int rowEnd);
+
+        /*! Forget the previous frame. */
+        void invalidate() { m_valid = false; };
+
+    private:
+        struct Hash {
+            uint64_t v[2];
+            bool operator==(const Hash& rhs) const { return v[0] == rhs.v[0] && v[1] == rhs.v[1]; };
+        };
+
+        std::vector<Hash> m_bands;
+        int               m_width;
+        int               m_height;
+        bool              m_valid;
+    };
+
+}
+}
+#endif /* defined(__videocore__FrameHash__) */
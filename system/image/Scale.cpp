@@ -0,0 +1,285 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/image/Scale.h>
+#include <videocore/system/Simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+// Filter weights are fixed point with this many fractional bits.
+static const int kWeightShift = 14;
+
+// The intermediate row keeps this many fractional bits per channel between the two passes.
+static const int kIntermediateShift = 6;
+
+static const int kLanczosLobes = 3;
+
+namespace videocore { namespace image {
+
+    namespace {
+
+        inline double
+        sinc(double x)
+        {
+            if(fabs(x) < 1e-9) {
+                return 1.;
+            }
+            x *= M_PI;
+            return sin(x) / x;
+        }
+
+        inline uint8_t
+        clamp8(int x)
+        {
+            return uint8_t(std::min(255, std::max(0, x)));
+        }
+    }
+
+    Scaler::Taps
+    Scaler::buildTaps(int srcSize, int dstSize, ScaleFilter filter)
+    {
+        const double ratio = double(srcSize) / double(dstSize);
+        const double scale = std::max(1., ratio);
+
+        double support;
+        switch(filter) {
+            case kScaleFilterArea:
+                support = ratio * 0.5 + 0.5;
+                break;
+            case kScaleFilterLanczos:
+                support = kLanczosLobes * scale;
+                break;
+            default:
+                support = scale;
+                break;
+        }
+
+        std::vector<std::map<int, double>> contributions(dstSize);
+        int count = 1;
+
+        for ( int i = 0 ; i < dstSize ; ++i ) {
+            const double center = (i + 0.5) * ratio - 0.5;
+            auto & taps = contributions[i];
+
+            for ( int j = int(floor(center - support)) ; j <= int(ceil(center + support)) ; ++j ) {
+                const double d = j - center;
+                double w;
+                switch(filter) {
+                    case kScaleFilterArea:
+                        // Overlap of source pixel j with the destination pixel's footprint.
+                        w = std::max(0., std::min(d + 0.5, ratio * 0.5) - std::max(d - 0.5, -ratio * 0.5));
+                        break;
+                    case kScaleFilterLanczos:
+                        w = fabs(d / scale) < kLanczosLobes ? sinc(d / scale) * sinc(d / scale / kLanczosLobes) : 0.;
+                        break;
+                    default:
+                        w = std::max(0., 1. - fabs(d) / scale);
+                        break;
+                }
+                if(fabs(w) > 1e-9) {
+                    taps[std::min(srcSize - 1, std::max(0, j))] += w;
+                }
+            }
+            if(taps.empty()) {
+                taps[std::min(srcSize - 1, std::max(0, int(lround(center))))] = 1.;
+            }
+            count = std::max(count, taps.rbegin()->first - taps.begin()->first + 1);
+        }
+
+        Taps t;
+        t.count = std::min(count, srcSize);
+        t.start.resize(dstSize);
+        t.weights.assign(size_t(dstSize) * t.count, 0);
+
+        for ( int i = 0 ; i < dstSize ; ++i ) {
+            const auto & taps = contributions[i];
+            const int start = std::min(taps.begin()->first, srcSize - t.count);
+            int16_t* w = &t.weights[size_t(i) * t.count];
+
+            double sum = 0.;
+            for ( auto & tap : taps ) {
+                sum += tap.second;
+            }
+            // Quantize, then put the rounding error on the largest tap so every row sums to exactly 1.0.
+            int total = 0, largest = 0;
+            for ( auto & tap : taps ) {
+                const int k = tap.first - start;
+                w[k] = int16_t(lround(tap.second / sum * (1 << kWeightShift)));
+                total += w[k];
+                if(abs(w[k]) > abs(w[largest])) {
+                    largest = k;
+                }
+            }
+            w[largest] += (1 << kWeightShift) - total;
+            t.start[i] = start;
+        }
+        return t;
+    }
+
+    Scaler::Scaler(int srcWidth, int srcHeight, int dstWidth, int dstHeight, ScaleFilter filter)
+    : m_horizontal(buildTaps(srcWidth, dstWidth, filter)),
+    m_vertical(buildTaps(srcHeight, dstHeight, filter)),
+    m_srcWidth(srcWidth),
+    m_srcHeight(srcHeight),
+    m_dstWidth(dstWidth),
+    m_dstHeight(dstHeight),
+    m_filter(filter)
+    {
+    }
+
+    void
+    Scaler::verticalPass(const uint8_t* src, size_t srcStride, int row, int16_t* out) const
+    {
+        const int count = m_vertical.count;
+        const int16_t* weights = &m_vertical.weights[size_t(row) * count];
+        const uint8_t* first = src + m_vertical.start[row] * srcStride;
+        const int bytes = m_srcWidth * 4;
+        const int round = 1 << (kWeightShift - kIntermediateShift - 1);
+        int x = 0;
+
+#if VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vround = _mm_set1_epi32(round);
+
+        for ( ; x + 16 <= bytes ; x += 16 ) {
+            __m128i acc[4] = { zero, zero, zero, zero };
+
+            // Taps are taken in pairs so each madd applies two weights at once.
+            for ( int k = 0 ; k < count ; k += 2 ) {
+                const __m128i a = _mm_loadu_si128((const __m128i*)(first + k * srcStride + x));
+                const __m128i b = (k + 1 < count) ? _mm_loadu_si128((const __m128i*)(first + (k + 1) * srcStride + x)) : zero;
+                const __m128i w = _mm_set1_epi32(int32_t(uint16_t(weights[k]) | (k + 1 < count ? uint32_t(uint16_t(weights[k + 1])) << 16 : 0u)));
+
+                const __m128i alo = _mm_unpacklo_epi8(a, zero), ahi = _mm_unpackhi_epi8(a, zero);
+                const __m128i blo = _mm_unpacklo_epi8(b, zero), bhi = _mm_unpackhi_epi8(b, zero);
+                acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), w));
+                acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), w));
+                acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), w));
+                acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), w));
+            }
+            for ( int i = 0 ; i < 4 ; ++i ) {
+                acc[i] = _mm_srai_epi32(_mm_add_epi32(acc[i], vround), kWeightShift - kIntermediateShift);
+            }
+            _mm_storeu_si128((__m128i*)(out + x), _mm_packs_epi32(acc[0], acc[1]));
+            _mm_storeu_si128((__m128i*)(out + x + 8), _mm_packs_epi32(acc[2], acc[3]));
+        }
+#elif VC_SIMD_NEON
+        for ( ; x + 16 <= bytes ; x += 16 ) {
+            int32x4_t acc[4] = { vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0) };
+
+            for ( int k = 0 ; k < count ; ++k ) {
+                const uint8x16_t a = vld1q_u8(first + k * srcStride + x);
+                const int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(a)));
+                const int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(a)));
+                acc[0] = vmlal_n_s16(acc[0], vget_low_s16(lo), weights[k]);
+                acc[1] = vmlal_n_s16(acc[1], vget_high_s16(lo), weights[k]);
+                acc[2] = vmlal_n_s16(acc[2], vget_low_s16(hi), weights[k]);
+                acc[3] = vmlal_n_s16(acc[3], vget_high_s16(hi), weights[k]);
+            }
+            vst1q_s16(out + x, vcombine_s16(vqrshrn_n_s32(acc[0], kWeightShift - kIntermediateShift),
+                                            vqrshrn_n_s32(acc[1], kWeightShift - kIntermediateShift)));
+            vst1q_s16(out + x + 8, vcombine_s16(vqrshrn_n_s32(acc[2], kWeightShift - kIntermediateShift),
+                                                vqrshrn_n_s32(acc[3], kWeightShift - kIntermediateShift)));
+        }
+#endif
+        for ( ; x < bytes ; ++x ) {
+            int acc = round;
+            for ( int k = 0 ; k < count ; ++k ) {
+                acc += first[k * srcStride + x] * weights[k];
+            }
+            out[x] = int16_t(std::min(32767, std::max(-32768, acc >> (kWeightShift - kIntermediateShift))));
+        }
+    }
+
+    void
+    Scaler::horizontalPass(const int16_t* in, uint8_t* out) const
+    {
+        const int count = m_horizontal.count;
+        const int shift = kWeightShift + kIntermediateShift;
+        const int round = 1 << (shift - 1);
+
+        for ( int i = 0 ; i < m_dstWidth ; ++i ) {
+            const int16_t* p = in + m_horizontal.start[i] * 4;
+            const int16_t* weights = &m_horizontal.weights[size_t(i) * count];
+#if VC_SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = _mm_set1_epi32(round);
+            int k = 0;
+            for ( ; k + 2 <= count ; k += 2 ) {
+                int32_t w;
+                memcpy(&w, weights + k, sizeof(w));
+                const __m128i a = _mm_loadl_epi64((const __m128i*)(p + k * 4));
+                const __m128i b = _mm_loadl_epi64((const __m128i*)(p + k * 4 + 4));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_set1_epi32(w)));
+            }
+            if(k < count) {
+                const __m128i a = _mm_loadl_epi64((const __m128i*)(p + k * 4));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), _mm_set1_epi32(uint16_t(weights[k]))));
+            }
+            acc = _mm_srai_epi32(acc, shift);
+            acc = _mm_packs_epi32(acc, acc);
+            const int32_t px = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+            memcpy(out + i * 4, &px, sizeof(px));
+#elif VC_SIMD_NEON
+            int32x4_t acc = vdupq_n_s32(round);
+            for ( int k = 0 ; k < count ; ++k ) {
+                acc = vmlal_n_s16(acc, vld1_s16(p + k * 4), weights[k]);
+            }
+            const int16x4_t px = vqmovn_s32(vshrq_n_s32(acc, shift));
+            const uint8x8_t px8 = vqmovun_s16(vcombine_s16(px, px));
+            vst1_lane_u32((uint32_t*)(out + i * 4), vreinterpret_u32_u8(px8), 0);
+#else
+            for ( int c = 0 ; c < 4 ; ++c ) {
+                int acc = round;
+                for ( int k = 0 ; k < count ; ++k ) {
+                    acc += p[k * 4 + c] * weights[k];
+                }
+                out[i * 4 + c] = clamp8(acc >> shift);
+            }
+#endif
+        }
+    }
+
+    void
+    Scaler::scale(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                  int rowBegin, int rowEnd, int16_t* scratch) const
+    {
+        rowEnd = std::min(rowEnd, m_dstHeight);
+        for ( int row = rowBegin ; row < rowEnd ; ++row ) {
+            scaleRow(src, srcStride, row, dst + row * dstStride, scratch);
+        }
+    }
+
+    void
+    Scaler::scaleRow(const uint8_t* src, size_t srcStride, int row, uint8_t* dstRow, int16_t* scratch) const
+    {
+        verticalPass(src, srcStride, row, scratch);
+        horizontalPass(scratch, dstRow);
+    }
+}
+}
@@ -0,0 +1,111 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__Scale__
+#define __videocore__Scale__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace videocore { namespace image {
+
+    typedef enum {
+        kScaleFilterBilinear,   /*!< Triangle filter; widens when downscaling so it does not alias like a 2-tap lerp */
+        kScaleFilterArea,       /*!< Box filter weighted by pixel overlap */
+        kScaleFilterLanczos     /*!< Lanczos, 3 lobes */
+    } ScaleFilter;
+
+    /*!
+     *  A separable resampler for 32-bit (4 channel, 8 bits per channel) images.  The filter tables are built once for
+     *  a pair of sizes; scaling runs a vertical pass into a 16-bit intermediate row followed by a horizontal pass.
+     *  Both passes are vectorized.  Channel order is preserved, so BGRA and RGBA are handled alike.
+     */
+    class Scaler
+    {
+    public:
+        /*! Constructor.
+         *
+         *  \param srcWidth, srcHeight  The source dimensions.
+         *  \param dstWidth, dstHeight  The destination dimensions.
+         *  \param filter               The resampling filter.
+         */
+        Scaler(int srcWidth, int srcHeight, int dstWidth, int dstHeight, ScaleFilter filter);
+
+        int srcWidth() const { return m_srcWidth; };
+        int srcHeight() const { return m_srcHeight; };
+        int dstWidth() const { return m_dstWidth; };
+        int dstHeight() const { return m_dstHeight; };
+        ScaleFilter filter() const { return m_filter; };
+
+        /*! The number of int16_t elements of scratch space scale() needs per concurrent caller. */
+        size_t scratchSize() const { return size_t(m_srcWidth) * 4; };
+
+        /*!
+         *  Scale into rows [rowBegin, rowEnd) of the destination.
+         *
+         *  \param src, srcStride   The source pixels.
+         *  \param dst, dstStride   The destination pixels.
+         *  \param rowBegin, rowEnd The destination rows to produce; lets callers split the work in stripes.
+         *  \param scratch          At least scratchSize() elements.
+         */
+        void scale(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                   int rowBegin, int rowEnd, int16_t* scratch) const;
+
+        /*!
+         *  Produce a single destination row.  Lets callers consume rows as they are made, e.g. to convert them
+         *  to YUV while they are still in cache.
+         *
+         *  \param row      The destination row.
+         *  \param dstRow   Where to write the row's dstWidth() pixels.
+         */
+        void scaleRow(const uint8_t* src, size_t srcStride, int row, uint8_t* dstRow, int16_t* scratch) const;
+
+    private:
+        /*! Filter taps for one axis: output i reads count inputs from start[i] with weights[i * count ...]. */
+        struct Taps {
+            std::vector<int>     start;
+            std::vector<int16_t> weights;
+            int                  count;
+        };
+
+        static Taps buildTaps(int srcSize, int dstSize, ScaleFilter filter);
+
+        void verticalPass(const uint8_t* src, size_t srcStride, int row, int16_t* out) const;
+        void horizontalPass(const int16_t* in, uint8_t* out) const;
+
+    private:
+        Taps m_horizontal;
+        Taps m_vertical;
+
+        int  m_srcWidth;
+        int  m_srcHeight;
+        int  m_dstWidth;
+        int  m_dstHeight;
+        ScaleFilter m_filter;
+    };
+}
+}
+#endif /* defined(__videocore__Scale__) */
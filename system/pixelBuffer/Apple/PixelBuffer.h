@@ -28,6 +28,7 @@
 #include <CoreVideo/CoreVideo.h>
 #include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
 #include <memory>
+#include <algorithm>
 
 namespace videocore { namespace Apple {
  
@@ -47,6 +48,14 @@ namespace videocore { namespace Apple {
         const int   height() const { return (int)CVPixelBufferGetHeight(m_pixelBuffer); };
         const void* baseAddress() const { return CVPixelBufferGetBaseAddress(m_pixelBuffer); };
         
+        const size_t planeCount() const { return std::max<size_t>(1, CVPixelBufferGetPlaneCount(m_pixelBuffer)); };
+        const void*  baseAddressOfPlane(size_t plane) const {
+            return CVPixelBufferIsPlanar(m_pixelBuffer) ? CVPixelBufferGetBaseAddressOfPlane(m_pixelBuffer, plane) : baseAddress();
+        };
+        const size_t bytesPerRowOfPlane(size_t plane) const {
+            return CVPixelBufferIsPlanar(m_pixelBuffer) ? CVPixelBufferGetBytesPerRowOfPlane(m_pixelBuffer, plane) : CVPixelBufferGetBytesPerRow(m_pixelBuffer);
+        };
+        
         const PixelBufferFormatType pixelFormat() const { return m_pixelFormat; };
         
         void  lock(bool readOnly = false);
@@ -1,25 +1,82 @@
 #include <videocore/system/pixelBuffer/GenericPixelBuffer.h>
 
+#include <algorithm>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 namespace videocore {
 
-	GenericPixelBuffer::GenericPixelBuffer(int width, int height, PixelBufferFormatType pixelFormat)
+	static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+	static inline size_t
+	alignUp(size_t x, size_t alignment)
+	{
+		return (x + alignment - 1) & ~(alignment - 1);
+	}
+
+	static uint8_t*
+	allocatePixels(size_t size, bool hugePages)
 	{
-		size_t bufferSize = 0;
+		void* p = nullptr;
+		size_t alignment = GenericPixelBuffer::kPlaneAlignment;
+
+#ifdef MADV_HUGEPAGE
+		if(hugePages && size >= kHugePageSize) {
+			alignment = kHugePageSize;
+			size = alignUp(size, kHugePageSize);
+		}
+#endif
+		if(posix_memalign(&p, alignment, std::max<size_t>(size, 1)) != 0) {
+			throw std::bad_alloc();
+		}
+#ifdef MADV_HUGEPAGE
+		if(alignment == kHugePageSize) {
+			madvise(p, size, MADV_HUGEPAGE);   // advisory; falls back to normal pages
+		}
+#endif
+		return (uint8_t*)p;
+	}
+
+	GenericPixelBuffer::GenericPixelBuffer(int width, int height, PixelBufferFormatType pixelFormat, bool hugePages)
+	: m_pixels(nullptr, free), m_planeCount(1), m_width(width), m_height(height), m_pixelFormat(pixelFormat), m_state(kVCPixelBufferStateAvailable), m_temporary(false)
+	{
+		const size_t chromaWidth = (width + 1) / 2;
+		const size_t chromaHeight = (height + 1) / 2;
+		size_t rows[kMaxPlanes] = { size_t(height), 0, 0 };
+
 		switch(pixelFormat) {
-			case kVCPixelBufferFormat32BGRA:
-			case kVCPixelBufferFormat32RGBA:
-				bufferSize = width*height*4;
+			case kCVPixelBufferFormat420v:
+			case kVCPixelBufferFormat420f:
+				m_planeCount = 2;
+				m_planes[0].bytesPerRow = alignUp(width, kPlaneAlignment);
+				m_planes[1].bytesPerRow = alignUp(chromaWidth * 2, kPlaneAlignment);
+				rows[1] = chromaHeight;
+				break;
+			case kVCPixelBufferFormatI420:
+				m_planeCount = 3;
+				m_planes[0].bytesPerRow = alignUp(width, kPlaneAlignment);
+				m_planes[1].bytesPerRow = m_planes[2].bytesPerRow = alignUp(chromaWidth, kPlaneAlignment);
+				rows[1] = rows[2] = chromaHeight;
 				break;
 			case kVCPixelBufferFormatL565:
-				bufferSize = width*height*2;
+				m_planes[0].bytesPerRow = alignUp(width * 2, kPlaneAlignment);
 				break;
-			case kCVPixelBufferFormat420v:
-				bufferSize = width*height*1.5;
+			case kVCPixelBufferFormat32BGRA:
+			case kVCPixelBufferFormat32RGBA:
+			default:
+				m_planes[0].bytesPerRow = alignUp(width * 4, kPlaneAlignment);
 				break;
+		}
 
+		size_t offset = 0;
+		for ( size_t i = 0 ; i < m_planeCount ; ++i ) {
+			m_planes[i].offset = offset;
+			offset += alignUp(m_planes[i].bytesPerRow * rows[i], kPlaneAlignment);
 		}
-		
-		m_buffer = std::make_shared<std::vector<uint8_t>>(bufferSize);
+		m_dataSize = offset;
+		m_pixels.reset(allocatePixels(m_dataSize, hugePages));
 	}
 
 }
\ No newline at end of file
@@ -27,36 +27,76 @@
 
 #include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
 
-#include <vector>
 #include <memory>
 #include <stdint.h>
+#include <stdlib.h>
  
 namespace videocore {
 
+	/*!
+	 *  A pixel buffer in main memory.  Every plane starts on a kPlaneAlignment boundary and every row is padded to a
+	 *  multiple of kPlaneAlignment bytes, so SIMD kernels can use aligned loads on row starts.  Supports the packed
+	 *  32-bit and L565 formats, NV12 ('420v', '420f') and I420 ('y420').
+	 */
 	class GenericPixelBuffer : public IPixelBuffer {
 
-	public: 
-		GenericPixelBuffer(int width, int height, PixelBufferFormatType pixelFormat);
+	public:
+		static const size_t kPlaneAlignment = 64;
+		static const size_t kMaxPlanes = 3;
+
+		/*! Constructor.
+		 *
+		 *  \param width        The width in pixels.
+		 *  \param height       The height in pixels.
+		 *  \param pixelFormat  The pixel format.
+		 *  \param hugePages    Ask the OS to back the pixels with huge pages where supported, which cuts TLB misses
+		 *                      on large frames.
+		 */
+		GenericPixelBuffer(int width, int height, PixelBufferFormatType pixelFormat, bool hugePages = false);
 		~GenericPixelBuffer() {};
 
 	public:
 		const int   width() const  { return m_width; };
 		const int   height() const { return m_height; };
-		const void* baseAddress() const { return &(*m_buffer)[0]; };
+		const void* baseAddress() const { return m_pixels.get(); };
 		
 	    const PixelBufferFormatType pixelFormat() const { return m_pixelFormat; };
+
+		const size_t planeCount() const { return m_planeCount; };
+		const void*  baseAddressOfPlane(size_t plane) const { return m_pixels.get() + m_planes[plane].offset; };
+		const size_t bytesPerRowOfPlane(size_t plane) const { return m_planes[plane].bytesPerRow; };
+
+		/*! The size of the allocation backing all planes. */
+		const size_t dataSize() const { return m_dataSize; };
 		
 		void  lock(bool readOnly = false) {};
 		void  unlock(bool readOnly = false) {};
 
+		void  setState(const PixelBufferState state) { m_state = state; };
+		const PixelBufferState state() const { return m_state; };
+
+		const bool isTemporary() const { return m_temporary; };
+		void setTemporary(const bool temporary) { m_temporary = temporary; };
+
 	private:
 
-		std::shared_ptr<std::vector<uint8_t>> m_buffer;
+		struct Plane {
+			size_t offset;
+			size_t bytesPerRow;
+		};
+
+		std::unique_ptr<uint8_t, void(*)(void*)> m_pixels;
+
+		Plane   m_planes[kMaxPlanes];
+		size_t  m_planeCount;
+		size_t  m_dataSize;
 
 		int  m_width;
 		int  m_height;
 
 		PixelBufferFormatType  m_pixelFormat;
+		PixelBufferState       m_state;
+		bool                   m_temporary;
 
 	};
 }
@@ -26,6 +26,7 @@
 #define videocore_IPixelBuffer_hpp
 
 #include <stdint.h>
+#include <stddef.h>
 
 namespace videocore {
 
@@ -33,7 +34,9 @@ namespace videocore {
 		kVCPixelBufferFormat32BGRA = 'bgra',
 		kVCPixelBufferFormat32RGBA = 'rgba',
 		kVCPixelBufferFormatL565 = 'L565',
-		kCVPixelBufferFormat420v = '420v',
+		kCVPixelBufferFormat420v = '420v',    /* NV12, limited range */
+		kVCPixelBufferFormat420f = '420f',    /* NV12, full range */
+		kVCPixelBufferFormatI420 = 'y420',    /* planar Y, Cb, Cr */
 	} PixelBufferFormatType_;
     
     typedef uint32_t PixelBufferFormatType;
@@ -56,6 +59,12 @@ namespace videocore {
 
 		virtual const void* baseAddress() const = 0;
 
+		/* Planar formats (NV12, I420) expose one plane per component; packed formats have a single plane.
+		   The defaults describe a tightly packed 32-bit buffer; implementations with other layouts override them. */
+		virtual const size_t planeCount() const { return 1; };
+		virtual const void*  baseAddressOfPlane(size_t plane) const { return baseAddress(); };
+		virtual const size_t bytesPerRowOfPlane(size_t plane) const { return size_t(width()) * 4; };
+
 		virtual void  lock(bool readOnly = false) = 0;
 		virtual void  unlock(bool readOnly = false) = 0;
         
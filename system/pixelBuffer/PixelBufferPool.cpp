@@ -0,0 +1,109 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/system/pixelBuffer/PixelBufferPool.h>
+
+namespace videocore {
+
+    PixelBufferPool::PixelBufferPool(int width,
+                                     int height,
+                                     PixelBufferFormatType pixelFormat,
+                                     size_t maxBuffers,
+                                     bool hugePages)
+    : m_state(std::make_shared<State>()),
+    m_width(width),
+    m_height(height),
+    m_pixelFormat(pixelFormat),
+    m_maxBuffers(maxBuffers),
+    m_hugePages(hugePages)
+    {
+        m_state->outstanding = 0;
+        m_state->alive = true;
+    }
+
+    PixelBufferPool::~PixelBufferPool()
+    {
+        std::lock_guard<std::mutex> l(m_state->mutex);
+        m_state->alive = false;
+        m_state->available.clear();
+    }
+
+    std::shared_ptr<IPixelBuffer>
+    PixelBufferPool::dequeue()
+    {
+        std::unique_ptr<GenericPixelBuffer> buffer;
+        {
+            std::lock_guard<std::mutex> l(m_state->mutex);
+            if(m_maxBuffers && m_state->outstanding >= m_maxBuffers) {
+                return nullptr;
+            }
+            if(!m_state->available.empty()) {
+                buffer = std::move(m_state->available.back());
+                m_state->available.pop_back();
+                m_state->outstanding++;
+            }
+        }
+        if(!buffer) {
+            // Allocate outside the lock, and only count the buffer once it exists.
+            buffer.reset(new GenericPixelBuffer(m_width, m_height, m_pixelFormat, m_hugePages));
+
+            std::lock_guard<std::mutex> l(m_state->mutex);
+            if(m_maxBuffers && m_state->outstanding >= m_maxBuffers) {
+                // Another caller took the last slot while this one was allocating.
+                m_state->available.push_back(std::move(buffer));
+                return nullptr;
+            }
+            m_state->outstanding++;
+        }
+        buffer->setState(kVCPixelBufferStateDequeued);
+        buffer->setTemporary(false);
+
+        auto state = m_state;
+        return std::shared_ptr<IPixelBuffer>(buffer.release(), [state](IPixelBuffer* released) {
+            std::unique_ptr<GenericPixelBuffer> b(static_cast<GenericPixelBuffer*>(released));
+            b->setState(kVCPixelBufferStateAvailable);
+
+            std::lock_guard<std::mutex> l(state->mutex);
+            state->outstanding--;
+            if(state->alive) {
+                state->available.push_back(std::move(b));
+            }
+        });
+    }
+
+    void
+    PixelBufferPool::flush()
+    {
+        std::lock_guard<std::mutex> l(m_state->mutex);
+        m_state->available.clear();
+    }
+
+    size_t
+    PixelBufferPool::outstandingCount() const
+    {
+        std::lock_guard<std::mutex> l(m_state->mutex);
+        return m_state->outstanding;
+    }
+}
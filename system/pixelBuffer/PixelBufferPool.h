@@ -0,0 +1,101 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__PixelBufferPool__
+#define __videocore__PixelBufferPool__
+
+#include <videocore/system/pixelBuffer/GenericPixelBuffer.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace videocore {
+
+    /*!
+     *  Recycles GenericPixelBuffers of one size and format so producers do not allocate a frame per frame.
+     *
+     *  Buffers move through the IPixelBuffer states: a buffer in the pool is Available; dequeue() hands it out as
+     *  Dequeued; the producer marks it Enqueued when it pushes it downstream and consumers mark it Acquired while they
+     *  hold it.  When the last reference is released the buffer returns to the pool as Available.  Buffers may
+     *  outlive the pool; they are then freed instead of recycled.
+     */
+    class PixelBufferPool
+    {
+    public:
+        /*! Constructor.
+         *
+         *  \param width        The width of the buffers.
+         *  \param height       The height of the buffers.
+         *  \param pixelFormat  The pixel format of the buffers.
+         *  \param maxBuffers   The maximum number of buffers outstanding at once, 0 for no limit.
+         *  \param hugePages    Back the buffers with huge pages where supported.
+         */
+        PixelBufferPool(int width,
+                        int height,
+                        PixelBufferFormatType pixelFormat,
+                        size_t maxBuffers = 0,
+                        bool hugePages = false);
+
+        /*! Destructor */
+        ~PixelBufferPool();
+
+        /*!
+         *  Take a buffer from the pool, allocating one if none is available.
+         *
+         *  \return a buffer in the Dequeued state, or nullptr if maxBuffers are already outstanding.
+         */
+        std::shared_ptr<IPixelBuffer> dequeue();
+
+        /*! Free the buffers that are currently in the pool. */
+        void flush();
+
+        const int width() const { return m_width; };
+        const int height() const { return m_height; };
+        const PixelBufferFormatType pixelFormat() const { return m_pixelFormat; };
+
+        /*! The number of buffers handed out and not yet returned. */
+        size_t outstandingCount() const;
+
+    private:
+
+        /* Shared with the buffers' deleters so a buffer released after the pool is gone can tell. */
+        struct State {
+            std::mutex                                       mutex;
+            std::vector<std::unique_ptr<GenericPixelBuffer>> available;
+            size_t                                           outstanding;
+            bool                                             alive;
+        };
+
+        std::shared_ptr<State> m_state;
+
+        int                   m_width;
+        int                   m_height;
+        PixelBufferFormatType m_pixelFormat;
+        size_t                m_maxBuffers;
+        bool                  m_hugePages;
+    };
+}
+#endif /* defined(__videocore__PixelBufferPool__) */
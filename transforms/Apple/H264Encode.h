@@ -39,7 +39,11 @@ namespace videocore { namespace Apple {
         /*! ITransform */
         void setOutput(std::shared_ptr<IOutput> output) { m_output = output; };
         
-        // Input is expecting a CVPixelBufferRef
+        /*! IOutput::queuedDuration */
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
+        
+        // Input is expecting a CVPixelBufferRef.  Frames are skipped while more than kMaxQueuedDuration is queued
+        // downstream.
         void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
         
     public:
@@ -48,8 +52,15 @@ namespace videocore { namespace Apple {
         
         const int bitrate() const { return m_bitrate; };
         
+        /*! IEncoder::requestKeyframe */
         void requestKeyframe();
         
+        /*!
+         *  IEncoder::setVideoFormat.  The compression session is recreated.  Input frames need not be resized:
+         *  VideoToolbox scales frames of another size to the session's.
+         */
+        bool setVideoFormat(int width, int height, int fps);
+        
     public:
         void compressionSessionOutput(const uint8_t* data, size_t size, uint64_t pts, uint64_t dts);
         
@@ -81,12 +81,16 @@ namespace videocore { namespace Apple {
             std::unique_ptr<uint8_t[]> sps_buf (new uint8_t[spsSize + 4]) ;
             std::unique_ptr<uint8_t[]> pps_buf (new uint8_t[ppsSize + 4]) ;
             
+            // 4-byte big-endian length prefixes, like the NALs of the frame itself.
+            const uint32_t spsLength = CFSwapInt32HostToBig(uint32_t(spsSize));
+            const uint32_t ppsLength = CFSwapInt32HostToBig(uint32_t(ppsSize));
+            
             memcpy(&sps_buf[4], sps, spsSize);
             spsSize+=4 ;
-            memcpy(&sps_buf[0], &spsSize, 4);
+            memcpy(&sps_buf[0], &spsLength, 4);
             memcpy(&pps_buf[4], pps, ppsSize);
             ppsSize += 4;
-            memcpy(&pps_buf[0], &ppsSize, 4);
+            memcpy(&pps_buf[0], &ppsLength, 4);
             
             ((H264Encode*)outputCallbackRefCon)->compressionSessionOutput((uint8_t*)sps_buf.get(),spsSize, pts.value, dts.value);
             ((H264Encode*)outputCallbackRefCon)->compressionSessionOutput((uint8_t*)pps_buf.get(),ppsSize, pts.value, dts.value);
@@ -113,8 +117,17 @@ namespace videocore { namespace Apple {
     H264Encode::pushBuffer(const uint8_t *const data, size_t size, videocore::IMetadata &metadata)
     {
 #if VERSION_OK
+        if(queuedDuration() > kMaxQueuedDuration) {
+            // The session can't send what it already has; encoding more only adds to the backlog.
+            return;
+        }
         if(m_compressionSession) {
             m_encodeMutex.lock();
+            if(!m_compressionSession) {
+                // setVideoFormat() is recreating the session.
+                m_encodeMutex.unlock();
+                return;
+            }
             VTCompressionSessionRef session = (VTCompressionSessionRef)m_compressionSession;
 
             CMTime pts = CMTimeMake(metadata.timestampDelta + m_ctsOffset, 1000.); // timestamp is in ms.
@@ -290,6 +303,34 @@ namespace videocore { namespace Apple {
     {
         m_forceKeyframe = true;
     }
+    bool
+    H264Encode::setVideoFormat(int width, int height, int fps)
+    {
+#if VERSION_OK
+        m_encodeMutex.lock();
+        if(width == m_frameW && height == m_frameH && fps == m_fps) {
+            m_encodeMutex.unlock();
+            return true;
+        }
+        if(m_compressionSession) {
+            // Frames already submitted come out of the old session first, so they keep their order.
+            VTCompressionSessionCompleteFrames((VTCompressionSessionRef)m_compressionSession, kCMTimeInvalid);
+            teardownCompressionSession();
+            m_compressionSession = nullptr;
+        }
+        m_frameW = width;
+        m_frameH = height;
+        m_fps = fps;
+        m_encodeMutex.unlock();
+        
+        // Frames pushed in between are dropped, as there is no session.
+        setupCompressionSession(m_baseline);
+        
+        return m_compressionSession != nullptr;
+#else
+        return false;
+#endif
+    }
     void
     H264Encode::setBitrate(int bitrate)
     {
@@ -0,0 +1,130 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/transforms/ColorConvertTransform.h>
+#include <videocore/system/WorkerPool.hpp>
+#include <videocore/system/util.h>
+
+#include <algorithm>
+
+// Output buffers that may be in flight downstream before the transform starts dropping frames.
+static const size_t kMaxOutputBuffers = 4;
+
+// Stripes are at least this many rows (even, so stripes own whole chroma rows).
+static const int kMinStripeRows = 32;
+
+namespace videocore {
+
+    ColorConvertTransform::ColorConvertTransform(PixelBufferFormatType outputFormat,
+                                                 image::ColorMatrix matrix,
+                                                 image::ColorRange range)
+    : m_outputFormat(outputFormat),
+    m_matrix(matrix),
+    m_range(range),
+    m_parallelism(0)
+    {
+    }
+
+    ColorConvertTransform::~ColorConvertTransform()
+    {
+    }
+
+    void
+    ColorConvertTransform::setOutput(std::shared_ptr<IOutput> output)
+    {
+        m_output = output;
+    }
+
+    void
+    ColorConvertTransform::pushBuffer(const uint8_t *const data,
+                                      size_t size,
+                                      videocore::IMetadata &metadata)
+    {
+        auto output = m_output.lock();
+        if(!output) {
+            return;
+        }
+        auto in = *(std::shared_ptr<IPixelBuffer>*)data;
+        const auto inFormat = in->pixelFormat();
+
+        if(inFormat == m_outputFormat) {
+            output->pushBuffer(data, size, metadata);
+            return;
+        }
+
+        const bool inIsRGB = (inFormat == kVCPixelBufferFormat32BGRA || inFormat == kVCPixelBufferFormat32RGBA);
+        const bool outIsRGB = (m_outputFormat == kVCPixelBufferFormat32BGRA || m_outputFormat == kVCPixelBufferFormat32RGBA);
+
+        if(!(inIsRGB && image::isYUVFormat(m_outputFormat)) && !(image::isYUVFormat(inFormat) && outIsRGB)) {
+            DLog("ColorConvertTransform: unsupported conversion %08x -> %08x\n", inFormat, m_outputFormat);
+            return;
+        }
+
+        const int width = in->width(), height = in->height();
+        if(!m_pool || m_pool->width() != width || m_pool->height() != height) {
+            m_pool.reset(new PixelBufferPool(width, height, m_outputFormat, kMaxOutputBuffers));
+        }
+        auto out = m_pool->dequeue();
+        if(!out) {
+            DLog("ColorConvertTransform: all output buffers are in use, dropping frame\n");
+            return;
+        }
+
+        in->lock(true);
+        out->lock();
+
+        image::YUVPlanes planes;
+        image::planesForBuffer(inIsRGB ? *out : *in, planes);
+        IPixelBuffer& rgb = inIsRGB ? *in : *out;
+        const image::ColorRange range = image::rangeForFormat(inIsRGB ? m_outputFormat : inFormat, m_range);
+
+        auto & pool = WorkerPool::shared();
+        const size_t threads = std::min(m_parallelism ? m_parallelism.load() : pool.threadCount() + 1, pool.threadCount() + 1);
+        const int stripes = std::max(1, std::min(int(threads), height / kMinStripeRows));
+        const int rowsPerStripe = ((height + stripes - 1) / stripes + 1) & ~1;
+
+        pool.parallelFor(stripes, threads, [&](size_t i) {
+            const int rowBegin = int(i) * rowsPerStripe;
+            const int rowEnd = std::min(height, rowBegin + rowsPerStripe);
+            if(rowBegin >= rowEnd) {
+                return;
+            }
+            if(inIsRGB) {
+                image::rgbToYUV((const uint8_t*)rgb.baseAddress(), rgb.bytesPerRowOfPlane(0), inFormat == kVCPixelBufferFormat32RGBA,
+                                width, height, rowBegin, rowEnd, planes, m_matrix, range);
+            } else {
+                image::yuvToRGB(planes, width, height, rowBegin, rowEnd,
+                                (uint8_t*)rgb.baseAddress(), rgb.bytesPerRowOfPlane(0), m_outputFormat == kVCPixelBufferFormat32RGBA,
+                                m_matrix, range);
+            }
+        });
+
+        out->unlock();
+        in->unlock(true);
+
+        out->setState(kVCPixelBufferStateEnqueued);
+        output->pushBuffer((const uint8_t*)&out, sizeof(out), metadata);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__ColorConvertTransform__
+#define __videocore__ColorConvertTransform__
+
+#include <videocore/transforms/ITransform.hpp>
+#include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
+#include <videocore/system/pixelBuffer/PixelBufferPool.h>
+#include <videocore/system/image/ColorConvert.h>
+
+#include <memory>
+#include <atomic>
+
+namespace videocore {
+
+    /*!
+     *  Converts pixel buffers between 32-bit BGRA/RGBA and 4:2:0 YUV on the CPU.  This is the software counterpart
+     *  of BasicVideoFilterBGRAinYUVAout, used between GenericVideoMixer and an encoder that takes YUV input.
+     *
+     *  Input and output are pushed as a pointer to a std::shared_ptr<IPixelBuffer>; the metadata is passed through.
+     *  Buffers already in the output format are forwarded untouched.
+     */
+    class ColorConvertTransform : public ITransform
+    {
+    public:
+        /*! Constructor.
+         *
+         *  \param outputFormat  kCVPixelBufferFormat420v, kVCPixelBufferFormat420f, kVCPixelBufferFormatI420,
+         *                       kVCPixelBufferFormat32BGRA or kVCPixelBufferFormat32RGBA.
+         *  \param matrix        The YUV colour matrix.
+         *  \param range         The YUV range for I420.  NV12 takes its range from the format ('420v' or '420f').
+         */
+        ColorConvertTransform(PixelBufferFormatType outputFormat,
+                              image::ColorMatrix matrix = image::kColorMatrixBT709,
+                              image::ColorRange range = image::kColorRangeLimited);
+
+        /*! Destructor */
+        ~ColorConvertTransform();
+
+        /*!
+         *  Set the number of threads used per frame.  Rows are converted in stripes on WorkerPool::shared().
+         *
+         *  \param threadCount  The maximum number of threads, including the calling thread.  0 uses every core.
+         */
+        void setParallelism(size_t threadCount) { m_parallelism = threadCount; };
+
+    public:
+
+        /*! ITransform::setOutput */
+        void setOutput(std::shared_ptr<IOutput> output);
+
+        /*! IOutput::queuedDuration */
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
+
+        /*! IOutput::pushBuffer */
+        void pushBuffer(const uint8_t* const data,
+                        size_t size,
+                        IMetadata& metadata);
+
+    private:
+
+        std::weak_ptr<IOutput> m_output;
+
+        std::unique_ptr<PixelBufferPool> m_pool;
+
+        PixelBufferFormatType m_outputFormat;
+        image::ColorMatrix    m_matrix;
+        image::ColorRange     m_range;
+
+        std::atomic<size_t>   m_parallelism;
+    };
+}
+
+#endif /* defined(__videocore__ColorConvertTransform__) */
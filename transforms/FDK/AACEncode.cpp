@@ -0,0 +1,186 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/transforms/FDK/AACEncode.h>
+#include <videocore/mixers/IAudioMixer.hpp>
+#include <videocore/system/util.h>
+
+namespace videocore { namespace FDK {
+
+    static CHANNEL_MODE
+    channelModeForChannelCount(int channelCount)
+    {
+        // Matches the default layouts in system/audio/ChannelLayout.h when AACENC_CHANNELORDER is WAV order.
+        switch(channelCount) {
+            case 1: return MODE_1;
+            case 2: return MODE_2;
+            case 3: return MODE_1_2;
+            case 4: return MODE_1_2_1;
+            case 5: return MODE_1_2_2;
+            case 6: return MODE_1_2_2_1;
+            case 8: return MODE_1_2_2_2_1;
+            default: return MODE_INVALID;
+        }
+    }
+
+    AACEncode::AACEncode(int frequencyInHz, int channelCount, int bitrate)
+    : m_encodeQueue("com.videocore.fdkaac", kJobQueuePriorityHigh),
+    m_encoder(nullptr),
+    m_pcmTimestamp(0.),
+    m_frequencyInHz(frequencyInHz),
+    m_channelCount(channelCount),
+    m_frameLength(1024),
+    m_bitrate(bitrate),
+    m_sentConfig(false)
+    {
+        m_asc[0] = m_asc[1] = 0;
+
+        AACENC_ERROR result = aacEncOpen(&m_encoder, 0, channelCount);
+
+        if(result == AACENC_OK) {
+            const CHANNEL_MODE mode = channelModeForChannelCount(channelCount);
+            if(mode == MODE_INVALID) {
+                DLog("FDK::AACEncode: unsupported channel count %d\n", channelCount);
+                result = AACENC_INVALID_CONFIG;
+            } else {
+                aacEncoder_SetParam(m_encoder, AACENC_AOT, AOT_AAC_LC);
+                aacEncoder_SetParam(m_encoder, AACENC_SAMPLERATE, frequencyInHz);
+                aacEncoder_SetParam(m_encoder, AACENC_CHANNELMODE, mode);
+                aacEncoder_SetParam(m_encoder, AACENC_CHANNELORDER, 1);
+                aacEncoder_SetParam(m_encoder, AACENC_BITRATE, bitrate);
+                aacEncoder_SetParam(m_encoder, AACENC_TRANSMUX, TT_MP4_RAW);
+                aacEncoder_SetParam(m_encoder, AACENC_AFTERBURNER, 1);
+
+                // Initialize with the parameters above.
+                result = aacEncEncode(m_encoder, NULL, NULL, NULL, NULL);
+            }
+        }
+        if(result == AACENC_OK) {
+            AACENC_InfoStruct info;
+            result = aacEncInfo(m_encoder, &info);
+
+            if(result == AACENC_OK) {
+                m_frameLength = info.frameLength;
+                m_outputBuffer.resize(info.maxOutBufBytes);
+                m_pcm.reserve(m_frameLength * channelCount * 2);
+
+                if(info.confSize >= 2) {
+                    m_asc[0] = info.confBuf[0];
+                    m_asc[1] = info.confBuf[1];
+                }
+            }
+        }
+        if(result != AACENC_OK) {
+            DLog("FDK::AACEncode: failed to create the encoder (0x%x)\n", result);
+            if(m_encoder) {
+                aacEncClose(&m_encoder);
+                m_encoder = nullptr;
+            }
+        }
+    }
+    AACEncode::~AACEncode()
+    {
+        m_encodeQueue.mark_exiting();
+        m_encodeQueue.enqueue_sync([]() {});
+
+        if(m_encoder) {
+            aacEncClose(&m_encoder);
+        }
+    }
+    void
+    AACEncode::pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
+    {
+        if(!m_encoder) {
+            return;
+        }
+        auto samples = std::make_shared<std::vector<int16_t>>((const int16_t*)data, (const int16_t*)(data + size));
+        const double ts = metadata.timestampDelta;
+
+        m_encodeQueue.enqueue([=]() {
+            if(m_pcm.empty()) {
+                m_pcmTimestamp = ts;
+            }
+            m_pcm.insert(m_pcm.end(), samples->begin(), samples->end());
+            encodePending();
+        });
+    }
+    void
+    AACEncode::encodePending()
+    {
+        const size_t samplesPerFrame = m_frameLength * m_channelCount;
+        const double frameDuration = double(m_frameLength) * 1000. / double(m_frequencyInHz);
+        size_t consumed = 0;
+
+        auto output = m_output.lock();
+
+        while(m_pcm.size() - consumed >= samplesPerFrame) {
+            void* inPtr = &m_pcm[consumed];
+            int   inId = IN_AUDIO_DATA;
+            int   inSize = int(samplesPerFrame * sizeof(int16_t));
+            int   inElSize = sizeof(int16_t);
+
+            void* outPtr = &m_outputBuffer[0];
+            int   outId = OUT_BITSTREAM_DATA;
+            int   outSize = int(m_outputBuffer.size());
+            int   outElSize = 1;
+
+            AACENC_BufDesc inDesc = { 1, &inPtr, &inId, &inSize, &inElSize };
+            AACENC_BufDesc outDesc = { 1, &outPtr, &outId, &outSize, &outElSize };
+
+            AACENC_InArgs inArgs = { int(samplesPerFrame), 0 };
+            AACENC_OutArgs outArgs = { 0 };
+
+            if(aacEncEncode(m_encoder, &inDesc, &outDesc, &inArgs, &outArgs) != AACENC_OK) {
+                DLog("FDK::AACEncode: encode failed\n");
+                break;
+            }
+            consumed += samplesPerFrame;
+
+            if(output && outArgs.numOutBytes > 0) {
+                AudioBufferMetadata md(m_pcmTimestamp);
+
+                if(!m_sentConfig) {
+                    output->pushBuffer(m_asc, sizeof(m_asc), md);
+                    m_sentConfig = true;
+                }
+                output->pushBuffer(&m_outputBuffer[0], outArgs.numOutBytes, md);
+            }
+            m_pcmTimestamp += frameDuration;
+        }
+        m_pcm.erase(m_pcm.begin(), m_pcm.begin() + consumed);
+    }
+    void
+    AACEncode::setBitrate(int bitrate)
+    {
+        if(m_bitrate != bitrate && m_encoder) {
+            m_bitrate = bitrate;
+            // fdk-aac reconfigures itself on the next aacEncEncode() call.
+            m_encodeQueue.enqueue([=]() {
+                aacEncoder_SetParam(m_encoder, AACENC_BITRATE, bitrate);
+            });
+        }
+    }
+}
+}
@@ -0,0 +1,97 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  FDK::AACEncode transform :: Takes a raw buffer of interleaved 16-bit LPCM input and outputs AAC-LC packets
+ *  using libfdk-aac.  Portable counterpart of iOS::AACEncode for platforms without AudioToolbox.
+ *
+ */
+
+
+#ifndef __videocore__FDKAACEncode__
+#define __videocore__FDKAACEncode__
+
+#include <videocore/transforms/IEncoder.hpp>
+#include <videocore/system/JobQueue.hpp>
+
+#include <fdk-aac/aacenc_lib.h>
+
+#include <atomic>
+#include <vector>
+
+namespace videocore { namespace FDK {
+
+    class AACEncode : public IEncoder
+    {
+    public:
+
+        /*!
+         *  \param frequencyInHz   The sampling rate of the input and output.
+         *  \param channelCount    The number of interleaved input channels (1-6 or 8).
+         *  \param averageBitrate  The target bitrate in bits per second.
+         */
+        AACEncode(int frequencyInHz, int channelCount, int averageBitrate);
+
+        ~AACEncode();
+
+        void setOutput(std::shared_ptr<IOutput> output) { m_output = output; };
+
+        /*!
+         *  Copies the samples and returns immediately.  Encoding happens on the encoder's own queue, so the
+         *  caller (normally the audio mixer thread) is never blocked by the codec.
+         */
+        void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
+
+        void setBitrate(int bitrate);
+        const int bitrate() const { return m_bitrate; };
+
+    private:
+        /*! Encode every complete frame held in m_pcm.  Runs on m_encodeQueue. */
+        void encodePending();
+
+    private:
+
+        JobQueue                m_encodeQueue;
+
+        HANDLE_AACENCODER       m_encoder;
+        std::weak_ptr<IOutput>  m_output;
+
+        std::vector<int16_t>    m_pcm;          /* samples waiting for a complete frame */
+        std::vector<uint8_t>    m_outputBuffer;
+        double                  m_pcmTimestamp; /* timestamp of the first sample in m_pcm, in ms */
+
+        int     m_frequencyInHz;
+        int     m_channelCount;
+        size_t  m_frameLength;
+
+        std::atomic<int> m_bitrate;
+        uint8_t m_asc[2];
+        bool    m_sentConfig;
+    };
+
+}
+}
+#endif /* defined(__videocore__FDKAACEncode__) */
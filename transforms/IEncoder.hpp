@@ -30,6 +30,17 @@
 
 namespace videocore {
     
+    /*! Enum values for the EncodedSliceMetadata tuple */
+    enum {
+        kEncodedSliceMetadataEndOfFrame, /*!< Indicates that the buffer holds the last slice of its frame. */
+    };
+    
+    /*!
+     *  Pushed, in place of VideoBufferMetadata, by video encoders that output each slice as soon as it is coded
+     *  rather than whole frames.  Every slice of a frame carries the frame's pts and dts.
+     */
+    typedef MetaData<'slic', bool> EncodedSliceMetadata;
+    
     class IEncoder : public ITransform
     {
     public:
@@ -38,6 +49,21 @@ namespace videocore {
         virtual void setBitrate(int bitrate) = 0;
         virtual const int bitrate() const = 0;
         
+        /*!
+         *  Make the next frame encoded a keyframe (an IDR frame for H.264) so that decoders can resynchronise,
+         *  for example after the output session dropped data.  Encoders whose every frame can be decoded on its
+         *  own, such as the audio encoders, need not override it.
+         */
+        virtual void requestKeyframe() {};
+        
+        /*!
+         *  Change the size and frame rate of the encoded video without restarting the stream, for example to follow
+         *  an AdaptationLadder.  The next frame encoded is a keyframe with new parameter sets.
+         *
+         *  \return false if the encoder can't change format.  Audio encoders need not override it.
+         */
+        virtual bool setVideoFormat(int width, int height, int fps) { return false; };
+        
     };
     
 }
@@ -30,12 +30,26 @@
 
 namespace videocore
 {
+    /*!
+     *  The queuedDuration() beyond which upstream stages stop producing frames: anything more only adds latency,
+     *  or is thrown away by the session.
+     */
+    static const double kMaxQueuedDuration = 2.;
     
     class IOutput
     {
     public:
         virtual void setEpoch(const std::chrono::steady_clock::time_point epoch) {};
         virtual void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata) = 0;
+        
+        /*!
+         *  The seconds of media pushed to this output, or to anything downstream of it, and not yet sent.  pushBuffer
+         *  doesn't block, so this is how an upstream stage finds out it is producing faster than the output can
+         *  take.  Stages that pass buffers on return their output's value; outputs that never fall behind return 0.
+         *  Safe to call from any thread.
+         */
+        virtual double queuedDuration() { return 0.; };
+        
         virtual ~IOutput() {};
     };
     
@@ -39,6 +39,12 @@ namespace videocore {
      */
     using BandwidthCallback = std::function<void(float rateVector, float estimatedAvailableBandwidth, int immediateThroughput)>;
     
+    /*!
+     *  Called when the session needs the video encoder to produce a keyframe, e.g. after it dropped data or when a
+     *  new connection starts.  Normally wired to IEncoder::requestKeyframe.
+     */
+    using KeyframeRequestCallback = std::function<void()>;
+    
     class IOutputSession : public IOutput
     {
     public:
@@ -46,6 +52,9 @@ namespace videocore {
         virtual void setSessionParameters(IMetadata & parameters) = 0 ;
         virtual void setBandwidthCallback(BandwidthCallback callback) = 0;
         
+        /*! Sessions that never drop data need not override this. */
+        virtual void setKeyframeRequestCallback(KeyframeRequestCallback callback) {};
+        
         virtual ~IOutputSession() {};
         
     };
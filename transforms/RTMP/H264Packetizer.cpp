@@ -25,10 +25,13 @@
 #include <videocore/transforms/RTMP/H264Packetizer.h>
 #include <videocore/rtmp/RTMPTypes.h>
 #include <videocore/rtmp/RTMPSession.h>
+#include <videocore/transforms/IEncoder.hpp>
+
+#include <cstring>
 
 namespace videocore { namespace rtmp {
     
-    H264Packetizer::H264Packetizer( int ctsOffset ) : m_videoTs(0), m_sentConfig(false), m_ctsOffset(ctsOffset)
+    H264Packetizer::H264Packetizer( int ctsOffset ) : m_ctsOffset(ctsOffset), m_sentConfig(false), m_frameOpen(false), m_frameIsKey(false), m_frameDts(0)
     {
         
     }
@@ -37,84 +40,127 @@ namespace videocore { namespace rtmp {
     {
         m_output = output;
     }
+    static inline bool differs(const std::vector<uint8_t>& stored, const uint8_t* nal, size_t size)
+    {
+        return stored.size() != size || memcmp(&stored[0], nal, size) != 0;
+    }
     void H264Packetizer::pushBuffer(const uint8_t* const inBuffer, size_t inSize, IMetadata& inMetadata)
     {
-        std::vector<uint8_t>& outBuffer = m_outbuffer;
-        
-        outBuffer.clear();
+        auto slice = dynamic_cast<EncodedSliceMetadata*>(&inMetadata);
+        const bool endOfFrame = !slice || slice->getData<kEncodedSliceMetadataEndOfFrame>();
         
-        uint8_t nal_type = inBuffer[4] & 0x1F;
-        int flags = 0;
-        const int flags_size = 5;
         int dts = inMetadata.dts ;
         int pts = inMetadata.pts + m_ctsOffset; // correct for pts < dts which some players (ffmpeg) don't like
         
         dts = dts > 0 ? dts : pts - m_ctsOffset ;
         
-        bool is_config = (nal_type == 7 || nal_type == 8);
-        
-        flags = FLV_CODECID_H264;
-        auto output = m_output.lock();
-
-        switch(nal_type) {
-            case 7:
-                if(m_sps.size() == 0) {
-                    m_sps.resize(inSize-4);
-                    memcpy(&m_sps[0], inBuffer+4, inSize-4);
-                }
-                break;
-            case 8:
-                if(m_pps.size() == 0) {
-                    m_pps.resize(inSize-4);
-                    memcpy(&m_pps[0], inBuffer+4, inSize-4);
-                }
-                flags |= FLV_FRAME_KEY;
-                break;
-            case 5:
-                flags |= FLV_FRAME_KEY;
-                
-                break;
-            default:
-                flags |= FLV_FRAME_INTER;
-                
-                
-                break;
-                
+        if(m_frameOpen && dts != m_frameDts) {
+            // The rest of the open frame never came.  Send what there is rather than mix two frames in one tag.
+            pushFrame();
         }
         
+        const uint8_t* p = inBuffer;
+        const uint8_t* const end = inBuffer + inSize;
         
-        if(output) {
+        while(end - p > 4) {
+            const size_t nal_size = (size_t(p[0]) << 24) | (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | size_t(p[3]);
+            const uint8_t* nal = p + 4;
             
-            RTMPMetadata_t outMeta(dts);
-            std::vector<uint8_t> conf;
-            
-            if(is_config && m_sps.size() > 0 && m_pps.size() > 0 ) {
-                conf = configurationFromSpsAndPps();
-                inSize = conf.size();
+            if(nal_size == 0 || nal_size > size_t(end - nal)) {
+                DLog("H264Packetizer: malformed NAL length\n");
+                break;
             }
-            outBuffer.reserve(inSize + flags_size);
+            p = nal + nal_size;
             
-            put_byte(outBuffer, flags);
-            put_byte(outBuffer, !is_config);
-            put_be24(outBuffer, pts - dts);             // Decoder delay
+            const uint8_t nal_type = nal[0] & 0x1F;
             
-            if(is_config) {
-                // create modified SPS/PPS buffer
-                if(m_sps.size() > 0 && m_pps.size() > 0 && !m_sentConfig) {
-                    put_buff(outBuffer, &conf[0], conf.size());
-                    m_sentConfig = true;
-                } else {
-                    return;
-                }
-            } else {
-                put_buff(outBuffer, inBuffer, inSize);
+            switch(nal_type) {
+                case 7:
+                    if(differs(m_sps, nal, nal_size)) {
+                        m_sps.assign(nal, nal + nal_size);
+                        m_sentConfig = false;
+                        
+                        h264::SequenceParameterSet sps;
+                        if(!h264::parseSequenceParameterSet(nal, nal_size, sps)) {
+                            DLog("H264Packetizer: could not parse the SPS\n");
+                        } else if(m_videoFormatCallback) {
+                            m_videoFormatCallback(sps);
+                        }
+                    }
+                    break;
+                case 8:
+                    if(differs(m_pps, nal, nal_size)) {
+                        m_pps.assign(nal, nal + nal_size);
+                        m_sentConfig = false;
+                    }
+                    break;
+                case 9:
+                    // An access unit delimiter starts a new frame.  Players don't need it in an FLV tag.
+                    if(m_frameOpen) {
+                        pushFrame();
+                    }
+                    break;
+                case 12:
+                    // Filler data only pads CBR streams.
+                    break;
+                default:
+                    if(!m_frameOpen) {
+                        // The sequence header goes out ahead of the first frame that uses it, once both parameter
+                        // sets of a change are in.
+                        if(!m_sentConfig && m_sps.size() > 0 && m_pps.size() > 0) {
+                            pushConfiguration(pts, dts);
+                        }
+                        m_outbuffer.clear();
+                        put_byte(m_outbuffer, 0);       // frame type, known once the whole frame is in
+                        put_byte(m_outbuffer, 1);       // AVC NALU
+                        put_be24(m_outbuffer, pts - dts); // Decoder delay
+                        m_frameOpen = true;
+                        m_frameIsKey = false;
+                        m_frameDts = dts;
+                    }
+                    m_frameIsKey |= (nal_type == 5);
+                    put_buff(m_outbuffer, nal - 4, nal_size + 4);
+                    break;
             }
+        }
+        
+        if(m_frameOpen && endOfFrame) {
+            pushFrame();
+        }
+    }
+    void
+    H264Packetizer::pushConfiguration(int pts, int dts)
+    {
+        auto output = m_output.lock();
+        if(output) {
+            std::vector<uint8_t> conf = configurationFromSpsAndPps();
+            std::vector<uint8_t> outBuffer;
             
-            outMeta.setData(dts, static_cast<int>(outBuffer.size()), RTMP_PT_VIDEO, kVideoChannelStreamId, nal_type == 5);
+            outBuffer.reserve(conf.size() + 5);
+            put_byte(outBuffer, FLV_CODECID_H264 | FLV_FRAME_KEY);
+            put_byte(outBuffer, 0);                 // AVC sequence header
+            put_be24(outBuffer, pts - dts);
+            put_buff(outBuffer, &conf[0], conf.size());
             
+            RTMPMetadata_t outMeta(dts);
+            outMeta.setData(dts, static_cast<int>(outBuffer.size()), RTMP_PT_VIDEO, kVideoChannelStreamId, false);
             output->pushBuffer(&outBuffer[0], outBuffer.size(), outMeta);
+            m_sentConfig = true;
         }
+    }
+    void
+    H264Packetizer::pushFrame()
+    {
+        m_frameOpen = false;
         
+        auto output = m_output.lock();
+        if(output) {
+            m_outbuffer[0] = FLV_CODECID_H264 | (m_frameIsKey ? FLV_FRAME_KEY : FLV_FRAME_INTER);
+            
+            RTMPMetadata_t outMeta(m_frameDts);
+            outMeta.setData(m_frameDts, static_cast<int>(m_outbuffer.size()), RTMP_PT_VIDEO, kVideoChannelStreamId, m_frameIsKey);
+            output->pushBuffer(&m_outbuffer[0], m_outbuffer.size(), outMeta);
+        }
     }
     std::vector<uint8_t>
     H264Packetizer::configurationFromSpsAndPps()
@@ -27,11 +27,19 @@
 #define videocore_H264Packetizer_h
 
 #include <videocore/transforms/ITransform.hpp>
+#include <videocore/system/h264/ParameterSets.h>
 
+#include <functional>
 #include <vector>
 
 namespace videocore { namespace rtmp {
     
+    /*!
+     *  Called with the parsed SPS whenever the encoder's SPS changes, including the first one, before anything
+     *  coded with it is pushed.  Use it to update the output session's metadata, e.g. after a resolution change.
+     */
+    using VideoFormatCallback = std::function<void(const h264::SequenceParameterSet& sps)>;
+    
     class H264Packetizer : public ITransform
     {
     public:
@@ -39,8 +47,17 @@ namespace videocore { namespace rtmp {
         H264Packetizer(int ctsOffset=0);
         
     public:
+        /*!
+         *  Input is 4-byte length-prefixed NALs: a whole access unit, the SPS or PPS alone, or with
+         *  EncodedSliceMetadata one slice at a time.  All the NALs of an access unit go out in a single FLV video
+         *  tag once its last one is in.  A new timestamp or an access unit delimiter also ends the access unit.
+         *  Parameter sets go out as the AVC sequence header, again whenever they change; delimiters and filler
+         *  data are dropped.
+         */
         void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
         void setOutput(std::shared_ptr<IOutput> output);
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
+        void setVideoFormatCallback(VideoFormatCallback callback) { m_videoFormatCallback = callback; };
         void setEpoch(const std::chrono::steady_clock::time_point epoch) { m_epoch = epoch; };
         
     private:
@@ -50,14 +67,22 @@ namespace videocore { namespace rtmp {
         std::vector<uint8_t> m_sps;
         std::vector<uint8_t> m_pps;
         std::vector<uint8_t> m_outbuffer;
-        
-        double m_videoTs;
+        VideoFormatCallback  m_videoFormatCallback;
         
         std::vector<uint8_t> configurationFromSpsAndPps();
         
+        /*! Push the AVC sequence header built from m_sps and m_pps. */
+        void pushConfiguration(int pts, int dts);
+        
+        /*! Push the access unit gathered in m_outbuffer as one FLV video tag. */
+        void pushFrame();
+        
         int  m_ctsOffset;
         
-        bool m_sentConfig;
+        bool m_sentConfig;  /* the sequence header for the current m_sps and m_pps has been pushed */
+        bool m_frameOpen;   /* m_outbuffer holds the first NALs of an access unit whose last NAL is still to come */
+        bool m_frameIsKey;
+        int  m_frameDts;
     };
     
 } // rtmp
@@ -0,0 +1,229 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#include <videocore/transforms/ScaleTransform.h>
+#include <videocore/system/WorkerPool.hpp>
+#include <videocore/system/util.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Output buffers that may be in flight downstream before the transform starts dropping frames.
+static const size_t kMaxOutputBuffers = 4;
+
+// Stripes are at least this many rows (even, so stripes own whole chroma rows).
+static const int kMinStripeRows = 32;
+
+namespace videocore {
+
+    ScaleTransform::ScaleTransform(int boundingWidth,
+                                   int boundingHeight,
+                                   AspectTransform::AspectMode aspectMode,
+                                   image::ScaleFilter filter)
+    : m_boundingWidth(boundingWidth),
+    m_boundingHeight(boundingHeight),
+    m_aspectMode(aspectMode),
+    m_filter(filter),
+    m_outputFormat(0),
+    m_matrix(image::kColorMatrixBT709),
+    m_range(image::kColorRangeLimited),
+    m_parallelism(0)
+    {
+    }
+
+    ScaleTransform::~ScaleTransform()
+    {
+    }
+
+    void
+    ScaleTransform::setOutput(std::shared_ptr<IOutput> output)
+    {
+        m_output = output;
+    }
+
+    void
+    ScaleTransform::setBoundingSize(int boundingWidth,
+                                    int boundingHeight)
+    {
+        std::lock_guard<std::mutex> l(m_configMutex);
+        m_boundingWidth = boundingWidth;
+        m_boundingHeight = boundingHeight;
+    }
+
+    void
+    ScaleTransform::setAspectMode(AspectTransform::AspectMode aspectMode)
+    {
+        std::lock_guard<std::mutex> l(m_configMutex);
+        m_aspectMode = aspectMode;
+    }
+
+    void
+    ScaleTransform::setFilter(image::ScaleFilter filter)
+    {
+        std::lock_guard<std::mutex> l(m_configMutex);
+        m_filter = filter;
+    }
+
+    void
+    ScaleTransform::setOutputFormat(PixelBufferFormatType format,
+                                    image::ColorMatrix matrix,
+                                    image::ColorRange range)
+    {
+        std::lock_guard<std::mutex> l(m_configMutex);
+        m_outputFormat = format;
+        m_matrix = matrix;
+        m_range = range;
+    }
+
+    void
+    ScaleTransform::pushBuffer(const uint8_t *const data,
+                               size_t size,
+                               videocore::IMetadata &metadata)
+    {
+        auto output = m_output.lock();
+        if(!output) {
+            return;
+        }
+        auto in = *(std::shared_ptr<IPixelBuffer>*)data;
+        const auto inFormat = in->pixelFormat();
+
+        if(inFormat != kVCPixelBufferFormat32BGRA && inFormat != kVCPixelBufferFormat32RGBA) {
+            DLog("ScaleTransform: only 32-bit input is scaled, passing %08x through\n", inFormat);
+            output->pushBuffer(data, size, metadata);
+            return;
+        }
+
+        int boundingWidth, boundingHeight;
+        AspectTransform::AspectMode aspectMode;
+        image::ScaleFilter filter;
+        PixelBufferFormatType outFormat;
+        image::ColorMatrix matrix;
+        image::ColorRange range;
+        {
+            std::lock_guard<std::mutex> l(m_configMutex);
+            boundingWidth = m_boundingWidth;
+            boundingHeight = m_boundingHeight;
+            aspectMode = m_aspectMode;
+            filter = m_filter;
+            outFormat = m_outputFormat ? m_outputFormat : inFormat;
+            matrix = m_matrix;
+            range = image::rangeForFormat(outFormat, m_range);
+        }
+
+        const int inWidth = in->width(), inHeight = in->height();
+        const float wfac = float(boundingWidth) / inWidth;
+        const float hfac = float(boundingHeight) / inHeight;
+        const float mult = (aspectMode == AspectTransform::kAspectFit ? (wfac < hfac) : (wfac > hfac)) ? wfac : hfac;
+        const int outWidth = std::max(2, int(lroundf(inWidth * mult)) & ~1);
+        const int outHeight = std::max(2, int(lroundf(inHeight * mult)) & ~1);
+
+        if(outWidth == inWidth && outHeight == inHeight && outFormat == inFormat) {
+            output->pushBuffer(data, size, metadata);
+            return;
+        }
+
+        const bool fused = image::isYUVFormat(outFormat);
+        if(!fused && outFormat != inFormat) {
+            DLog("ScaleTransform: unsupported output format %08x\n", outFormat);
+            return;
+        }
+
+        if(!m_scaler || m_scaler->srcWidth() != inWidth || m_scaler->srcHeight() != inHeight ||
+           m_scaler->dstWidth() != outWidth || m_scaler->dstHeight() != outHeight || m_scaler->filter() != filter) {
+            m_scaler.reset(new image::Scaler(inWidth, inHeight, outWidth, outHeight, filter));
+        }
+
+        if(!m_pool || m_pool->width() != outWidth || m_pool->height() != outHeight || m_pool->pixelFormat() != outFormat) {
+            m_pool.reset(new PixelBufferPool(outWidth, outHeight, outFormat, kMaxOutputBuffers));
+        }
+        auto out = m_pool->dequeue();
+        if(!out) {
+            DLog("ScaleTransform: all output buffers are in use, dropping frame\n");
+            return;
+        }
+
+        auto & pool = WorkerPool::shared();
+        const size_t threads = std::min(m_parallelism ? m_parallelism.load() : pool.threadCount() + 1, pool.threadCount() + 1);
+        const int stripes = std::max(1, std::min(int(threads), outHeight / kMinStripeRows));
+        const int rowsPerStripe = ((outHeight + stripes - 1) / stripes + 1) & ~1;
+
+        if(m_scratch.size() < size_t(stripes)) {
+            m_scratch.resize(stripes);
+            m_rowPairs.resize(stripes);
+        }
+        for ( int i = 0 ; i < stripes ; ++i ) {
+            m_scratch[i].resize(m_scaler->scratchSize());
+            if(fused) {
+                m_rowPairs[i].resize(size_t(outWidth) * 4 * 2);
+            }
+        }
+
+        in->lock(true);
+        out->lock();
+
+        const uint8_t* src = (const uint8_t*)in->baseAddress();
+        const size_t srcStride = in->bytesPerRowOfPlane(0);
+        uint8_t* dst = (uint8_t*)out->baseAddress();
+        const size_t dstStride = out->bytesPerRowOfPlane(0);
+
+        image::YUVPlanes planes;
+        if(fused) {
+            image::planesForBuffer(*out, planes);
+        }
+        const bool rgba = (inFormat == kVCPixelBufferFormat32RGBA);
+        const image::Scaler& scaler = *m_scaler;
+
+        pool.parallelFor(stripes, threads, [&](size_t i) {
+            const int rowBegin = int(i) * rowsPerStripe;
+            const int rowEnd = std::min(outHeight, rowBegin + rowsPerStripe);
+            int16_t* scratch = &m_scratch[i][0];
+
+            if(!fused) {
+                scaler.scale(src, srcStride, dst, dstStride, rowBegin, rowEnd, scratch);
+                return;
+            }
+            // Scale two rows at a time and convert them while they are still in cache.
+            uint8_t* pair = &m_rowPairs[i][0];
+            const size_t pairStride = size_t(outWidth) * 4;
+            for ( int row = rowBegin ; row < rowEnd ; row += 2 ) {
+                const int rows = std::min(2, outHeight - row);
+                for ( int r = 0 ; r < rows ; ++r ) {
+                    scaler.scaleRow(src, srcStride, row + r, pair + r * pairStride, scratch);
+                }
+                image::YUVPlanes p = planes;
+                p.y += row * planes.yStride;
+                p.u += (row / 2) * planes.uStride;
+                p.v += (row / 2) * planes.vStride;
+                image::rgbToYUV(pair, pairStride, rgba, outWidth, rows, 0, rows, p, matrix, range);
+            }
+        });
+
+        out->unlock();
+        in->unlock(true);
+
+        out->setState(kVCPixelBufferStateEnqueued);
+        output->pushBuffer((const uint8_t*)&out, sizeof(out), metadata);
+    }
+}
@@ -0,0 +1,150 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+#ifndef __videocore__ScaleTransform__
+#define __videocore__ScaleTransform__
+
+#include <videocore/transforms/ITransform.hpp>
+#include <videocore/transforms/AspectTransform.h>
+#include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
+#include <videocore/system/pixelBuffer/PixelBufferPool.h>
+#include <videocore/system/image/Scale.h>
+#include <videocore/system/image/ColorConvert.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+
+namespace videocore {
+
+    /*!
+     *  Resamples 32-bit BGRA/RGBA pixel buffers on the CPU.  Where AspectTransform only tells the compositor how to
+     *  scale a source, this transform produces pixels at the size the source will be drawn, so it can sit right
+     *  after a source to keep full-size frames out of the rest of the graph.
+     *
+     *  The output size follows AspectTransform's rules for the bounding box, rounded to even dimensions.  When an
+     *  output YUV format is set, the scaled rows are converted to 4:2:0 in the same pass, so the 32-bit
+     *  frame at the output size is never written out in full.
+     *
+     *  Input and output are pushed as a pointer to a std::shared_ptr<IPixelBuffer>; the metadata is passed through.
+     */
+    class ScaleTransform : public ITransform
+    {
+    public:
+        /*! Constructor.
+         *
+         *  \param boundingWidth  The width of the bounding box.
+         *  \param boundingHeight The height of the bounding box.
+         *  \param aspectMode     How the source fits the bounding box.
+         *  \param filter         The resampling filter.
+         */
+        ScaleTransform(int boundingWidth,
+                       int boundingHeight,
+                       AspectTransform::AspectMode aspectMode = AspectTransform::kAspectFit,
+                       image::ScaleFilter filter = image::kScaleFilterBilinear);
+
+        /*! Destructor */
+        ~ScaleTransform();
+
+        /*!
+         *  Change the size of the target bounding box.
+         *
+         *  \param boundingWidth  The width of the bounding box.
+         *  \param boundingHeight The height of the bounding box.
+         */
+        void setBoundingSize(int boundingWidth,
+                             int boundingHeight);
+
+        /*!
+         *  Change the aspect mode
+         *
+         *  \param aspectMode The aspectMode to use.
+         */
+        void setAspectMode(AspectTransform::AspectMode aspectMode);
+
+        /*!
+         *  Change the resampling filter.
+         *
+         *  \param filter The filter to use.
+         */
+        void setFilter(image::ScaleFilter filter);
+
+        /*!
+         *  Convert the scaled output to YUV in the same pass.
+         *
+         *  \param format  kCVPixelBufferFormat420v, kVCPixelBufferFormat420f or kVCPixelBufferFormatI420, or 0 to
+         *                 output the input's format.
+         *  \param matrix  The YUV colour matrix.
+         *  \param range   The YUV range for I420.  NV12 takes its range from the format.
+         */
+        void setOutputFormat(PixelBufferFormatType format,
+                             image::ColorMatrix matrix = image::kColorMatrixBT709,
+                             image::ColorRange range = image::kColorRangeLimited);
+
+        /*!
+         *  Set the number of threads used per frame.  Rows are scaled in stripes on WorkerPool::shared().
+         *
+         *  \param threadCount  The maximum number of threads, including the calling thread.  0 uses every core.
+         */
+        void setParallelism(size_t threadCount) { m_parallelism = threadCount; };
+
+    public:
+
+        /*! ITransform::setOutput */
+        void setOutput(std::shared_ptr<IOutput> output);
+
+        /*! IOutput::queuedDuration */
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
+
+        /*! IOutput::pushBuffer */
+        void pushBuffer(const uint8_t* const data,
+                        size_t size,
+                        IMetadata& metadata);
+
+    private:
+
+        std::weak_ptr<IOutput> m_output;
+
+        std::unique_ptr<image::Scaler>              m_scaler;
+        std::vector<std::vector<int16_t>>           m_scratch;       /* one per stripe */
+        std::vector<std::vector<uint8_t>>           m_rowPairs;      /* one per stripe, fused conversion only */
+        std::unique_ptr<PixelBufferPool>            m_pool;
+
+        std::mutex m_configMutex;   /* guards the settings below */
+
+        int m_boundingWidth;
+        int m_boundingHeight;
+        AspectTransform::AspectMode m_aspectMode;
+        image::ScaleFilter          m_filter;
+        PixelBufferFormatType       m_outputFormat;
+        image::ColorMatrix          m_matrix;
+        image::ColorRange           m_range;
+
+        std::atomic<size_t>         m_parallelism;
+    };
+}
+
+#endif /* defined(__videocore__ScaleTransform__) */
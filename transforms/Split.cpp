@@ -29,6 +29,8 @@
  */
 #include <videocore/transforms/Split.h>
 
+#include <algorithm>
+
 namespace videocore {
     Split::Split() {}
     Split::~Split() {}
@@ -36,6 +38,7 @@ namespace videocore {
     void
     Split::setOutput(std::shared_ptr<IOutput> output)
     {
+        std::lock_guard<std::mutex> l(m_mutex);
         const auto inHash = std::hash<std::shared_ptr<IOutput>>()(output);
         bool duplicate = false;
         for ( auto & it : m_outputs) {
@@ -52,6 +55,7 @@ namespace videocore {
     void
     Split::removeOutput(std::shared_ptr<IOutput> output)
     {
+        std::lock_guard<std::mutex> l(m_mutex);
         const auto inHash = std::hash<std::shared_ptr<IOutput>>()(output);
         
         auto it = std::remove_if(m_outputs.begin(), m_outputs.end(), [=](const std::weak_ptr<IOutput>& rhs) {
@@ -67,11 +71,34 @@ namespace videocore {
     void
     Split::pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
     {
+        // Push outside the lock so an output may add or remove outputs from its pushBuffer.
+        for ( auto & outp : lockedOutputs() ) {
+            outp->pushBuffer(data, size, metadata);
+        }
+    }
+    double
+    Split::queuedDuration()
+    {
+        double duration = -1.;
+        for ( auto & outp : lockedOutputs() ) {
+            const double queued = outp->queuedDuration();
+            duration = duration < 0. ? queued : std::min(duration, queued);
+        }
+        return std::max(duration, 0.);
+    }
+    std::vector<std::shared_ptr<IOutput>>
+    Split::lockedOutputs()
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        
+        std::vector<std::shared_ptr<IOutput>> outputs;
+        outputs.reserve(m_outputs.size());
         for ( auto & it : m_outputs ) {
             auto outp = it.lock();
             if(outp) {
-                outp->pushBuffer(data, size, metadata);
+                outputs.push_back(std::move(outp));
             }
         }
+        return outputs;
     }
 }
\ No newline at end of file
@@ -34,6 +34,7 @@
 #include <iostream>
 #include <videocore/transforms/ITransform.hpp>
 #include <vector>
+#include <mutex>
 
 namespace videocore {
     
@@ -47,9 +48,19 @@ namespace videocore {
         void removeOutput(std::shared_ptr<IOutput> output);
         void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
         
+        /*!
+         *  The least of the outputs' queued durations: a buffer is worth producing while any output can take it.  An
+         *  output that has fallen behind (e.g. an encoder in front of a congested connection) skips buffers itself,
+         *  so a preview beside it keeps running.
+         */
+        double queuedDuration();
+        
     private:
+        /*! The live outputs, taken under m_mutex. */
+        std::vector<std::shared_ptr<IOutput>> lockedOutputs();
         
         std::vector<std::weak_ptr<IOutput>> m_outputs;
+        std::mutex                          m_mutex;
         
     };
     
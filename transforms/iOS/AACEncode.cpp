@@ -23,10 +23,15 @@
  
  */
 #include <videocore/transforms/iOS/AACEncode.h>
+#include <videocore/mixers/IAudioMixer.hpp>
 #include <sstream>
 
 namespace videocore { namespace iOS {
     
+    // Number of consecutive silent frames the encoder must have consumed before its output is
+    // treated as steady-state silence and reused.  Covers the encoder's delay and MDCT overlap.
+    static const size_t kSilentFramesBeforeReuse = 4;
+    
     Boolean IsAACHardwareEncoderAvailable(void)
     {
         Boolean isAvailable = false;
@@ -81,11 +86,14 @@ namespace videocore { namespace iOS {
 //    }
 
     AACEncode::AACEncode(int frequencyInHz, int channelCount, int bitrate)
-    : m_sentConfig(false), m_bitrate(bitrate)
+    : m_sentConfig(false), m_bitrate(bitrate), m_silentFrameCount(0)
     {
         
         OSStatus result = 0;
         
+        m_audioConverter = nullptr;
+        m_bytesPerSample = 2 * channelCount;
+        
         AudioStreamBasicDescription in = {0}, out = {0};
         
         
@@ -132,7 +140,15 @@ namespace videocore { namespace iOS {
             }
         };
         
-        result = AudioConverterNewSpecific(&in, &out, 2, requestedCodecs, &m_audioConverter);
+        if(channelCount < 1 || channelCount == 7 || channelCount > 8) {
+            // The AudioSpecificConfig has a channel configuration for 1-6 and 8 channels only; anything else needs a
+            // program config element, which we don't write.
+            DLog("iOS::AACEncode: unsupported channel count %d\n", channelCount);
+            result = kAudio_ParamError;
+        }
+        if(result == noErr) {
+            result = AudioConverterNewSpecific(&in, &out, 2, requestedCodecs, &m_audioConverter);
+        }
 
         
         if(result == noErr) {
@@ -147,8 +163,6 @@ namespace videocore { namespace iOS {
         if(result == noErr) {
             m_outputPacketMaxSize = outputPacketSize;
             
-            m_bytesPerSample = 2 * channelCount;
-            
             uint8_t sampleRateIndex = 0;
             switch(frequencyInHz) {
                 case 96000:
@@ -200,14 +214,18 @@ namespace videocore { namespace iOS {
     }
     AACEncode::~AACEncode() {
         
-        AudioConverterDispose(m_audioConverter);
+        if(m_audioConverter) {
+            AudioConverterDispose(m_audioConverter);
+        }
     }
     void
     AACEncode::makeAsc(uint8_t sampleRateIndex, uint8_t channelCount)
     {
         // http://wiki.multimedia.cx/index.php?title=MPEG-4_Audio#Audio_Specific_Config
         m_asc[0] = 0x10 | ((sampleRateIndex>>1) & 0x3);
-        m_asc[1] = ((sampleRateIndex & 0x1)<<7) | ((channelCount & 0xF) << 3);
+        // channelConfiguration 1-6 match the channel count, 7 is 7.1 (8 channels).  The constructor rejects 7 channels.
+        const uint8_t channelConfig = (channelCount == 8 ? 7 : channelCount);
+        m_asc[1] = ((sampleRateIndex & 0x1)<<7) | ((channelConfig & 0xF) << 3);
     }
     OSStatus
     AACEncode::ioProc(AudioConverterRef audioConverter, UInt32 *ioNumDataPackets, AudioBufferList* ioData, AudioStreamPacketDescription** ioPacketDesc, void* inUserData )
@@ -227,6 +245,9 @@ namespace videocore { namespace iOS {
     void
     AACEncode::pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
     {
+        if(!m_audioConverter) {
+            return;
+        }
         const size_t sampleCount = size / m_bytesPerSample;
         const size_t aac_packet_count = sampleCount / kSamplesPerFrame;
         const size_t required_bytes = aac_packet_count * m_outputPacketMaxSize;
@@ -237,7 +258,17 @@ namespace videocore { namespace iOS {
         uint8_t* p = m_outputBuffer();
         uint8_t* p_out = (uint8_t*)data;
         
+        const bool silent = metadata.type() == 'soun' && static_cast<AudioBufferMetadata&>(metadata).getData<kAudioMetadataSilent>();
+        
         for ( size_t i = 0 ; i < aac_packet_count ; ++i ) {
+            if(silent && m_silentFrameCount >= kSilentFramesBeforeReuse && !m_silentPacket.empty()) {
+                // The encoder is in steady-state silence; repeat its last silent packet instead of running it.
+                memcpy(p, &m_silentPacket[0], m_silentPacket.size());
+                p += m_silentPacket.size();
+                p_out += kSamplesPerFrame * m_bytesPerSample;
+                continue;
+            }
+            
             UInt32 num_packets = 1;
             
             AudioBufferList l;
@@ -255,6 +286,14 @@ namespace videocore { namespace iOS {
             AudioConverterFillComplexBuffer(m_audioConverter, AACEncode::ioProc, ud.get(), &num_packets, &l, output_packet_desc);
             m_converterMutex.unlock();
             
+            if(silent) {
+                if(++m_silentFrameCount == kSilentFramesBeforeReuse) {
+                    m_silentPacket.assign(p, p + output_packet_desc[0].mDataByteSize);
+                }
+            } else {
+                m_silentFrameCount = 0;
+            }
+            
             p += output_packet_desc[0].mDataByteSize;
             p_out += kSamplesPerFrame * m_bytesPerSample;
         }
@@ -274,7 +313,7 @@ namespace videocore { namespace iOS {
     void
     AACEncode::setBitrate(int bitrate)
     {
-        if(m_bitrate != bitrate) {
+        if(m_bitrate != bitrate && m_audioConverter) {
             m_converterMutex.lock();
             UInt32 br = bitrate;
             AudioConverterDispose(m_audioConverter);
@@ -294,6 +333,10 @@ namespace videocore { namespace iOS {
             };
             AudioConverterNewSpecific(&m_in, &m_out, 2,requestedCodecs, &m_audioConverter);
             OSStatus result = AudioConverterSetProperty(m_audioConverter, kAudioConverterEncodeBitRate, sizeof(br), &br);
+            
+            // The cached silent packet was produced at the old bitrate.
+            m_silentFrameCount = 0;
+            m_silentPacket.clear();
             UInt32 propSize = sizeof(br);
             
             if(result == noErr) {
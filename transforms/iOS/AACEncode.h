@@ -37,6 +37,7 @@
 #include <videocore/transforms/IEncoder.hpp>
 #include <AudioToolbox/AudioToolbox.h>
 #include <videocore/system/Buffer.hpp>
+#include <vector>
 
 namespace videocore { namespace iOS {
 
@@ -73,6 +74,9 @@ namespace videocore { namespace iOS {
         uint8_t m_asc[2];
         bool    m_sentConfig;
 
+        size_t               m_silentFrameCount;
+        std::vector<uint8_t> m_silentPacket;
+
     };
 
 }
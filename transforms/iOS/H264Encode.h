@@ -37,6 +37,7 @@
 #include <videocore/system/JobQueue.hpp>
 #include <videocore/system/Buffer.hpp>
 #include <deque>
+#include <atomic>
 
 namespace videocore { namespace iOS {
  
@@ -47,6 +48,7 @@ namespace videocore { namespace iOS {
         ~H264Encode();
         
         void setOutput(std::shared_ptr<IOutput> output) { m_output = output; };
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
         
         // Input is expecting a CVPixelBufferRef
         void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
@@ -57,6 +59,12 @@ namespace videocore { namespace iOS {
         
         const int bitrate() const { return m_bitrate; };
         
+        /*!
+         *  IEncoder::requestKeyframe.  Each asset writer starts its movie with an IDR frame, so this switches to the
+         *  standby writer after the next frame, as setBitrate does.
+         */
+        void requestKeyframe() { m_forceKeyframe = true; };
+        
     private:
         bool setupWriters();
         bool setupWriter(int writer);
@@ -93,6 +101,7 @@ namespace videocore { namespace iOS {
         int                    m_bitrate;
 
         bool                   m_currentWriter;
+        std::atomic<bool>      m_forceKeyframe;
     };
 }
 }
@@ -23,7 +23,8 @@
  
  */
 #include <videocore/transforms/iOS/H264Encode.h>
-#include <videocore/system/h264/Golomb.h>
+#include <videocore/system/h264/BitReader.h>
+#include <videocore/mixers/IVideoMixer.hpp>
 
 #import <Foundation/Foundation.h>
 #import <AVFoundation/AVFoundation.h>
@@ -34,7 +35,7 @@ namespace videocore { namespace iOS {
     
     H264Encode::H264Encode( int frame_w, int frame_h, int fps, int bitrate )
     : m_lastFilePos(0), m_frameCount(0), m_frameW(frame_w), m_frameH(frame_h), m_fps(fps),  m_bitrate(bitrate), m_currentWriter(0),
-    m_queue("com.videcore.h264.7")
+    m_queue("com.videcore.h264.7"), m_forceKeyframe(false)
     {
         m_tmpFile[0] = [[NSTemporaryDirectory() stringByAppendingString:@"tmp1.mov"] UTF8String];
         m_tmpFile[1] = [[NSTemporaryDirectory() stringByAppendingString:@"tmp2.mov"] UTF8String];
@@ -218,7 +219,7 @@ namespace videocore { namespace iOS {
                     uint16_t sps_size = *((uint16_t*)p);
                     sps_size = __builtin_bswap16(sps_size);
                     p += 2 ; // move pointer as we have just read sps size
-                    *(int*)(p-4) = sps_size;
+                    *(int*)(p-4) = __builtin_bswap32(sps_size);   // big-endian length prefix
                     m_sps.resize(sps_size+4);
                     m_sps.put(p-4, sps_size+4);
                     p += sps_size;
@@ -226,7 +227,7 @@ namespace videocore { namespace iOS {
                     uint16_t pps_size = *((uint16_t*)p);
                     p+= 2;
                     pps_size = __builtin_bswap16(pps_size);
-                    *(int*)(p-4) = pps_size;
+                    *(int*)(p-4) = __builtin_bswap32(pps_size);
                     m_pps.resize(pps_size+4);
                     m_pps.put(p-4, pps_size+4);
 
@@ -241,22 +242,13 @@ namespace videocore { namespace iOS {
     bool
     H264Encode::isFirstSlice(uint8_t *nalu, size_t size)
     {
-        int ret = 0;
-        uint8_t* bytes = nalu;
-        uint8_t type = bytes[0] & 0x1F;
+        uint32_t ret = 0;
+        uint8_t type = nalu[0] & 0x1F;
         
-        if(type <= 5)
+        if(type <= 5 && size > 1)
         {
-            h264::WORD* toswap = (h264::WORD*)(bytes+1);
-            h264::WORD swapped[4] = {
-                h264::swap(toswap[0]),
-                h264::swap(toswap[1]),
-                h264::swap(toswap[2]),
-                h264::swap(toswap[3])
-            };
-            
-            h264::GolombDecode decode(&swapped[0]);
-            ret = decode.unsignedDecode();  // first_mb_in_slice
+            h264::BitReader reader(nalu + 1, size - 1);
+            ret = reader.readUE();  // first_mb_in_slice
         }
         return (ret == 0);
     }
@@ -269,9 +261,12 @@ namespace videocore { namespace iOS {
         if(m_frameQueue.size() > 0 && output) {
             auto & nal = m_frameQueue.front();
             
+            // The incoming metadata describes the mixer's frame; downstream expects encoded video ('vide').
+            videocore::VideoBufferMetadata md(metadata.pts, metadata.dts);
+            
             if(((*nal)()[4] & 0x1F) == 5) {
-                output->pushBuffer(m_sps(), m_sps.size(), metadata);
-                output->pushBuffer(m_pps(), m_pps.size(), metadata);
+                output->pushBuffer(m_sps(), m_sps.size(), md);
+                output->pushBuffer(m_pps(), m_pps.size(), md);
             }
             bool isfirst = false;
             std::vector<uint8_t> outBuff;
@@ -286,7 +281,7 @@ namespace videocore { namespace iOS {
                     break;
                 }
             }
-            output->pushBuffer(&outBuff[0], outBuff.size(), metadata);
+            output->pushBuffer(&outBuff[0], outBuff.size(), md);
         }
     }
     void
@@ -295,6 +290,11 @@ namespace videocore { namespace iOS {
         
         releaseFrame(metadata); // Send the next queued frame
         
+        if(queuedDuration() > kMaxQueuedDuration) {
+            // The session can't send what it already has; encoding more only adds to the backlog.
+            return;
+        }
+        
         @autoreleasepool {
             
             CVPixelBufferRef pb = (CVPixelBufferRef)(const_cast<uint8_t*>(data));
@@ -377,7 +377,8 @@ namespace videocore { namespace iOS {
                 fclose(fp);
             }
             
-            swapWriters();
+            // A forced swap needs the parameter sets, which the first writer only provides once it finishes.
+            swapWriters(m_sps.size() && m_pps.size() && m_forceKeyframe.exchange(false));
             
         }
         
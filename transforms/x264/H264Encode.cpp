@@ -0,0 +1,335 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+#include <videocore/transforms/x264/H264Encode.h>
+#include <videocore/mixers/IVideoMixer.hpp>
+#include <videocore/system/util.h>
+
+#include <algorithm>
+
+namespace videocore { namespace x264 {
+
+    // Frames allowed to wait for the encoder before new ones are dropped.  Anything more only adds latency.
+    static const int kMaxPendingFrames = 2;
+
+    // The rate control buffer, in seconds of the target bitrate.  Short, so a bitrate change is felt at once.
+    static const double kVBVBufferSeconds = 0.5;
+
+    // Unchanged frames encoded normally, so that rate control can refine a static picture, before they are
+    // replaced by all-skip repeat frames.
+    static const int kUnchangedFramesBeforeRepeat = 4;
+
+    // The highest quantizer allowed for 8-bit H.264.
+    static const int kRepeatFrameQP = 51;
+
+    // Slices per frame with slice output, so that a frame comes out in parts even with a single slice thread.
+    static const int kSlicesPerFrame = 4;
+
+    H264Encode::H264Encode(int frame_w, int frame_h, int fps, int bitrate, bool useBaseline, int threadCount, bool sliceOutput)
+    : m_encodeQueue("com.videocore.x264", kJobQueuePriorityHigh),
+    m_encoder(nullptr),
+    m_unchangedFrames(0),
+    m_nextSliceMb(0),
+    m_frameMbs(0),
+    m_slicePts(0.),
+    m_pendingFrames(0),
+    m_bitrate(bitrate),
+    m_forceKeyframe(false)
+    {
+        x264_param_default_preset(&m_params, "veryfast", "zerolatency");
+
+        m_params.i_log_level = X264_LOG_ERROR;
+        m_params.i_width = frame_w;
+        m_params.i_height = frame_h;
+        m_params.i_csp = X264_CSP_I420;
+        m_params.i_threads = threadCount > 0 ? threadCount : X264_THREADS_AUTO;
+        m_params.b_sliced_threads = 1;
+
+        // Timestamps are in milliseconds and frames may be dropped upstream.
+        m_params.i_fps_num = fps;
+        m_params.i_fps_den = 1;
+        m_params.i_timebase_num = 1;
+        m_params.i_timebase_den = 1000;
+        m_params.b_vfr_input = 1;
+
+        m_params.i_keyint_max = fps * 2; // 2-second kfi, as Apple::H264Encode
+        m_params.b_repeat_headers = 0;
+        m_params.b_annexb = 0;
+        m_params.b_aud = 0;
+
+        if(sliceOutput) {
+            m_params.nalu_process = &H264Encode::sliceCallback;
+            m_params.i_slice_count = kSlicesPerFrame;
+        }
+
+        setRateControl(bitrate);
+
+        if(x264_param_apply_profile(&m_params, useBaseline ? "baseline" : "main") < 0) {
+            DLog("x264::H264Encode: could not apply profile\n");
+        }
+
+        openEncoder();
+    }
+    H264Encode::~H264Encode()
+    {
+        m_encodeQueue.mark_exiting();
+        m_encodeQueue.enqueue_sync([]() {});
+
+        if(m_encoder) {
+            x264_encoder_close(m_encoder);
+        }
+    }
+    void
+    H264Encode::openEncoder()
+    {
+        m_frameMbs = ((m_params.i_width + 15) / 16) * ((m_params.i_height + 15) / 16);
+        m_sps.clear();
+        m_pps.clear();
+
+        m_encoder = x264_encoder_open(&m_params);
+
+        if(!m_encoder) {
+            DLog("x264::H264Encode: failed to create the encoder\n");
+            return;
+        }
+        // Keep the parameters the encoder actually settled on, so reconfiguring starts from them.
+        x264_encoder_parameters(m_encoder, &m_params);
+
+        x264_nal_t* nals = nullptr;
+        int nalCount = 0;
+        if(x264_encoder_headers(m_encoder, &nals, &nalCount) >= 0) {
+            for ( int i = 0 ; i < nalCount ; ++i ) {
+                if(nals[i].i_type == NAL_SPS) {
+                    m_sps.assign(nals[i].p_payload, nals[i].p_payload + nals[i].i_payload);
+                } else if(nals[i].i_type == NAL_PPS) {
+                    m_pps.assign(nals[i].p_payload, nals[i].p_payload + nals[i].i_payload);
+                }
+            }
+        }
+    }
+    void
+    H264Encode::setRateControl(int bitrate)
+    {
+        const int kbps = std::max(1, bitrate / 1000);
+
+        m_params.rc.i_rc_method = X264_RC_ABR;
+        m_params.rc.i_bitrate = kbps;
+        m_params.rc.i_vbv_max_bitrate = kbps;
+        m_params.rc.i_vbv_buffer_size = std::max(1, int(kbps * kVBVBufferSeconds));
+    }
+    void
+    H264Encode::pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata)
+    {
+        // m_encoder is only read on the encode queue, where setVideoFormat() replaces it; encode() checks it.
+        auto buffer = *(std::shared_ptr<IPixelBuffer>*)data;
+        const auto format = buffer->pixelFormat();
+
+        if(format != kVCPixelBufferFormatI420 && format != kVCPixelBufferFormat420f && format != kCVPixelBufferFormat420v) {
+            DLog("x264::H264Encode: unsupported pixel format\n");
+            return;
+        }
+        if(m_pendingFrames >= kMaxPendingFrames) {
+            DLog("x264::H264Encode: encoder is behind, dropping frame\n");
+            return;
+        }
+        if(queuedDuration() > kMaxQueuedDuration) {
+            // The session can't send what it already has; encoding more only adds to the backlog.
+            return;
+        }
+        auto frame = dynamic_cast<VideoFrameMetadata*>(&metadata);
+        const bool unchanged = frame && frame->getData<kVideoFrameMetadataUnchanged>();
+        const double pts = metadata.pts;
+
+        ++m_pendingFrames;
+        m_encodeQueue.enqueue([=]() {
+            this->encode(*buffer, pts, unchanged);
+            --m_pendingFrames;
+        });
+    }
+    void
+    H264Encode::encode(IPixelBuffer& buffer, double pts, bool unchanged)
+    {
+        if(!m_encoder) {
+            return;
+        }
+        if(buffer.width() != m_params.i_width || buffer.height() != m_params.i_height) {
+            // Expected for a frame or two while the scaler catches up with setVideoFormat().
+            DLog("x264::H264Encode: frame size does not match the encoder\n");
+            return;
+        }
+        x264_picture_t in, out;
+        x264_picture_init(&in);
+
+        buffer.lock(true);
+
+        const bool planar = buffer.pixelFormat() == kVCPixelBufferFormatI420;
+        in.img.i_csp = planar ? X264_CSP_I420 : X264_CSP_NV12;
+        in.img.i_plane = planar ? 3 : 2;
+        for ( int i = 0 ; i < in.img.i_plane ; ++i ) {
+            in.img.plane[i] = (uint8_t*)buffer.baseAddressOfPlane(i);
+            in.img.i_stride[i] = int(buffer.bytesPerRowOfPlane(i));
+        }
+        in.i_pts = int64_t(pts);
+        in.opaque = this;
+
+        m_unchangedFrames = unchanged ? m_unchangedFrames + 1 : 0;
+
+        if(m_forceKeyframe.exchange(false)) {
+            in.i_type = X264_TYPE_IDR;
+        } else if(m_unchangedFrames > kUnchangedFramesBeforeRepeat) {
+            // Nothing to code: the highest quantizer makes every macroblock a skip, costing a few bytes.
+            in.i_type = X264_TYPE_P;
+            in.i_qpplus1 = kRepeatFrameQP + 1;
+        }
+
+        if(m_params.nalu_process) {
+            // The slice threads only run inside x264_encoder_encode, so this needs no lock.
+            m_slices.clear();
+            m_nextSliceMb = 0;
+            m_slicePts = pts;
+        }
+
+        x264_nal_t* nals = nullptr;
+        int nalCount = 0;
+        const int frameSize = x264_encoder_encode(m_encoder, &nals, &nalCount, &in, &out);
+
+        buffer.unlock(true);
+
+        if(frameSize < 0) {
+            DLog("x264::H264Encode: encode failed\n");
+            return;
+        }
+        if(m_params.nalu_process) {
+            // Every slice has already been pushed by sliceCallback; x264 does not return the NALs again.
+            return;
+        }
+        auto output = m_output.lock();
+        if(!output || frameSize == 0) {
+            return;
+        }
+
+        // Payloads are already prefixed with their big-endian length.  Only the slices are forwarded; the
+        // parameter sets are sent separately and the encoder's SEI is of no use downstream.
+        m_frame.clear();
+        for ( int i = 0 ; i < nalCount ; ++i ) {
+            if(nals[i].i_type == NAL_SLICE || nals[i].i_type == NAL_SLICE_IDR) {
+                m_frame.insert(m_frame.end(), nals[i].p_payload, nals[i].p_payload + nals[i].i_payload);
+            }
+        }
+        if(m_frame.empty()) {
+            return;
+        }
+        VideoBufferMetadata md(double(out.i_pts), double(out.i_dts));
+
+        if(out.b_keyframe && !m_sps.empty() && !m_pps.empty()) {
+            output->pushBuffer(&m_sps[0], m_sps.size(), md);
+            output->pushBuffer(&m_pps[0], m_pps.size(), md);
+        }
+        output->pushBuffer(&m_frame[0], m_frame.size(), md);
+    }
+    void
+    H264Encode::sliceCallback(x264_t* h, x264_nal_t* nal, void* opaque)
+    {
+        static_cast<H264Encode*>(opaque)->pushSlice(h, nal);
+    }
+    void
+    H264Encode::pushSlice(x264_t* h, x264_nal_t* nal)
+    {
+        if(nal->i_type != NAL_SLICE && nal->i_type != NAL_SLICE_IDR) {
+            return;
+        }
+        // Escape and length-prefix the slice into a buffer of the size x264 asks for.
+        std::vector<uint8_t> slice(nal->i_payload * 3 / 2 + 5 + 64);
+        x264_nal_encode(h, &slice[0], nal);
+        slice.resize(nal->i_payload);
+
+        auto output = m_output.lock();
+
+        // Slice threads finish in any order but downstream needs the slices of a frame in order, and the lock
+        // also serialises the calls into the output.
+        std::lock_guard<std::mutex> l(m_sliceMutex);
+
+        m_slices[nal->i_first_mb] = std::make_pair(nal->i_last_mb, std::move(slice));
+
+        while(!m_slices.empty() && m_slices.begin()->first == m_nextSliceMb) {
+            const int lastMb = m_slices.begin()->second.first;
+            const std::vector<uint8_t>& next = m_slices.begin()->second.second;
+
+            if(output) {
+                if(m_nextSliceMb == 0 && (next[4] & 0x1F) == NAL_SLICE_IDR && !m_sps.empty() && !m_pps.empty()) {
+                    VideoBufferMetadata md(m_slicePts, m_slicePts);
+                    output->pushBuffer(&m_sps[0], m_sps.size(), md);
+                    output->pushBuffer(&m_pps[0], m_pps.size(), md);
+                }
+                EncodedSliceMetadata md(m_slicePts, m_slicePts); // no B-frames, so dts == pts
+                md.setData(lastMb >= m_frameMbs - 1);
+                output->pushBuffer(&next[0], next.size(), md);
+            }
+            m_nextSliceMb = lastMb + 1;
+            m_slices.erase(m_slices.begin());
+        }
+    }
+    void
+    H264Encode::setBitrate(int bitrate)
+    {
+        if(m_bitrate == bitrate) {
+            return;
+        }
+        m_bitrate = bitrate;
+
+        // Queued ahead of any frame pushed after this call; x264 applies rate control changes to the next frame.
+        m_encodeQueue.enqueue([=]() {
+            this->setRateControl(bitrate);
+            if(m_encoder && x264_encoder_reconfig(m_encoder, &m_params) < 0) {
+                DLog("x264::H264Encode: could not change the bitrate to %d\n", bitrate);
+            }
+        });
+    }
+    bool
+    H264Encode::setVideoFormat(int width, int height, int fps)
+    {
+        // x264 can't change the frame size of an open encoder, so it is replaced.  The new encoder starts with
+        // an IDR frame and new parameter sets, which H264Packetizer turns into a new sequence header.
+        m_encodeQueue.enqueue([=]() {
+            if(width == m_params.i_width && height == m_params.i_height && fps == int(m_params.i_fps_num)) {
+                return;
+            }
+            if(m_encoder) {
+                x264_encoder_close(m_encoder);
+                m_encoder = nullptr;
+            }
+            m_params.i_width = width;
+            m_params.i_height = height;
+            m_params.i_fps_num = fps;
+            m_params.i_keyint_max = fps * 2;
+            this->setRateControl(m_bitrate);
+
+            openEncoder();
+        });
+        return true;
+    }
+}
+}
@@ -0,0 +1,158 @@
+/*
+
+ Video Core
+ Copyright (c) 2014 James G. Hurley
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+
+ */
+
+
+/*
+ *  x264::H264Encode transform :: Takes 4:2:0 YUV IPixelBuffers (I420 or NV12) and outputs H.264 using libx264.
+ *  Portable counterpart of Apple::H264Encode for platforms without VideoToolbox.
+ *
+ */
+
+
+#ifndef __videocore__x264H264Encode__
+#define __videocore__x264H264Encode__
+
+#include <videocore/transforms/IEncoder.hpp>
+#include <videocore/system/JobQueue.hpp>
+#include <videocore/system/pixelBuffer/IPixelBuffer.hpp>
+
+#include <stdint.h>
+extern "C" {
+#include <x264.h>
+}
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace videocore { namespace x264 {
+
+    /*!
+     *  Output follows Apple::H264Encode, so H264Packetizer works unchanged: the SPS and the PPS are each pushed
+     *  as a 4-byte length-prefixed NAL before every keyframe, then each frame is pushed as its slice NALs with
+     *  4-byte big-endian length prefixes, with VideoBufferMetadata(pts, dts) in milliseconds.
+     *
+     *  The encoder is tuned for zero latency: no B-frames or lookahead, and slice threading so that a frame is
+     *  out as soon as it is encoded.  Frames flagged with kVideoFrameMetadataUnchanged are, after the first few,
+     *  encoded as P-frames at the highest quantizer, which makes them all skip blocks.
+     *
+     *  With slice output enabled each slice is pushed on its own, with EncodedSliceMetadata, as soon as the
+     *  slice thread that coded it finishes.  H264Packetizer gathers the slices and still pushes one FLV tag per
+     *  frame: RTMP puts the message length in the first chunk header, so nothing of a frame is sent before its
+     *  last slice is coded.  All this saves is gathering the frame after the encode.
+     */
+    class H264Encode : public IEncoder
+    {
+    public:
+
+        /*!
+         *  \param frame_w      The width of the input and output.
+         *  \param frame_h      The height of the input and output.
+         *  \param fps          The nominal frame rate.  Input timestamps are honoured, so frames may be dropped.
+         *  \param bitrate      The target bitrate in bits per second.
+         *  \param useBaseline  true for Baseline profile, false for Main (CABAC).
+         *  \param threadCount  The number of slice threads.  0 picks one per core.
+         *  \param sliceOutput  true to push each slice as it is coded rather than whole frames.  Frames are then coded
+         *                      as 4 slices, which costs some compression.
+         */
+        H264Encode(int frame_w, int frame_h, int fps, int bitrate, bool useBaseline = true, int threadCount = 0, bool sliceOutput = false);
+
+        ~H264Encode();
+
+        /*! ITransform::setOutput */
+        void setOutput(std::shared_ptr<IOutput> output) { m_output = output; };
+
+        /*! IOutput::queuedDuration.  Frames waiting for the encoder are not counted: there are at most two. */
+        double queuedDuration() { auto output = m_output.lock(); return output ? output->queuedDuration() : 0.; };
+
+        /*!
+         *  Input is a pointer to a std::shared_ptr<IPixelBuffer> in kVCPixelBufferFormatI420, '420f' or '420v'.
+         *  The buffer is retained and encoded on the encoder's own queue; the caller is not blocked.  If the
+         *  encoder falls behind, or more than kMaxQueuedDuration is queued downstream, incoming frames are dropped
+         *  rather than queued.
+         */
+        void pushBuffer(const uint8_t* const data, size_t size, IMetadata& metadata);
+
+        /*! IEncoder::setBitrate.  Applies from the next frame encoded. */
+        void setBitrate(int bitrate);
+
+        /*! IEncoder::bitrate */
+        const int bitrate() const { return m_bitrate; };
+
+        /*! IEncoder::requestKeyframe */
+        void requestKeyframe() { m_forceKeyframe = true; };
+
+        /*!
+         *  IEncoder::setVideoFormat.  The encoder is reopened on its queue, so frames pushed after this call are
+         *  encoded at the new format.  Frames that are not the new size are dropped: resize them upstream.
+         */
+        bool setVideoFormat(int width, int height, int fps);
+
+    private:
+        /*! Open m_encoder from m_params and keep its parameter sets. */
+        void openEncoder();
+
+        /*! Encode one frame and push the result.  Runs on m_encodeQueue. */
+        void encode(IPixelBuffer& buffer, double pts, bool unchanged);
+
+        /*! Set the rate control fields of m_params for a bitrate. */
+        void setRateControl(int bitrate);
+
+        /*! x264's nalu_process callback.  Called on the slice threads, in any order, as each NAL is coded. */
+        static void sliceCallback(x264_t* h, x264_nal_t* nal, void* opaque);
+
+        /*! Queue a coded slice and push every slice that is now next in frame order. */
+        void pushSlice(x264_t* h, x264_nal_t* nal);
+
+    private:
+
+        JobQueue                m_encodeQueue;
+
+        x264_t*                 m_encoder;     /* encode queue only once constructed */
+        x264_param_t            m_params;      /* encode queue only once the encoder is open */
+        std::weak_ptr<IOutput>  m_output;
+
+        std::vector<uint8_t>    m_sps;         /* length-prefixed, as pushed */
+        std::vector<uint8_t>    m_pps;
+        std::vector<uint8_t>    m_frame;       /* encode queue only */
+
+        int                     m_unchangedFrames;   /* encode queue only */
+
+        std::mutex              m_sliceMutex;
+        std::map<int, std::pair<int, std::vector<uint8_t>>> m_slices;  /* first macroblock -> (last macroblock, slice) of
+                                                                  coded slices waiting for their predecessors */
+        int                     m_nextSliceMb;
+        int                     m_frameMbs;
+        double                  m_slicePts;          /* pts of the frame being encoded */
+
+        std::atomic<int>        m_pendingFrames;
+        std::atomic<int>        m_bitrate;
+        std::atomic<bool>       m_forceKeyframe;
+    };
+
+}
+}
+#endif /* defined(__videocore__x264H264Encode__) */